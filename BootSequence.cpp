@@ -0,0 +1,117 @@
+#include "BootSequence.h"
+
+struct BootRecord {
+  uint32_t startMs;
+  uint32_t endMs;
+  int8_t   core;    // where it ran
+  bool     ok;
+};
+
+static const BootStep* s_steps = NULL;
+static uint8_t         s_count = 0;
+static BootRecord      s_records[BOOT_MAX_STEPS];
+static uint16_t        s_started = 0;       // guarded by halCritical
+static uint16_t        s_done = 0;          // guarded by halCritical
+static uint16_t        s_failed = 0;
+static HalSemaphore    s_stepDone = NULL;   // a helper task finished
+static uint32_t        s_readyMs = 0;
+
+static void runStep(uint8_t i) {
+  BootRecord& r = s_records[i];
+  r.core = (int8_t)halCoreId();
+  r.ok = s_steps[i].run();
+  r.endMs = halMillis();
+  halCriticalEnter();
+  s_done |= BOOT_AFTER(i);
+  if (!r.ok) s_failed |= BOOT_AFTER(i);
+  halCriticalExit();
+}
+
+static void bootWorker(void* arg);
+
+// Claims the ready helper-task steps and starts them. Called by the runner
+// and by each helper as it finishes, so a chain of helpers keeps going
+// while the caller is busy with an inline step. Returns the first ready
+// inline step (unclaimed), or -1.
+static int launchReady() {
+  int inlineReady = -1;
+  for (uint8_t i = 0; i < s_count; i++) {
+    const BootStep& st = s_steps[i];
+    halCriticalEnter();
+    bool ready = !(s_started & BOOT_AFTER(i)) && !(st.after & ~s_done);
+    bool claim = ready && st.core != BOOT_IN_CALLER;
+    if (claim) s_started |= BOOT_AFTER(i);
+    halCriticalExit();
+    if (!claim) {
+      if (ready && inlineReady < 0) inlineReady = i;
+      continue;
+    }
+    s_records[i].startMs = halMillis();
+    if (!halTaskCreate(bootWorker, st.name, BOOT_TASK_STACK,
+                       (void*)(uintptr_t)i, 1, st.core)) {
+      runStep(i);   // no task: run it here instead
+    }
+  }
+  return inlineReady;
+}
+
+static void bootWorker(void* arg) {
+  runStep((uint8_t)(uintptr_t)arg);
+  launchReady();
+  halSemGive(s_stepDone);
+  halTaskExit();
+}
+
+uint16_t bootRun(const BootStep* steps, uint8_t count) {
+  if (count > BOOT_MAX_STEPS) count = BOOT_MAX_STEPS;
+  s_steps = steps;
+  s_count = count;
+  s_done = s_started = s_failed = 0;
+  if (!s_stepDone) s_stepDone = halSemCreateBinary();
+
+  const uint16_t all = (uint16_t)((1u << count) - 1);
+  for (;;) {
+    int i = launchReady();
+    if (i >= 0) {
+      halCriticalEnter();
+      s_started |= BOOT_AFTER(i);
+      halCriticalExit();
+      s_records[i].startMs = halMillis();
+      runStep((uint8_t)i);
+      continue;
+    }
+
+    halCriticalEnter();
+    uint16_t done = s_done, running = s_started & ~s_done;
+    halCriticalExit();
+    if (done == all) break;
+    if (!running) {
+      // Nothing running and nothing ready: a dependency names a missing
+      // step or a cycle
+      Serial.println("ERROR: boot table has unsatisfiable dependencies");
+      break;
+    }
+    halSemTake(s_stepDone, HAL_WAIT_FOREVER);
+  }
+  return s_failed;
+}
+
+void bootReady() { s_readyMs = halMillis(); }
+
+uint32_t bootReadyMs() { return s_readyMs; }
+
+void bootPrint() {
+  Serial.println("---BOOT_START---");
+  Serial.println("step,core,start_ms,end_ms,ms,ok");
+  for (uint8_t i = 0; i < s_count; i++) {
+    const BootRecord& r = s_records[i];
+    Serial.print(s_steps[i].name); Serial.print(',');
+    Serial.print(r.core);          Serial.print(',');
+    Serial.print(r.startMs);       Serial.print(',');
+    Serial.print(r.endMs);         Serial.print(',');
+    Serial.print(r.endMs - r.startMs); Serial.print(',');
+    Serial.println(r.ok ? 1 : 0);
+  }
+  Serial.print("ready_ms,"); Serial.println(s_readyMs);
+  Serial.println("---BOOT_END---");
+}
@@ -0,0 +1,41 @@
+#ifndef BOOT_SEQUENCE_H
+#define BOOT_SEQUENCE_H
+
+#include "Hal.h"
+
+// ---------------------------------------------------------------------------
+// Boot dependency graph
+// ---------------------------------------------------------------------------
+// setup() describes boot as a table of steps, each naming the steps that
+// must finish before it starts. bootRun() starts every step as soon as its
+// dependencies are done: a step with a core runs in a short-lived task of
+// its own on that core, a BOOT_IN_CALLER step runs in the caller (one at a
+// time, in table order) while the helper tasks carry on. A failed step
+// does not hold back its dependents; like the old serial boot, the tester
+// continues with whatever came up.
+//
+// Each step's start and end time is kept. The sketch calls bootReady() once
+// it can take a test; bootPrint() reports the timeline and the
+// boot-to-ready time (halMillis() since power-on).
+
+#define BOOT_MAX_STEPS   16
+#define BOOT_IN_CALLER   -1
+#define BOOT_TASK_STACK  8192
+
+#define BOOT_AFTER(i) ((uint16_t)(1u << (i)))
+
+struct BootStep {
+  const char* name;
+  bool      (*run)();   // false: failed (reported, dependents still run)
+  uint16_t    after;    // BOOT_AFTER(i) | ...: steps that must finish first
+  int8_t      core;     // BOOT_IN_CALLER, or the core of a helper task
+};
+
+// Runs the table to completion. Returns the mask of failed steps.
+uint16_t bootRun(const BootStep* steps, uint8_t count);
+
+void     bootReady();
+uint32_t bootReadyMs();   // 0 until bootReady()
+void     bootPrint();
+
+#endif // BOOT_SEQUENCE_H
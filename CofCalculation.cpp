@@ -1,25 +1,47 @@
 #include "CofCalculation.h"
-#include <stdlib.h>
 #include <math.h>
 
 // ---------------------------------------------------------------------------
 // Internal helpers
 // ---------------------------------------------------------------------------
 
-static int compareFloats(const void* a, const void* b) {
-  float fa = *(const float*)a;
-  float fb = *(const float*)b;
-  if (fa < fb) return -1;
-  if (fa > fb) return  1;
-  return 0;
+// Scratch space: paired friction values, and the sorted copy used by
+// avgPercentileBand (whose input is usually s_paired)
+static float s_paired[COF_MAX_SAMPLES];
+static float s_sorted[COF_MAX_SAMPLES];
+static long  s_pairedCount = 0;  // valid entries of s_paired, for the plots
+
+// In-place ascending heapsort. Unlike qsort() it never allocates (glibc's
+// qsort mallocs a merge buffer for arrays over 1 KB) and has no comparator
+// call per comparison.
+static void siftDown(float* v, long root, long end) {
+  float x = v[root];
+  long child;
+  while ((child = 2 * root + 1) < end) {
+    if (child + 1 < end && v[child + 1] > v[child]) child++;
+    if (!(v[child] > x)) break;
+    v[root] = v[child];
+    root = child;
+  }
+  v[root] = x;
+}
+
+static void sortFloats(float* v, long n) {
+  for (long i = n / 2 - 1; i >= 0; i--) siftDown(v, i, n);
+  for (long end = n - 1; end > 0; end--) {
+    float t = v[0]; v[0] = v[end]; v[end] = t;
+    siftDown(v, 0, end);
+  }
 }
 
-// Compute trim offsets and pair count from raw counts + trim fraction.
-// Writes back through out-pointers; returns false if no valid pairs remain.
-static bool computeTrimParams(long fwdCount, long revCount,
-                              float trimFraction,
-                              long* fwdStart, long* revStart,
-                              long* pairedCount) {
+// ---------------------------------------------------------------------------
+// Trim & pairing
+// ---------------------------------------------------------------------------
+
+bool computeTrimParams(long fwdCount, long revCount,
+                       float trimFraction,
+                       long* fwdStart, long* revStart,
+                       long* pairedCount) {
   long fwdTrim = (long)(fwdCount * trimFraction);
   long revTrim = (long)(revCount * trimFraction);
 
@@ -46,13 +68,13 @@ double avgPercentileBand(const float* samples, long count) {
   }
 
   // Need a mutable copy for sorting
-  float* sorted = (float*)malloc(count * sizeof(float));
-  if (!sorted) {
-    Serial.println("ERROR: avgPercentileBand malloc failed");
+  if (count > COF_MAX_SAMPLES) {
+    Serial.println("ERROR: avgPercentileBand input exceeds COF_MAX_SAMPLES");
     return 0.0;
   }
+  float* sorted = s_sorted;
   memcpy(sorted, samples, count * sizeof(float));
-  qsort(sorted, count, sizeof(float), compareFloats);
+  sortFloats(sorted, count);
 
   long idx85 = (long)(count * 0.85);
   long idx95 = (long)(count * 0.95);
@@ -65,7 +87,6 @@ double avgPercentileBand(const float* samples, long count) {
     sum += sorted[i];
   }
 
-  free(sorted);
   return (rangeCount > 0) ? (sum / (double)rangeCount) : 0.0;
 }
 
@@ -122,11 +143,12 @@ CofResult calculateCOF(const float* fwdSamples, long fwdCount,
   }
 
   // --- Build paired friction array -----------------------------------------
-  float* pairedFriction = (float*)malloc(pairCount * sizeof(float));
-  if (!pairedFriction) {
-    Serial.println("ERROR: calculateCOF malloc failed");
+  if (pairCount > COF_MAX_SAMPLES) {
+    Serial.println("ERROR: calculateCOF input exceeds COF_MAX_SAMPLES");
     return result;
   }
+  float* pairedFriction = s_paired;
+  s_pairedCount = 0;
 
   double biasSum = 0.0;
 
@@ -138,9 +160,10 @@ CofResult calculateCOF(const float* fwdSamples, long fwdCount,
     biasSum += (fwd + rev) / 2.0;
   }
 
+  s_pairedCount = pairCount;
+
   // --- Apply averaging strategy --------------------------------------------
   double avgForce = avgFn(pairedFriction, pairCount);
-  free(pairedFriction);
 
   // --- Assemble result -----------------------------------------------------
   result.avgForceLb  = (float)avgForce;
@@ -151,6 +174,50 @@ CofResult calculateCOF(const float* fwdSamples, long fwdCount,
   return result;
 }
 
+// ---------------------------------------------------------------------------
+// Result plots
+// ---------------------------------------------------------------------------
+
+const float* cofLastPaired(long* count) {
+  *count = s_pairedCount;
+  return s_pairedCount ? s_paired : NULL;
+}
+
+void decimateMinMax(const float* values, long n, int cols,
+                    float* colMin, float* colMax) {
+  for (int c = 0; c < cols; c++) {
+    if (n <= 0) {
+      colMin[c] = colMax[c] = 0.0f;
+      continue;
+    }
+    long start = (long)c * n / cols;
+    long end   = (long)(c + 1) * n / cols;
+    if (end <= start) end = start + 1;
+    float lo = values[start], hi = lo;
+    for (long i = start + 1; i < end; i++) {
+      float v = values[i];
+      if (v < lo) lo = v;
+      if (v > hi) hi = v;
+    }
+    colMin[c] = lo;
+    colMax[c] = hi;
+  }
+}
+
+uint16_t histogramBins(const float* values, long n, float lo, float hi,
+                       uint16_t* counts, int bins) {
+  for (int b = 0; b < bins; b++) counts[b] = 0;
+  float scale = (hi > lo) ? (float)bins / (hi - lo) : 0.0f;
+  uint16_t peak = 0;
+  for (long i = 0; i < n; i++) {
+    float x = (values[i] - lo) * scale;
+    int b = (x <= 0.0f) ? 0 : (x >= (float)(bins - 1)) ? bins - 1 : (int)x;
+    if (counts[b] < 0xFFFF) counts[b]++;
+    if (counts[b] > peak) peak = counts[b];
+  }
+  return peak;
+}
+
 // ---------------------------------------------------------------------------
 // Diagnostic paired-data CSV dump
 // ---------------------------------------------------------------------------
@@ -11,6 +11,17 @@
 // Output: a single representative average value.
 typedef double (*AveragingFn)(const float* samples, long count);
 
+// ---------------------------------------------------------------------------
+// Capacity
+// ---------------------------------------------------------------------------
+// Scratch buffers are static (no heap use during a test cycle), so inputs are
+// limited to COF_MAX_SAMPLES per pass; larger inputs are rejected with an
+// error. Matches MAX_SAMPLES_PER_PASS in the sketch. Not reentrant: call from
+// one task only.
+#ifndef COF_MAX_SAMPLES
+#define COF_MAX_SAMPLES 3200
+#endif
+
 // ---------------------------------------------------------------------------
 // Result of a COF calculation
 // ---------------------------------------------------------------------------
@@ -37,6 +48,14 @@ CofResult calculateCOF(const float* fwdSamples, long fwdCount,
                         float trimFraction,
                         AveragingFn avgFn);
 
+// Trim offsets and pair count calculateCOF() uses: pair i is
+// fwd[fwdStart + i] with rev[revStart + pairedCount - 1 - i]. Returns false
+// if no valid pairs remain after trimming.
+bool computeTrimParams(long fwdCount, long revCount,
+                       float trimFraction,
+                       long* fwdStart, long* revStart,
+                       long* pairedCount);
+
 // ---------------------------------------------------------------------------
 // Built-in averaging strategies
 // ---------------------------------------------------------------------------
@@ -47,6 +66,26 @@ double avgPercentileBand(const float* samples, long count);
 // Average only values within one standard deviation of the mean.
 double avgWithinOneStdDev(const float* samples, long count);
 
+// ---------------------------------------------------------------------------
+// Result plots
+// ---------------------------------------------------------------------------
+
+// Paired friction values (lb, in position order) from the last successful
+// calculateCOF() call, or NULL with *count = 0 if there is none. Valid until
+// the next call.
+const float* cofLastPaired(long* count);
+
+// Min/max decimation onto cols columns in one pass: column c covers values
+// [c*n/cols, (c+1)*n/cols), or the single value at c*n/cols when n < cols,
+// so a one-sample spike always survives. n == 0 fills zeros.
+void decimateMinMax(const float* values, long n, int cols,
+                    float* colMin, float* colMax);
+
+// Counts values into bins equal-width bins over [lo, hi]; values outside
+// the range land in the end bins. Returns the largest bin count.
+uint16_t histogramBins(const float* values, long n, float lo, float hi,
+                       uint16_t* counts, int bins);
+
 // ---------------------------------------------------------------------------
 // Diagnostic CSV dump
 // ---------------------------------------------------------------------------
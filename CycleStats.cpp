@@ -0,0 +1,150 @@
+#include "CycleStats.h"
+
+static const char* const STAGE_NAMES[STAGE_COUNT] = {
+  "home_start",
+  "lower",
+  "measure_fwd",
+  "pause",
+  "measure_rev",
+  "return",
+  "home_end",
+  "compute",
+  "done_led",
+  "csv_dump",
+  "nfc",
+};
+
+static CycleRecord s_history[CYCLE_HISTORY];
+static int         s_count = 0;       // valid records (saturates at CYCLE_HISTORY)
+static int         s_next  = 0;       // ring write index
+
+static CycleRecord s_current;
+static uint32_t    s_marked  = 0;     // stages of s_current marked so far
+static bool        s_active  = false;
+static uint32_t    s_startMs = 0;
+static uint32_t    s_markMs  = 0;
+
+// ---------------------------------------------------------------------------
+// Recording
+// ---------------------------------------------------------------------------
+
+void cycleBegin() {
+  memset(&s_current, 0, sizeof(s_current));
+  s_marked  = 0;
+  s_startMs = s_markMs = halMillis();
+  s_active  = true;
+}
+
+void cycleMark(CycleStage stage) {
+  if (!s_active) return;
+  uint32_t now = halMillis();
+  s_current.stageMs[stage] += now - s_markMs;
+  s_marked |= 1UL << stage;
+  s_markMs = now;
+}
+
+void cycleAbort() {
+  s_active = false;
+}
+
+void cycleEnd() {
+  if (!s_active) return;
+  s_current.totalMs = halMillis() - s_startMs;
+  s_history[s_next] = s_current;
+  s_next = (s_next + 1) % CYCLE_HISTORY;
+  if (s_count < CYCLE_HISTORY) s_count++;
+  s_active = false;
+}
+
+const CycleRecord* cycleLast() {
+  if (s_count == 0) return NULL;
+  return &s_history[(s_next + CYCLE_HISTORY - 1) % CYCLE_HISTORY];
+}
+
+int cycleCount() { return s_count; }
+
+// ---------------------------------------------------------------------------
+// Reporting
+// ---------------------------------------------------------------------------
+
+// Nearest-rank percentile of a sorted array
+static uint32_t percentile(const uint32_t* sorted, int n, int pct) {
+  int rank = (pct * n + 99) / 100;   // ceil(pct/100 * n)
+  if (rank < 1) rank = 1;
+  return sorted[rank - 1];
+}
+
+static void sortAscending(uint32_t* v, int n) {
+  for (int i = 1; i < n; i++) {
+    uint32_t x = v[i];
+    int j = i - 1;
+    while (j >= 0 && v[j] > x) { v[j + 1] = v[j]; j--; }
+    v[j + 1] = x;
+  }
+}
+
+void cyclePrintLast() {
+  const CycleRecord* r = cycleLast();
+  if (!r) return;
+  Serial.print("Cycle time: ");
+  Serial.print(r->totalMs);
+  Serial.print(" ms (");
+  for (int s = 0; s < STAGE_COUNT; s++) {
+    if (s > 0) Serial.print(' ');
+    Serial.print(STAGE_NAMES[s]);
+    Serial.print('=');
+    Serial.print(r->stageMs[s]);
+  }
+  Serial.println(")");
+}
+
+// The run's own record, written with its CSV dump: the stages finished so
+// far and the time since START (the dump and NFC stages come after it)
+void cyclePrintRunCsv() {
+  if (!s_active) return;
+  Serial.println("---CYCLE_START---");
+  Serial.println("stage,ms");
+  for (int s = 0; s < STAGE_COUNT; s++) {
+    if (!(s_marked & (1UL << s))) continue;
+    Serial.print(STAGE_NAMES[s]);
+    Serial.print(',');
+    Serial.println(s_current.stageMs[s]);
+  }
+  Serial.print("elapsed,");
+  Serial.println(halMillis() - s_startMs);
+  Serial.println("---CYCLE_END---");
+}
+
+void cycleStatsPrint() {
+  uint32_t v[CYCLE_HISTORY];
+  uint64_t grandTotal = 0;
+  for (int i = 0; i < s_count; i++) grandTotal += s_history[i].totalMs;
+
+  Serial.println("---CYCLE_STATS_START---");
+  Serial.print("runs,");
+  Serial.println(s_count);
+  Serial.println("stage,last_ms,p50_ms,p95_ms,max_ms,share_pct");
+
+  const CycleRecord* last = cycleLast();
+  for (int s = 0; s <= STAGE_COUNT; s++) {
+    uint64_t sum = 0;
+    for (int i = 0; i < s_count; i++) {
+      v[i] = (s < STAGE_COUNT) ? s_history[i].stageMs[s] : s_history[i].totalMs;
+      sum += v[i];
+    }
+    sortAscending(v, s_count);
+
+    Serial.print((s < STAGE_COUNT) ? STAGE_NAMES[s] : "total");
+    Serial.print(',');
+    Serial.print(last ? ((s < STAGE_COUNT) ? last->stageMs[s] : last->totalMs) : 0UL);
+    Serial.print(',');
+    Serial.print(s_count ? percentile(v, s_count, 50) : 0UL);
+    Serial.print(',');
+    Serial.print(s_count ? percentile(v, s_count, 95) : 0UL);
+    Serial.print(',');
+    Serial.print(s_count ? v[s_count - 1] : 0UL);
+    Serial.print(',');
+    Serial.println(grandTotal ? 100.0 * (double)sum / (double)grandTotal : 0.0, 1);
+  }
+  Serial.println("---CYCLE_STATS_END---");
+}
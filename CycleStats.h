@@ -0,0 +1,48 @@
+#ifndef CYCLE_STATS_H
+#define CYCLE_STATS_H
+
+#include "Hal.h"
+
+// ---------------------------------------------------------------------------
+// Test cycle-time breakdown
+// ---------------------------------------------------------------------------
+// A test cycle runs from the START press to the end of the NFC step. The
+// sketch calls cycleMark() as each stage finishes; the time since the
+// previous mark is charged to that stage. Completed cycles go into a ring
+// of the most recent CYCLE_HISTORY records for p50/p95 reporting.
+
+#define CYCLE_HISTORY 32
+
+enum CycleStage {
+  STAGE_HOME_START,    // homing before the test
+  STAGE_LOWER,         // lowering move (plus enable)
+  STAGE_MEASURE_FWD,   // forward measurement pass
+  STAGE_PAUSE,         // pause between passes
+  STAGE_MEASURE_REV,   // reverse measurement pass
+  STAGE_RETURN,        // return move
+  STAGE_HOME_END,      // homing after the test (plus disable)
+  STAGE_COMPUTE,       // COF calculation and serial report
+  STAGE_DONE_LED,      // "test complete" LED pulses
+  STAGE_CSV_DUMP,      // raw + paired CSV dump
+  STAGE_NFC,           // results screen, tag wait and write feedback
+  STAGE_COUNT
+};
+
+struct CycleRecord {
+  uint32_t stageMs[STAGE_COUNT];
+  uint32_t totalMs;
+};
+
+void cycleBegin();                   // START pressed
+void cycleMark(CycleStage stage);    // stage just finished
+void cycleAbort();                   // discard the cycle in progress
+void cycleEnd();                     // commit the cycle to the history
+
+const CycleRecord* cycleLast();      // most recent committed cycle, or NULL
+int  cycleCount();                   // committed cycles in the history
+
+void cyclePrintLast();               // one-line breakdown of the last cycle
+void cyclePrintRunCsv();             // stages of the cycle in progress, for the run's CSV
+void cycleStatsPrint();              // p50/p95 table over the history
+
+#endif // CYCLE_STATS_H
@@ -0,0 +1,231 @@
+#include "DisplayTask.h"
+
+#if DISPLAY_TASK_ENABLED
+
+#include "Profiler.h"
+#include "Trace.h"
+
+static const uint32_t FRAME_MS = 1000 / DISPLAY_MAX_FPS;
+
+// Three frame buffers change hands by pointer under the lock, so the 1 KB
+// copies run outside it: the presenter copies into s_fill and swaps it with
+// s_pending; the flusher swaps s_pending with s_work
+static uint8_t       s_frames[3][DISPLAY_BYTES];
+static uint8_t*      s_fill = s_frames[0];      // presenter's next frame
+static uint8_t*      s_pending = s_frames[1];   // latest presented frame
+static uint8_t*      s_work = s_frames[2];      // frame being flushed
+static uint8_t       s_panel[DISPLAY_BYTES];    // what the panel shows
+static bool          s_panelValid = false;      // GDDRAM is random at power-up
+static bool          s_dirty = false;           // s_pending not flushed yet
+static bool          s_invalidate = false;      // next flush rewrites every page
+static bool          s_flushing = false;        // s_work is being written
+static bool          s_running = false;
+static HalSemaphore  s_wake = NULL;
+static uint32_t      s_lastFlushMs = 0;
+
+static DisplayStats  s_stats;
+static uint32_t      s_statsSinceMs = 0;
+
+// ---------------------------------------------------------------------------
+// Flush
+// ---------------------------------------------------------------------------
+
+// Splitting a rectangle costs another addressing transaction and data
+// header (10 bytes) plus two transactions' driver overhead; merging the
+// next page into it costs the unchanged columns the union re-sends
+static const int RECT_SPLIT_BYTES = 12;
+
+// Writes one rectangle and brings the panel mirror up to date
+static uint32_t writeRect(int p0, int p1, int c0, int c1) {
+  uint32_t bytes = halDisplayWriteRect((uint8_t)p0, (uint8_t)p1, (uint8_t)c0, (uint8_t)c1, s_work);
+  for (int p = p0; p <= p1; p++)
+    memcpy(s_panel + p * DISPLAY_COLS + c0, s_work + p * DISPLAY_COLS + c0, c1 - c0 + 1);
+  s_stats.rects++;
+  return bytes;
+}
+
+// Finds the changed column span of each page of the pending frame, merges
+// runs of adjacent changed pages into rectangles where that is cheaper on
+// the bus than writing them apart, and writes the rectangles. Only one
+// flusher at a time: the caller before the task starts, the task after.
+static void flushPending() {
+  halCriticalEnter();
+  if (!s_dirty && !s_invalidate) {
+    halCriticalExit();
+    return;
+  }
+  // An invalidate alone re-sends s_work, which still holds the latest frame
+  if (s_dirty) {
+    uint8_t* t = s_work;
+    s_work = s_pending;
+    s_pending = t;
+  }
+  s_dirty = false;
+  if (s_invalidate) s_panelValid = false;
+  s_invalidate = false;
+  s_flushing = true;
+  halCriticalExit();
+
+  PROF_SCOPE(PROF_DISPLAY_FLUSH);
+  TRACE_BEGIN(TR_DISPLAY_FLUSH, 0);
+#if PROFILING_ENABLED
+  uint32_t startCycles = halCycleCount();
+#endif
+  uint32_t t0 = halMicros();
+  uint32_t pages = 0;
+  uint32_t dataBytes = 0;
+  uint32_t bytes = 0;
+  int rp0 = -1, rp1 = 0, rc0 = 0, rc1 = 0;      // open rectangle
+  for (int p = 0; p < DISPLAY_PAGES; p++) {
+    const uint8_t* want = s_work + p * DISPLAY_COLS;
+    const uint8_t* have = s_panel + p * DISPLAY_COLS;
+    int c0 = 0, c1 = DISPLAY_COLS - 1;
+    if (s_panelValid) {
+      while (c0 < DISPLAY_COLS && want[c0] == have[c0]) c0++;
+      if (c0 == DISPLAY_COLS) continue;
+      while (want[c1] == have[c1]) c1--;
+    }
+    pages++;
+    if (rp0 >= 0 && p == rp1 + 1) {
+      int u0 = c0 < rc0 ? c0 : rc0;
+      int u1 = c1 > rc1 ? c1 : rc1;
+      int merged   = (p - rp0 + 1) * (u1 - u0 + 1);
+      int separate = (rp1 - rp0 + 1) * (rc1 - rc0 + 1) + (c1 - c0 + 1) + RECT_SPLIT_BYTES;
+      if (merged <= separate) {
+        rp1 = p;
+        rc0 = u0;
+        rc1 = u1;
+        continue;
+      }
+    }
+    if (rp0 >= 0) {
+      dataBytes += (rp1 - rp0 + 1) * (rc1 - rc0 + 1);
+      bytes += writeRect(rp0, rp1, rc0, rc1);
+    }
+    rp0 = rp1 = p;
+    rc0 = c0;
+    rc1 = c1;
+  }
+  if (rp0 >= 0) {
+    dataBytes += (rp1 - rp0 + 1) * (rc1 - rc0 + 1);
+    bytes += writeRect(rp0, rp1, rc0, rc1);
+  }
+  s_panelValid = true;
+  s_lastFlushMs = halMillis();
+  halCriticalEnter();
+  s_flushing = false;
+  halCriticalExit();
+
+  if (pages) {
+    s_stats.flushes++;
+    s_stats.pages += pages;
+    s_stats.busBytes += bytes;
+    s_stats.busUs += halMicros() - t0;
+  }
+  if (dataBytes == DISPLAY_BYTES) {
+    s_stats.fullFrames++;
+    s_stats.fullFrameUs = halMicros() - t0;
+#if PROFILING_ENABLED
+    profilerRecord(PROF_DISPLAY_FULL_FRAME, halCycleCount() - startCycles);
+#endif
+  }
+  TRACE_END(TR_DISPLAY_FLUSH, pages);
+}
+
+static void displayTask(void*) {
+  for (;;) {
+    halSemTake(s_wake, HAL_WAIT_FOREVER);
+    uint32_t since = halMillis() - s_lastFlushMs;
+    if (since < FRAME_MS) halTaskDelayMs(FRAME_MS - since);  // frame-rate cap
+    flushPending();
+  }
+}
+
+// ---------------------------------------------------------------------------
+// API
+// ---------------------------------------------------------------------------
+
+bool displayTaskStart(int core, int priority) {
+  s_wake = halSemCreateBinary();
+  if (!s_wake) return false;
+  s_running = halTaskCreate(displayTask, "Display", 3072, NULL, priority, core);
+  if (s_running && (s_dirty || s_invalidate)) halSemGive(s_wake);
+  return s_running;
+}
+
+void displayPresent(const uint8_t* frame) {
+  uint32_t t0 = halMicros();
+  memcpy(s_fill, frame, DISPLAY_BYTES);      // only the presenter touches s_fill
+  halCriticalEnter();
+  uint8_t* t = s_pending;
+  s_pending = s_fill;
+  s_fill = t;
+  bool replaced = s_dirty;
+  s_dirty = true;
+  halCriticalExit();
+
+  if (s_running) halSemGive(s_wake);
+  else           flushPending();
+
+  s_stats.presents++;
+  if (replaced) s_stats.coalesced++;
+  s_stats.presentUs += halMicros() - t0;
+}
+
+void displayInvalidate() {
+  halCriticalEnter();
+  s_invalidate = true;
+  halCriticalExit();
+  if (s_running) halSemGive(s_wake);
+  else           flushPending();
+}
+
+bool displayIdle() {
+  halCriticalEnter();
+  bool idle = !s_dirty && !s_invalidate && !s_flushing;
+  halCriticalExit();
+  return idle;
+}
+
+DisplayStats displayStats() { return s_stats; }
+
+void displayStatsReset() {
+  memset(&s_stats, 0, sizeof(s_stats));
+  s_statsSinceMs = halMillis();
+}
+
+void displayStatsPrint() {
+  DisplayStats s = s_stats;
+  uint32_t windowMs = halMillis() - s_statsSinceMs;
+  uint64_t fullBytes = (uint64_t)s.presents * DISPLAY_FULL_FRAME_BUS_BYTES;
+
+  // What the same presents would have cost as synchronous full-frame
+  // display() calls, at the bus rate measured here
+  double usPerByte  = s.busBytes ? (double)s.busUs / (double)s.busBytes : 0.0;
+  double fullUs     = (double)fullBytes * usPerByte;
+  double savedMs    = (fullUs - (double)s.presentUs) / 1000.0;
+
+  Serial.println("---DISPLAY_STATS_START---");
+  Serial.print("window_ms,");        Serial.println(windowMs);
+  Serial.print("i2c_hz,");           Serial.println((unsigned long)halI2cClockHz());
+  Serial.print("presents,");         Serial.println(s.presents);
+  Serial.print("coalesced,");        Serial.println(s.coalesced);
+  Serial.print("flushes,");          Serial.println(s.flushes);
+  Serial.print("pages,");            Serial.println(s.pages);
+  Serial.print("rects,");            Serial.println(s.rects);
+  Serial.print("bus_bytes,");        Serial.println((unsigned long)s.busBytes);
+  Serial.print("bus_bytes_per_s,");
+  Serial.println(windowMs ? (double)s.busBytes * 1000.0 / windowMs : 0.0, 1);
+  Serial.print("bus_ms,");           Serial.println(s.busUs / 1000.0, 1);
+  Serial.print("full_frames,");      Serial.println(s.fullFrames);
+  Serial.print("full_frame_last_ms,"); Serial.println(s.fullFrameUs / 1000.0, 2);
+  Serial.print("full_frame_bytes,"); Serial.println((unsigned long)fullBytes);
+  Serial.print("bytes_saved_pct,");
+  Serial.println(fullBytes ? 100.0 * (1.0 - (double)s.busBytes / (double)fullBytes) : 0.0, 1);
+  Serial.print("present_avg_us,");
+  Serial.println(s.presents ? (double)s.presentUs / s.presents : 0.0, 1);
+  Serial.print("caller_ms_saved,");  Serial.println(savedMs, 1);
+  Serial.println("---DISPLAY_STATS_END---");
+}
+
+#endif // DISPLAY_TASK_ENABLED
@@ -0,0 +1,85 @@
+#ifndef DISPLAY_TASK_H
+#define DISPLAY_TASK_H
+
+#include "Hal.h"
+
+// ---------------------------------------------------------------------------
+// Display task: asynchronous, dirty-region OLED flushes
+// ---------------------------------------------------------------------------
+// The sketch keeps drawing into the HalDisplay framebuffer as before; a
+// flush no longer pushes 1 KB over the shared I2C bus from the caller.
+// displayPresent() copies the frame into a pending buffer and returns. The
+// display task owns a mirror of the panel's GDDRAM, diffs the pending frame
+// against it and writes only the changed column span of each changed page,
+// at most DISPLAY_MAX_FPS times a second. Adjacent changed pages go out as
+// one rectangle (one addressing transaction, one streamed data transaction)
+// when the columns they share outweigh the per-rectangle overhead; a
+// full-screen refresh is a single rectangle, timed by the profiler as
+// displayFullFrame. Frames presented faster than that
+// coalesce: only the latest reaches the panel.
+//
+// Until displayTaskStart() runs (early boot), presents flush synchronously
+// through the same diff.
+//
+// Build with -DDISPLAY_TASK_ENABLED=0 to go back to synchronous full-frame
+// display() calls.
+
+#ifndef DISPLAY_TASK_ENABLED
+#define DISPLAY_TASK_ENABLED 1
+#endif
+
+#ifndef DISPLAY_MAX_FPS
+#define DISPLAY_MAX_FPS 20
+#endif
+
+#define DISPLAY_COLS  128
+#define DISPLAY_PAGES 8                              // 8-pixel rows
+#define DISPLAY_BYTES (DISPLAY_COLS * DISPLAY_PAGES)
+
+// Bus bytes of one Adafruit_SSD1306::display() call (two command
+// transactions plus 1024 data bytes in 127-byte chunks): the baseline the
+// stats compare against
+#define DISPLAY_FULL_FRAME_BUS_BYTES 1052
+
+struct DisplayStats {
+  uint32_t presents;    // displayPresent() calls
+  uint32_t coalesced;   // presented frames replaced before reaching the panel
+  uint64_t presentUs;   // time callers spent in displayPresent()
+  uint32_t flushes;     // flushes that changed at least one page
+  uint32_t pages;       // changed pages written
+  uint32_t rects;       // rectangles (addressing transactions) they went out in
+  uint64_t busBytes;    // bytes on the bus, addressing and control included
+  uint64_t busUs;       // time spent writing them
+  uint32_t fullFrames;  // flushes that rewrote the whole screen
+  uint32_t fullFrameUs; // duration of the latest one
+};
+
+#if DISPLAY_TASK_ENABLED
+
+bool displayTaskStart(int core, int priority);
+void displayPresent(const uint8_t* frame);
+
+// Forgets what the panel shows and rewrites the last presented frame in
+// full, e.g. after the bus clock changed or the panel was reset
+void displayInvalidate();
+
+// True once the last presented frame is on the panel: nothing pending, no
+// flush in progress
+bool displayIdle();
+
+DisplayStats displayStats();
+void         displayStatsReset();
+void         displayStatsPrint();
+
+#else
+
+inline bool displayTaskStart(int, int) { return true; }
+inline void displayPresent(const uint8_t*) { halDisplay().display(); }
+inline void displayInvalidate() { halDisplay().display(); }
+inline bool displayIdle() { return true; }
+inline void displayStatsReset() {}
+inline void displayStatsPrint() { Serial.println("Display task disabled (DISPLAY_TASK_ENABLED=0)"); }
+
+#endif // DISPLAY_TASK_ENABLED
+
+#endif // DISPLAY_TASK_H
@@ -7,18 +7,28 @@
   - Limit switch -> INPUT_PULLUP, active-LOW, wire to GND (see PIN_LIMIT define)
   - Pin assignments vary by ESP32 variant - see USER CONFIG section below
   - On normal boot: homes to limit switch automatically if not already pressed
+  - All hardware access goes through Hal.h (HalEsp32.cpp on the device,
+    host/ for the Linux simulator build)
 */
 
 #include <Arduino.h>
-#include <Wire.h>
-#include <Adafruit_GFX.h>
-#include <Adafruit_SSD1306.h>
-#include <SparkFun_Qwiic_Scale_NAU7802_Arduino_Library.h>
-#include <Preferences.h>
-#include <Adafruit_NeoPixel.h>
-#include <PaddleDNA.h>
 #include <math.h>
+#include "Hal.h"
 #include "CofCalculation.h"
+#include "LoadCellCal.h"
+#include "Profiler.h"
+#include "Trace.h"
+#include "CycleStats.h"
+#include "IoRecorder.h"
+#include "DisplayTask.h"
+#include "I2cBus.h"
+#include "LedAnimator.h"
+#include "BootSequence.h"
+#include "TareTracker.h"
+#include "TempComp.h"
+#include "NfcWriter.h"
+#include "StaticScreens.h"
+#include "TextFormat.h"
 
 // ----------------------------- USER CONFIG ----------------------------------
 // NOTE: Pin assignments below match PCB schematic (ESP32-S3-ZERO)
@@ -27,6 +37,12 @@
 
 #define I2C_SDA 12     // Shared I2C bus (OLED + RFID)
 #define I2C_SCL 11     // Shared I2C bus (OLED + RFID)
+#ifndef NFC_IRQ_PIN
+#define NFC_IRQ_PIN HAL_NO_PIN  // RFID reader IRQ (active-LOW), if wired to a GPIO
+#endif
+#ifndef I2C_MAX_CLOCK_HZ
+#define I2C_MAX_CLOCK_HZ 400000   // probed down from here at boot; -DI2C_MAX_CLOCK_HZ=1000000 to overclock
+#endif
 
 #define OLED_WIDTH   128
 #define OLED_HEIGHT  64
@@ -72,8 +88,20 @@ const uint32_t LONG_PRESS_MS = 1200;
 const uint32_t ABORT_HOLD_MS = 3000;  // Hold START 3s during motion to abort
 
 const float CAL_WEIGHT_LB    = 2.883;   // calibration weight
+// Calibration weights, placed one at a time. The default is the one-weight
+// slope; 'l' switches to the multi-point list (saved), which should span
+// the forces a test sees and is what a quadratic fit needs.
+const float CAL_POINTS_LB[]       = { CAL_WEIGHT_LB };
+const float CAL_MULTI_POINTS_LB[] = { 0.5, 1.0, 2.0, CAL_WEIGHT_LB };
+#define CAL_NUM_POINTS       (uint8_t)(sizeof(CAL_POINTS_LB) / sizeof(CAL_POINTS_LB[0]))
+#define CAL_MULTI_NUM_POINTS (uint8_t)(sizeof(CAL_MULTI_POINTS_LB) / sizeof(CAL_MULTI_POINTS_LB[0]))
+static_assert(sizeof(CAL_POINTS_LB) / sizeof(CAL_POINTS_LB[0]) <= CAL_MAX_POINTS &&
+              sizeof(CAL_MULTI_POINTS_LB) / sizeof(CAL_MULTI_POINTS_LB[0]) <= CAL_MAX_POINTS,
+              "more calibration weights than LoadCellCal fits");
 const float NORMAL_FORCE_LB  = 2.59;  // test normal force
 const int HX_SAMPLES_TARE    = 20;      // averaging for tare
+const float TARE_MAX_SPREAD_LB = 0.05;  // idle tare window: interquartile range
+const float TARE_MAX_STEP_LB   = 0.5;   // idle tare: larger moves need confirming
 const int HX_SAMPLES_MEAS    = 5;       // (unused by non-blocking read)
 
 // Machine identification for PaddleDNA (update these for each machine)
@@ -98,17 +126,16 @@ const uint8_t PRIVATE_KEY[32] = {
 const uint32_t FIXED_TIMESTAMP = 1768176000;
 // ----------------------------------------------------------------------------
 
-Adafruit_SSD1306 oled(OLED_WIDTH, OLED_HEIGHT, &Wire);
-NAU7802 nau;
-Preferences prefs;
-Adafruit_NeoPixel rgbLed(1, RGB_LED_PIN, NEO_GRB + NEO_KHZ800);
+const HalConfig HAL_CONFIG = {
+  PIN_STEP, PIN_DIR, PIN_EN, PIN_LIMIT, BTN_START, RGB_LED_PIN,
+  I2C_SDA, I2C_SCL, NAU_SDA, NAU_SCL, OLED_ADDR, NFC_IRQ_PIN
+};
 
-// PaddleDNA components
-PaddleDNA::NFC nfc;
-PaddleDNA::Crypto crypto;
-PaddleDNA::MeasurementAccumulator* accumulator = nullptr;
+HalDisplay& oled = halDisplay();
 
 bool  g_hasResult = false;
+bool  g_resultShown = false;   // results screen up, its tag still awaited
+uint32_t g_testsRun = 0;
 float g_lastAvgLb = 0.0f;
 float g_lastCOF   = 0.0f;
 
@@ -148,25 +175,75 @@ volatile bool g_collectSamples = false;  // Signal Core 0 to sample
 volatile bool g_abortRequested = false;  // Abort flag (set by Core 1 button check)
 volatile uint32_t g_abortBtnDownAt = 0;  // Tracks when abort button was first pressed
 
-// Sample storage (Core 0 writes, Core 1 never touches)
-#define MAX_SAMPLES_PER_PASS 2000
+// Sample storage (Core 0 writes, Core 1 never touches). Raw readings while
+// the passes run; runTest() converts them to lb once both are done.
+// 3.0" pass at STEP_PULSE_US=150 takes ~9.1 s -> ~2920 samples at 320 SPS
+#define MAX_SAMPLES_PER_PASS 3200
+#if MAX_SAMPLES_PER_PASS > COF_MAX_SAMPLES
+#error "CofCalculation scratch buffers are smaller than a pass"
+#endif
 float g_fwdSamples[MAX_SAMPLES_PER_PASS];
 float g_revSamples[MAX_SAMPLES_PER_PASS];
 volatile long g_fwdSampleCount = 0;
 volatile long g_revSampleCount = 0;
 
+// Results screen plots: friction-vs-position sparkline across the bottom,
+// histogram of the paired friction values top right
+#define PLOT_SPARK_Y    48   // page 6; the histogram is pages 0-1, right half
+#define PLOT_SPARK_H    8
+#define PLOT_HIST_X     64
+#define PLOT_HIST_H     16
+#define PLOT_HIST_BINS  32   // 2 px per bin
+float    g_plotMin[OLED_WIDTH];
+float    g_plotMax[OLED_WIDTH];
+uint16_t g_plotBins[PLOT_HIST_BINS];
+
 // Inter-core communication
-QueueHandle_t motionCommandQueue = NULL;
-SemaphoreHandle_t motionCompleteSemaphore = NULL;
-TaskHandle_t forceSamplingTaskHandle = NULL;
+HalQueue motionCommandQueue = NULL;
+HalSemaphore motionCompleteSemaphore = NULL;
 // ============================================================================
 
 const char* PREFS_NAMESPACE = "cof";
 const char* KEY_CAL         = "calib";
 const char* KEY_TARE        = "tare";
+const char* KEY_TAG_FIRST   = "tagFirst";
+const char* KEY_PER_PADDLE  = "perPaddle";
+const char* KEY_CAL_CURVE   = "calCurve";
+const char* KEY_CAL_ORDER   = "calOrder";
+const char* KEY_CAL_MULTI   = "calMulti";
+const char* KEY_CAL_POINTS  = "calPoints";
+const char* KEY_CAL_RMS     = "calRms";
+const char* KEY_CAL_MAX     = "calMax";
+const char* KEY_TC_REF      = "tcRef";
+const char* KEY_TC_OFFSET   = "tcOffset";
+const char* KEY_TC_GAIN     = "tcGain";
+const char* KEY_TC_FITTED   = "tcFitted";   // check points behind tcOffset/tcGain
+const char* KEY_TC_COUNT    = "tcCount";    // history below, the calibration first
+// History per point i: "tcT<i>" °C, "tcZ<i>" tare, "tcG<i>" gain
 
 float g_calibration = 1000.0f; // counts per lb
+float g_calCurve    = 0.0f;    // lb per count^2 (LoadCellCal.h); 0 when linear
 long  g_tareRaw     = 0;       // tare offset (raw counts)
+uint8_t g_calOrder  = 1;       // fit for the next calibration: 1 linear, 2 quadratic
+bool    g_calMulti  = false;   // next calibration: CAL_MULTI_POINTS_LB, else CAL_POINTS_LB
+uint8_t g_calPoints = 0;       // weights in the stored fit; 0 before the first
+float g_calRmsLb    = 0.0f;    // its residuals at those weights
+float g_calMaxLb    = 0.0f;
+long  g_calTareRaw  = 0;       // tare at the last calibration
+
+// Temperature compensation (TempComp.h). g_gainComp is taken at START and
+// holds for the whole test, so both passes convert alike.
+TempModel g_tempModel = { 25.0f, 0.0f, 0.0f, 0 };
+TempPoint g_tempPoints[TEMP_MAX_POINTS];
+uint8_t   g_tempPointCount = 0;
+float     g_gainComp = 1.0f;
+bool      g_tempCheckRequested = false;   // 'c' command: run it from idle
+bool  g_tagFirst    = false;   // operator presents the tag before START
+
+// Tests per paddle: its results go onto its tag together, in one write
+#define TESTS_PER_PADDLE_MAX 5
+uint8_t g_testsPerPaddle = 1;
+uint8_t g_paddleTest     = 0;   // tests done on the current paddle
 
 struct Btn {
   uint8_t pin;
@@ -185,13 +262,20 @@ void   setDir(bool forward);
 void   doStepBlocking(int pulseUs);
 bool   limitHit();
 void   oledHeader(const char* line1);
-void   oledKV(const char* k, const String& v);
+void   oledScreen(const StaticScreen& screen);
+void   oledKV(const char* k, const char* v);
+void   oledFlush();
 void   showSplash();
 void   saveCalibration();
 void   loadCalibration();
 long   nauReadRawAvg(int n);
 float  rawToPounds(long raw);
-void   doCalibration3lb();
+void   doCalibration();
+void   doTempCheck();
+void   saveTempModel();
+void   loadTempModel();
+void   tempCompApply();
+void   tempModelPrint();
 void   homeToLimit();
 void   homeToLimitSafe();
 void   homeToLimitForce();
@@ -201,16 +285,15 @@ RunResult runTest();
 bool   readButton(Btn& b, bool& shortPress, bool& longPress);
 void   updateLiveForceLine(bool forceClear=false);
 void   setLED(uint8_t r, uint8_t g, uint8_t b);
-void   ledOff();
-void   rainbowCycle(int durationMs);
-void   pulseLED(uint8_t r, uint8_t g, uint8_t b, int times, int pulseMs);
-uint32_t colorWheel(byte pos);
 void   displayTestResults(float cof, int machineID);
+void   drawResultPlots();
 void   displayRFIDSuccess();
 void   displayRFIDRetry(int attemptsLeft);
 void   displayRFIDFinalFailure();
-bool   writeToRFID(float cofValue);
+void   displayNfcEvent(const NfcWriterEvent& ev);
+void   displayNfcSkipped();
 void   dumpTestDataCSV();
+void   pollSerialCommands();
 
 // Dual-core function prototypes
 void   motionTask(void* parameter);
@@ -222,18 +305,18 @@ void   homeToLimitSafe();
 void   moveStepsBlockingSafe(long steps, bool forward, int pulseUs);
 
 // ----------------------------- Utils ----------------------------------------
-void stepperEnable(bool on) { digitalWrite(PIN_EN, on ? LOW : HIGH); }
-void setDir(bool forward)   { digitalWrite(PIN_DIR, forward ? HIGH : LOW); }
+void stepperEnable(bool on) { halDigitalWrite(PIN_EN, on ? LOW : HIGH); }
+void setDir(bool forward)   { halDigitalWrite(PIN_DIR, forward ? HIGH : LOW); }
 
 void doStepBlocking(int pulseUs) {
-  digitalWrite(PIN_STEP, HIGH);
-  delayMicroseconds(pulseUs);
-  digitalWrite(PIN_STEP, LOW);
-  delayMicroseconds(pulseUs);
+  halDigitalWrite(PIN_STEP, HIGH);
+  halDelayUs(pulseUs);
+  halDigitalWrite(PIN_STEP, LOW);
+  halDelayUs(pulseUs);
 }
 
 bool limitHit() {
-  int val = digitalRead(PIN_LIMIT);
+  int val = halDigitalRead(PIN_LIMIT);
   return LIMIT_ACTIVE_LOW ? (val == LOW) : (val == HIGH);
 }
 
@@ -247,7 +330,28 @@ void oledHeader(const char* line1) {
   oled.setCursor(0, 14);
 }
 
-void oledKV(const char* k, const String& v) {
+// Shows a pre-rendered screen (StaticScreens.h, generated by
+// host/tools/gen_screens) instead of drawing it glyph by glyph; text state
+// is left as oledHeader() leaves it for any dynamic fields.
+void oledScreen(const StaticScreen& screen) {
+  uint8_t* buf = oled.getBuffer();
+  memset(buf, 0, OLED_WIDTH * OLED_HEIGHT / 8);
+  memcpy_P(buf + screen.page0 * OLED_WIDTH, screen.data, screen.pages * OLED_WIDTH);
+  oled.setTextSize(1);
+  oled.setTextColor(SSD1306_WHITE);
+  oled.setCursor(0, 14);
+}
+
+// All framebuffer pushes go through here so they show up in the profile.
+// Hands the frame to the display task; the bus write happens there.
+void oledFlush() {
+  PROF_SCOPE(PROF_OLED_FLUSH);
+  TRACE_BEGIN(TR_OLED_FLUSH, 0);
+  displayPresent(oled.getBuffer());
+  TRACE_END(TR_OLED_FLUSH, 0);
+}
+
+void oledKV(const char* k, const char* v) {
   oled.print(k);
   oled.print(F(": "));
   oled.println(v);
@@ -262,118 +366,201 @@ void showSplash() {
   oled.println(F("Powering"));
   oled.setCursor(28, 36);
   oled.println(F("On..."));
-  oled.display();
+  oledFlush();
 }
 
 // ----------------------------- RGB LED Functions ----------------------------
+// Solid colors take effect at once; pulses, blinks and the rainbow are
+// played by the LED task (LedAnimator.h) while the caller moves on.
 void setLED(uint8_t r, uint8_t g, uint8_t b) {
-  rgbLed.setPixelColor(0, rgbLed.Color(r, g, b));
-  rgbLed.show();
+  ledSolid(r, g, b);
 }
 
-void ledOff() {
-  rgbLed.clear();
-  rgbLed.show();
+// Boot self-test: red, green, blue, off
+static const LedKeyframe LED_SELF_TEST[] = {
+  { 255, 0,   0,   0, 300 },
+  { 0,   255, 0,   0, 300 },
+  { 0,   0,   255, 0, 300 },
+  { 0,   0,   0,   0, 0   },
+};
+
+// Blue blink while waiting for a tag
+static const LedKeyframe LED_TAG_WAIT[] = {
+  { 0, 0, 255, 0, 250 },
+  { 0, 0, 0,   0, 250 },
+};
+
+// ----------------------------- Calibration ----------------------------------
+void saveCalibration() {
+  halPrefsBegin(PREFS_NAMESPACE, false);
+  halPrefsPutFloat(KEY_CAL, g_calibration);
+  halPrefsPutLong(KEY_TARE, g_tareRaw);  // Use putLong to preserve full value
+  halPrefsPutFloat(KEY_CAL_CURVE, g_calCurve);
+  halPrefsPutLong(KEY_CAL_POINTS, g_calPoints);
+  halPrefsPutFloat(KEY_CAL_RMS, g_calRmsLb);
+  halPrefsPutFloat(KEY_CAL_MAX, g_calMaxLb);
+  halPrefsEnd();
 }
 
-uint32_t colorWheel(byte pos) {
-  // Color wheel helper: 0-255 maps through rainbow
-  pos = 255 - pos;
-  if (pos < 85) {
-    return rgbLed.Color(255 - pos * 3, 0, pos * 3);
-  } else if (pos < 170) {
-    pos -= 85;
-    return rgbLed.Color(0, pos * 3, 255 - pos * 3);
-  } else {
-    pos -= 170;
-    return rgbLed.Color(pos * 3, 255 - pos * 3, 0);
+void loadCalibration() {
+  halPrefsBegin(PREFS_NAMESPACE, true);
+  float cal = halPrefsGetFloat(KEY_CAL, NAN);
+  long tare  = halPrefsGetLong(KEY_TARE, 0);  // Use getLong to match putLong
+  g_calCurve  = halPrefsGetFloat(KEY_CAL_CURVE, 0.0f);
+  g_calPoints = (uint8_t)halPrefsGetLong(KEY_CAL_POINTS, 0);
+  g_calRmsLb  = halPrefsGetFloat(KEY_CAL_RMS, 0.0f);
+  g_calMaxLb  = halPrefsGetFloat(KEY_CAL_MAX, 0.0f);
+  long order = halPrefsGetLong(KEY_CAL_ORDER, 1);
+  g_calMulti = halPrefsGetLong(KEY_CAL_MULTI, 0) != 0;
+  g_tagFirst = NFC_TAG_FIRST_ENABLED && halPrefsGetLong(KEY_TAG_FIRST, 0) != 0;
+  long perPaddle = halPrefsGetLong(KEY_PER_PADDLE, 1);
+  halPrefsEnd();
+  if (!isnan(cal)) g_calibration = cal;
+  g_tareRaw = tare;
+  g_calTareRaw = tare;
+  tareTrackReset(tare);
+  if (perPaddle >= 1 && perPaddle <= TESTS_PER_PADDLE_MAX) g_testsPerPaddle = (uint8_t)perPaddle;
+  if (order == 1 || order == 2) g_calOrder = (uint8_t)order;
+}
+
+static void tempKey(FixedText<8>& key, char kind, uint8_t i) {
+  key.clear();
+  char prefix[4] = { 't', 'c', kind, 0 };
+  key.add(prefix).add((long)i);
+}
+
+void saveTempModel() {
+  FixedText<8> key;
+  halPrefsBegin(PREFS_NAMESPACE, false);
+  halPrefsPutFloat(KEY_TC_REF, g_tempModel.refC);
+  halPrefsPutFloat(KEY_TC_OFFSET, g_tempModel.offsetPerC);
+  halPrefsPutFloat(KEY_TC_GAIN, g_tempModel.gainPerC);
+  halPrefsPutLong(KEY_TC_FITTED, g_tempModel.points);
+  halPrefsPutLong(KEY_TC_COUNT, g_tempPointCount);
+  for (uint8_t i = 0; i < g_tempPointCount; i++) {
+    tempKey(key, 'T', i); halPrefsPutFloat(key.c_str(), g_tempPoints[i].degC);
+    tempKey(key, 'Z', i); halPrefsPutLong(key.c_str(), g_tempPoints[i].tareRaw);
+    tempKey(key, 'G', i); halPrefsPutFloat(key.c_str(), g_tempPoints[i].gain);
   }
+  halPrefsEnd();
 }
 
-void rainbowCycle(int durationMs) {
-  uint32_t startTime = millis();
-  while (millis() - startTime < durationMs) {
-    byte wheelPos = (byte)(((millis() - startTime) * 255) / durationMs);
-    rgbLed.setPixelColor(0, colorWheel(wheelPos));
-    rgbLed.show();
-    delay(10);
+void loadTempModel() {
+  FixedText<8> key;
+  halPrefsBegin(PREFS_NAMESPACE, true);
+  g_tempModel.refC       = halPrefsGetFloat(KEY_TC_REF, 25.0f);
+  g_tempModel.offsetPerC = halPrefsGetFloat(KEY_TC_OFFSET, 0.0f);
+  g_tempModel.gainPerC   = halPrefsGetFloat(KEY_TC_GAIN, 0.0f);
+  g_tempModel.points     = (uint8_t)halPrefsGetLong(KEY_TC_FITTED, 0);
+  long count = halPrefsGetLong(KEY_TC_COUNT, 0);
+  if (count < 0 || count > TEMP_MAX_POINTS) count = 0;
+  g_tempPointCount = (uint8_t)count;
+  for (uint8_t i = 0; i < g_tempPointCount; i++) {
+    tempKey(key, 'T', i); g_tempPoints[i].degC    = halPrefsGetFloat(key.c_str(), 0.0f);
+    tempKey(key, 'Z', i); g_tempPoints[i].tareRaw = halPrefsGetLong(key.c_str(), 0);
+    tempKey(key, 'G', i); g_tempPoints[i].gain    = halPrefsGetFloat(key.c_str(), 1.0f);
   }
+  halPrefsEnd();
 }
 
-void pulseLED(uint8_t r, uint8_t g, uint8_t b, int times, int pulseMs) {
-  for (int i = 0; i < times; i++) {
-    // Fade in
-    for (int brightness = 0; brightness <= 255; brightness += 15) {
-      uint8_t br = (r * brightness) / 255;
-      uint8_t bg = (g * brightness) / 255;
-      uint8_t bb = (b * brightness) / 255;
-      setLED(br, bg, bb);
-      delay(pulseMs / 34); // 34 steps total (17 up, 17 down)
-    }
-    // Fade out
-    for (int brightness = 255; brightness >= 0; brightness -= 15) {
-      uint8_t br = (r * brightness) / 255;
-      uint8_t bg = (g * brightness) / 255;
-      uint8_t bb = (b * brightness) / 255;
-      setLED(br, bg, bb);
-      delay(pulseMs / 34);
-    }
-    ledOff();
-    if (i < times - 1) delay(100); // pause between pulses
+void tempModelPrint() {
+  float degC;
+  bool hasTemp = tareTrackTempC(&degC);
+  Serial.println("---TEMPCOMP_START---");
+  Serial.print("ref_c,");          Serial.println(g_tempModel.refC, 2);
+  Serial.print("offset_per_c,");   Serial.println(g_tempModel.offsetPerC, 3);
+  Serial.print("gain_ppm_per_c,"); Serial.println(g_tempModel.gainPerC * 1e6f, 1);
+  Serial.print("fitted_checks,");  Serial.println(g_tempModel.points);
+  if (hasTemp) {
+    Serial.print("temp_c,");       Serial.println(degC, 2);
+    Serial.print("gain_now,");     Serial.println(tempModelGain(g_tempModel, degC), 6);
   }
+  Serial.println("point,temp_c,tare_raw,gain");
+  for (uint8_t i = 0; i < g_tempPointCount; i++) {
+    Serial.print(i == 0 ? "cal" : "check"); Serial.print(',');
+    Serial.print(g_tempPoints[i].degC, 2);  Serial.print(',');
+    Serial.print(g_tempPoints[i].tareRaw);  Serial.print(',');
+    Serial.println(g_tempPoints[i].gain, 6);
+  }
+  Serial.println("---TEMPCOMP_END---");
 }
 
-// ----------------------------- Calibration ----------------------------------
-void saveCalibration() {
-  prefs.begin(PREFS_NAMESPACE, false);
-  prefs.putFloat(KEY_CAL, g_calibration);
-  prefs.putLong(KEY_TARE, g_tareRaw);  // Use putLong to preserve full value
-  prefs.end();
+// At START: the latest idle temperature sets the test's gain and, if the
+// tare tracker has nothing better, corrects the calibration tare
+void tempCompApply() {
+  float degC;
+  g_gainComp = 1.0f;
+  if (!tareTrackTempC(&degC)) return;
+  g_gainComp = tempModelGain(g_tempModel, degC);
+  if (!tareTrackValid() && g_tempModel.points) {
+    g_tareRaw = tempModelTare(g_tempModel, g_calTareRaw, degC);
+  }
 }
 
-void loadCalibration() {
-  prefs.begin(PREFS_NAMESPACE, true);
-  float cal = prefs.getFloat(KEY_CAL, NAN);
-  long tare  = prefs.getLong(KEY_TARE, 0);  // Use getLong to match putLong
-  prefs.end();
-  if (!isnan(cal)) g_calibration = cal;
-  g_tareRaw = tare;
+void saveWorkflow() {
+  halPrefsBegin(PREFS_NAMESPACE, false);
+  halPrefsPutLong(KEY_TAG_FIRST, g_tagFirst ? 1 : 0);
+  halPrefsPutLong(KEY_PER_PADDLE, g_testsPerPaddle);
+  halPrefsPutLong(KEY_CAL_ORDER, g_calOrder);
+  halPrefsPutLong(KEY_CAL_MULTI, g_calMulti ? 1 : 0);
+  halPrefsEnd();
+}
+
+// The current paddle's results so far go to its tag as they are
+void endPaddle() {
+  if (g_paddleTest) nfcWriterEndBatch();
+  g_paddleTest = 0;
 }
 
+// Interquartile mean of n readings, so a spike cannot bias a tare or a
+// calibration point. Only while the sampling task leaves the load cell
+// alone: tare tracking stopped.
 long nauReadRawAvg(int n) {
-  long sum = 0;
+  long readings[TARE_WINDOW];
+  if (n > TARE_WINDOW) n = TARE_WINDOW;
   for (int i=0; i<n; i++) {
-    while (!nau.available()) delay(1);
-    sum += nau.getReading();
+    while (!halLoadCellAvailable()) halDelayMs(1);
+    readings[i] = halLoadCellRead();
   }
-  return sum / n;
+  return interquartileMean(readings, n);
 }
 
+// Conversion coefficients (LoadCellCal.h) with the temperature gain: the
+// load cell reads g_gainComp times the counts it did at calibration
+void calCoefficients(float* c1, float* c2) {
+  float g = g_gainComp;
+  *c1 = g_calibration != 0.0f ? 1.0f / (g_calibration * g) : 0.0f;
+  *c2 = g_calCurve / (g * g);
+}
+
+// One reading, for the live display. Test passes are converted in bulk
+// with countsToPounds().
 float rawToPounds(long raw) {
   if (g_calibration == 0.0f) {
     Serial.println("ERROR: Division by zero - g_calibration is 0!");
     return 0.0f;
   }
-  return (float)(raw - g_tareRaw) / g_calibration;
+  float c1, c2;
+  calCoefficients(&c1, &c2);
+  float x = (float)(raw - g_tareRaw);
+  return x * (c1 + c2 * x);
 }
 
-void doCalibration3lb() {
-  // ---- Move carriage to furthest position for calibration ----
+// Homes, then moves the carriage to its furthest position (lowering +
+// measurement distance), where the weights hang. False if aborted.
+static bool calPosition() {
   g_abortRequested = false;
   g_abortBtnDownAt = 0;
 
   oledHeader("CAL: Positioning...");
   oled.println(F("Moving to cal position"));
-  oled.display();
+  oledFlush();
   setLED(255, 150, 0); // Yellow during positioning
 
   // First home to ensure consistent starting point
   homeToLimitSafe();
+  if (g_abortRequested) return false;
 
-  if (g_abortRequested) goto cal_abort;
-
-  {
-  // Move to furthest position (lowering + measurement distance)
   const long calPositionSteps = lround((SEG_LOWER_IN + SEG_MEASURE_IN) * STEPS_PER_INCH);
 
   MotionRequest req;
@@ -386,121 +573,255 @@ void doCalibration3lb() {
   req.pulseUs = STEP_PULSE_US;
   req.phase = PHASE_NONE;
   requestMotion(req);
-
-  if (g_abortRequested) goto cal_abort;
+  if (g_abortRequested) return false;
 
   ledOff();
+  return true;
+}
 
-  // ---- Step 1: Tare (zero-load) ----
-  oledHeader("CAL: Step 1/2 (Tare)");
-  oled.println(F("Remove all load"));
-  oled.println(F("Press START to tare"));
-  oled.display();
-
-  // Wait for START button press (debounced)
+// Waits for a START press (debounced)
+static void calWaitStart() {
   bool sp = false, lp = false;
   while (!sp && !lp) {
     readButton(btnStart, sp, lp);
-    delay(10);
+    halDelayMs(10);
   }
+}
+
+static void calReturnHome() {
+  oledHeader("CAL: Returning...");
+  oled.println(F("Moving to home"));
+  oledFlush();
+  setLED(255, 150, 0); // Yellow during return
+
+  homeToLimitSafe();
+
+  MotionRequest reqDisable;
+  reqDisable.cmd = CMD_DISABLE;
+  requestMotion(reqDisable, 1000);
+
+  ledOff();
+}
+
+static void calFailed(const char* why) {
+  Serial.print("CAL FAILED: ");
+  Serial.println(why);
+  oledHeader("CAL FAILED");
+  oled.println(why);
+  oledFlush();
+  halDelayMs(2000);
+
+  // Return carriage to home even on failure
+  oledScreen(SCREEN_RETURNING);
+  oledFlush();
+  homeToLimitSafe();
+
+  MotionRequest reqDisable;
+  reqDisable.cmd = CMD_DISABLE;
+  requestMotion(reqDisable, 1000);
+}
+
+static void calAborted() {
+  Serial.println("CALIBRATION ABORTED");
+  g_collectSamples = false;
+  g_abortRequested = false;
+  g_abortBtnDownAt = 0;
+  oledHeader("CAL ABORTED");
+  oled.println(F("Homing..."));
+  oledFlush();
+  setLED(255, 0, 0);
+
+  while (halDigitalRead(BTN_START) == LOW) halDelayMs(10);
+
+  homeToLimitForce();
+
+  MotionRequest reqDis;
+  reqDis.cmd = CMD_DISABLE;
+  requestMotion(reqDis, 1000);
+
+  ledOff();
+  halDelayMs(1500);
+}
+
+// Tare with no load; header names the step
+static long calTare(const char* header) {
+  oledHeader(header);
+  oled.println(F("Remove all load"));
+  oled.println(F("Press START to tare"));
+  oledFlush();
+  calWaitStart();
 
   oledHeader("CAL: Taring...");
-  oled.display();
+  oledFlush();
   setLED(255, 0, 0); // Red during tare
-  g_tareRaw = nauReadRawAvg(HX_SAMPLES_TARE);
+  long tareRaw = nauReadRawAvg(HX_SAMPLES_TARE);
   ledOff();
+  return tareRaw;
+}
 
-  // ---- Step 2: Known weight ----
-  String headerStr = "CAL: Step 2/2 (" + String(CAL_WEIGHT_LB, 3) + " lb)";
-  oledHeader(headerStr.c_str());
+// Counts above the tare under a known weight
+static long calWeigh(const char* header, float lb, long tareRaw) {
+  FixedText<8> weightStr;
+  weightStr.addFixed(lb, 3);
+  oledHeader(header);
   oled.print(F("Place "));
-  oled.print(CAL_WEIGHT_LB, 3);
+  oled.print(weightStr.c_str());
   oled.println(F(" lb weight"));
   oled.println(F("Press START to sample"));
-  oled.display();
+  oledFlush();
+  calWaitStart();
+
+  long counts = nauReadRawAvg(HX_SAMPLES_TARE) - tareRaw;  // counts due to the weight
+  Serial.print("CAL point ");
+  Serial.print(lb, 3);
+  Serial.print(" lb: ");
+  Serial.println(counts);
+  return counts;
+}
 
-  // Wait for START button press (debounced)
-  sp = false;
-  lp = false;
-  while (!sp && !lp) {
-    readButton(btnStart, sp, lp);
-    delay(10);
-  }
+// N-point calibration: a tare, then each of CAL_POINTS_LB (or, with
+// g_calMulti, CAL_MULTI_POINTS_LB) in turn, fitted by least squares
+// (linear, or quadratic per g_calOrder). The stored
+// calibration only changes once the fit succeeds. Its temperature becomes
+// the temperature model's reference.
+void doCalibration() {
+  tareTrackStop();  // the load cell is ours until the idle loop resumes
 
-  long raw3 = nauReadRawAvg(HX_SAMPLES_TARE);
-  long delta = raw3 - g_tareRaw; // counts due to calibration weight
+  if (!calPosition()) {
+    calAborted();
+    return;
+  }
 
-  if (abs(delta) < 100) {
-    oledHeader("CAL FAILED");
-    oled.println(F("Signal too small"));
-    oled.display();
-    delay(2000);
+  const float* weights = g_calMulti ? CAL_MULTI_POINTS_LB : CAL_POINTS_LB;
+  const uint8_t points = g_calMulti ? CAL_MULTI_NUM_POINTS : CAL_NUM_POINTS;
 
-    // Return carriage to home even on failure
-    oledHeader("Returning...");
-    oled.display();
-    homeToLimitSafe();
+  // ---- Step 1: Tare (zero-load) ----
+  FixedText<32> headerStr;
+  headerStr.add("CAL: Step 1/").add((long)(points + 1)).add(" (Tare)");
+  long tareRaw = calTare(headerStr.c_str());
+
+  // ---- Steps 2..N+1: known weights, one at a time ----
+  long counts[CAL_MAX_POINTS];
+  for (uint8_t i = 0; i < points; i++) {
+    headerStr.clear();
+    headerStr.add("CAL: ").add((long)(i + 2)).add("/").add((long)(points + 1))
+             .add(" (").addFixed(weights[i], 3).add(" lb)");
+    counts[i] = calWeigh(headerStr.c_str(), weights[i], tareRaw);
+    if (labs(counts[i]) < 100) {
+      calFailed("Signal too small");
+      return;
+    }
+  }
 
-    MotionRequest reqDisable;
-    reqDisable.cmd = CMD_DISABLE;
-    requestMotion(reqDisable, 1000);
+  // Least-squares fit; a quadratic needs two weights
+  uint8_t order = points >= 2 ? g_calOrder : 1;
+  LoadCellFit fit;
+  if (!loadCellFit(counts, weights, points, order, &fit) || fit.c1 == 0.0f) {
+    calFailed("Readings not distinct");
     return;
   }
 
-  // counts per lb
-  g_calibration = (float)delta / CAL_WEIGHT_LB;
+  g_tareRaw     = tareRaw;
+  g_calTareRaw  = tareRaw;
+  tareTrackReset(tareRaw);   // the tracked tare predates this calibration
+  g_calibration = 1.0f / fit.c1;   // counts per lb at zero load
+  g_calCurve    = fit.c2;
+  g_calPoints   = points;
+  g_calRmsLb    = fit.rmsLb;
+  g_calMaxLb    = fit.maxLb;
   saveCalibration();
 
-  oledHeader("CAL DONE");
-  String countsLabel = "Counts@" + String(CAL_WEIGHT_LB, 3) + "lb";
-  oledKV(countsLabel.c_str(), String(delta));
-  oledKV("Cal (cnt/lb)", String(g_calibration, 2));
-  oledKV("TareRaw", String(g_tareRaw));
-  oled.display();
-  delay(1500);
-
-  // ---- Return carriage to home position ----
-  oledHeader("CAL: Returning...");
-  oled.println(F("Moving to home"));
-  oled.display();
-  setLED(255, 150, 0); // Yellow during return
+  float degC;
+  if (halLoadCellReadTempC(&degC)) {
+    tempModelCalibrated(&g_tempModel, g_tempPoints, &g_tempPointCount, degC, tareRaw);
+    saveTempModel();
+    Serial.print("CAL temperature: ");
+    Serial.print(degC, 2);
+    Serial.println(" C");
+  }
 
-  homeToLimitSafe();
+  Serial.print("CAL fit: ");
+  Serial.print(order == 2 ? "quadratic" : "linear");
+  Serial.print(", ");
+  Serial.print(g_calibration, 2);
+  Serial.print(" counts/lb, residual rms ");
+  Serial.print(g_calRmsLb, 4);
+  Serial.print(" lb, max ");
+  Serial.print(g_calMaxLb, 4);
+  Serial.println(" lb");
 
-  // Disable stepper
+  oledHeader(order == 2 ? "CAL DONE (quadratic)" : "CAL DONE (linear)");
   {
-    MotionRequest reqDisable;
-    reqDisable.cmd = CMD_DISABLE;
-    requestMotion(reqDisable, 1000);
+    FixedText<24> value;
+    value.addFixed(g_calibration, 2);
+    oledKV("Cal (cnt/lb)", value.c_str());
+    value.clear();
+    value.addFixed(g_calMaxLb, 4);
+    oledKV("Max resid lb", value.c_str());
+    value.clear();
+    value.add(g_tareRaw);
+    oledKV("TareRaw", value.c_str());
   }
+  oledFlush();
+  halDelayMs(1500);
 
-  ledOff();
-  }  // end normal calibration block
+  calReturnHome();
+}
 
-  return;
+// Temperature check point: a tare and CAL_WEIGHT_LB at today's
+// temperature, compared with what the calibration predicts. Leaves the
+// calibration alone; refits the temperature model once the points span
+// TEMP_MIN_SPAN_C (TempComp.h).
+void doTempCheck() {
+  tareTrackStop();  // the load cell is ours until the idle loop resumes
 
-cal_abort:
-  {
-    Serial.println("CALIBRATION ABORTED");
-    g_collectSamples = false;
-    g_abortRequested = false;
-    g_abortBtnDownAt = 0;
-    oledHeader("CAL ABORTED");
-    oled.println(F("Homing..."));
-    oled.display();
-    setLED(255, 0, 0);
+  if (g_calibration == 0.0f || g_tempPointCount == 0) {
+    Serial.println("TEMP CHECK: calibrate first");
+    return;
+  }
+  if (!calPosition()) {
+    calAborted();
+    return;
+  }
 
-    while (digitalRead(BTN_START) == LOW) delay(10);
+  float degC;
+  bool hasTemp = halLoadCellReadTempC(&degC);
+  long tareRaw = calTare("TEMP: Step 1/2 (Tare)");
+  long counts = calWeigh("TEMP: Step 2/2", CAL_WEIGHT_LB, tareRaw);
+  float expected = poundsToCounts(CAL_WEIGHT_LB, 1.0f / g_calibration, g_calCurve);
+  if (!hasTemp || labs(counts) < 100 || expected == 0.0f) {
+    calFailed(hasTemp ? "Signal too small" : "No temperature");
+    return;
+  }
 
-    homeToLimitForce();
+  TempPoint pt = { degC, tareRaw, (float)counts / expected };
+  bool fitted = tempModelAddPoint(&g_tempModel, g_tempPoints, &g_tempPointCount, pt);
+  saveTempModel();
 
-    MotionRequest reqDis;
-    reqDis.cmd = CMD_DISABLE;
-    requestMotion(reqDis, 1000);
+  Serial.print("TEMP point: ");
+  Serial.print(degC, 2);
+  Serial.print(" C, tare ");
+  Serial.print(tareRaw);
+  Serial.print(", gain ");
+  Serial.println(pt.gain, 5);
+  tempModelPrint();
 
-    ledOff();
-    delay(1500);
+  oledHeader(fitted ? "TEMP MODEL UPDATED" : "TEMP POINT SAVED");
+  {
+    FixedText<24> value;
+    value.addFixed(degC, 1);
+    oledKV("Temp (C)", value.c_str());
+    value.clear();
+    value.addFixed((pt.gain - 1.0f) * 100.0f, 3);
+    oledKV("Gain err %", value.c_str());
+    value.clear();
+    value.add((long)(g_tempPointCount - 1));
+    oledKV("Checks", value.c_str());
   }
+  oledFlush();
+  halDelayMs(1500);
+
+  calReturnHome();
 }
 
 // ----------------------------- Motion ---------------------------------------
@@ -511,9 +832,9 @@ bool g_motionActive = false; // used to suppress OLED live updates during motion
 // Check if START button held for ABORT_HOLD_MS; returns true if abort triggered
 // Safe to call from any core (digitalRead only, no I2C)
 bool checkAbortButton() {
-  if (digitalRead(BTN_START) == LOW) {
-    if (g_abortBtnDownAt == 0) g_abortBtnDownAt = millis();
-    else if (millis() - g_abortBtnDownAt >= ABORT_HOLD_MS) {
+  if (halDigitalRead(BTN_START) == LOW) {
+    if (g_abortBtnDownAt == 0) g_abortBtnDownAt = halMillis();
+    else if (halMillis() - g_abortBtnDownAt >= ABORT_HOLD_MS) {
       g_abortRequested = true;
       g_abortBtnDownAt = 0;
       return true;
@@ -544,9 +865,9 @@ bool executeHome(bool abortable = true) {
 
   // First approach
   int stepCount = 0;
-  uint32_t startTime = millis();
+  uint32_t startTime = halMillis();
   while (!limitHit()) {
-    if (millis() - startTime > HOMING_TIMEOUT_MS) {
+    if (halMillis() - startTime > HOMING_TIMEOUT_MS) {
       stepperEnable(false);
       return false;
     }
@@ -565,9 +886,9 @@ bool executeHome(bool abortable = true) {
 
   // Second approach
   setDir(DIR_HOME_TOWARD_LIMIT);
-  startTime = millis();
+  startTime = halMillis();
   while (!limitHit()) {
-    if (millis() - startTime > HOMING_TIMEOUT_MS) {
+    if (halMillis() - startTime > HOMING_TIMEOUT_MS) {
       stepperEnable(false);
       return false;
     }
@@ -591,40 +912,45 @@ bool executeHome(bool abortable = true) {
 // Core 1: Motion task (runs exclusively on Core 1)
 void motionTask(void* parameter) {
   // Disable watchdog on Core 1
-  disableCore1WDT();
+  halDisableCore1Wdt();
 
   Serial.println("Motion task started on Core 1");
   Serial.print("Motion task running on core: ");
-  Serial.println(xPortGetCoreID());
+  Serial.println(halCoreId());
 
   MotionRequest req;
 
   while (true) {
     // Wait for motion command (yields CPU while waiting)
-    if (xQueueReceive(motionCommandQueue, &req, portMAX_DELAY) == pdTRUE) {
+    if (halQueueReceive(motionCommandQueue, &req, HAL_WAIT_FOREVER)) {
       g_motionActive = true;
+      TRACE_BEGIN(TR_MOTION, req.cmd);
 
       // Execute command with NO interruptions
       switch (req.cmd) {
         case CMD_HOME:
           g_currentPhase = PHASE_HOMING;
+          TRACE_INSTANT(TR_PHASE, PHASE_HOMING);
           executeHome(true);
           break;
 
         case CMD_HOME_FORCE:
           g_currentPhase = PHASE_HOMING;
+          TRACE_INSTANT(TR_PHASE, PHASE_HOMING);
           executeHome(false);
           break;
 
         case CMD_MOVE:
           // Simple move (lowering or returning)
           g_currentPhase = req.phase;
+          TRACE_INSTANT(TR_PHASE, req.phase);
           executePureMove(req.steps, req.direction, req.pulseUs);
           break;
 
         case CMD_MEASURE_MOVE:
           // Critical measurement phase
           g_currentPhase = req.phase;
+          TRACE_INSTANT(TR_PHASE, req.phase);
           g_collectSamples = true;  // Signal Core 0 to start sampling
 
           executePureMove(req.steps, req.direction, req.pulseUs);
@@ -643,9 +969,10 @@ void motionTask(void* parameter) {
 
       g_motionActive = false;
       g_currentPhase = PHASE_NONE;
+      TRACE_END(TR_MOTION, req.cmd);
 
       // Signal completion
-      xSemaphoreGive(motionCompleteSemaphore);
+      halSemGive(motionCompleteSemaphore);
     }
   }
 }
@@ -654,7 +981,7 @@ void motionTask(void* parameter) {
 void forceSamplingTask(void* parameter) {
   Serial.println("Force sampling task started on Core 0");
   Serial.print("Force sampling task running on core: ");
-  Serial.println(xPortGetCoreID());
+  Serial.println(halCoreId());
 
   while (true) {
     // Wait for sampling signal
@@ -677,17 +1004,26 @@ void forceSamplingTask(void* parameter) {
 
       // Sample as fast as possible while motion is active
       if (sampleBuffer != NULL && sampleCount != NULL) {
+        int tracePhase = g_currentPhase;
+        TRACE_BEGIN(TR_SAMPLING, tracePhase);
         while (g_collectSamples && *sampleCount < maxSamples) {
-          if (nau.available()) {
-            long raw = nau.getReading();
-            sampleBuffer[*sampleCount] = rawToPounds(raw);
+          if (halLoadCellAvailable()) {
+            long raw = halLoadCellRead();
+            sampleBuffer[*sampleCount] = (float)raw;   // lb once the test is done
             (*sampleCount)++;
+            if ((*sampleCount & 0x1F) == 0) TRACE_COUNTER(TR_SAMPLE_COUNT, *sampleCount);
           }
-          vTaskDelay(1);  // Yield briefly (~1ms)
+          halTaskDelayMs(1);  // Yield briefly (~1ms)
         }
+        TRACE_COUNTER(TR_SAMPLE_COUNT, *sampleCount);
+        TRACE_END(TR_SAMPLING, tracePhase);
+
+        // Buffer full: hold until the pass ends rather than restarting it
+        while (g_collectSamples) halTaskDelayMs(1);
       }
     } else {
-      vTaskDelay(10);  // Idle, check every 10ms
+      tareTrackPoll();     // idle: track the tare while the tester is idle
+      halTaskDelayMs(10);  // check every 10ms
     }
   }
 }
@@ -695,13 +1031,17 @@ void forceSamplingTask(void* parameter) {
 // Core 0: Request motion from Core 1 (wrapper function)
 bool requestMotion(MotionRequest req, uint32_t timeoutMs) {
   // Send command to Core 1
-  if (xQueueSend(motionCommandQueue, &req, pdMS_TO_TICKS(100)) != pdTRUE) {
+  TRACE_INSTANT(TR_QUEUE_SEND, req.cmd);
+  if (!halQueueSend(motionCommandQueue, &req, 100)) {
     Serial.println("ERROR: Motion queue full");
     return false;
   }
 
   // Wait for completion
-  if (xSemaphoreTake(motionCompleteSemaphore, pdMS_TO_TICKS(timeoutMs)) != pdTRUE) {
+  TRACE_BEGIN(TR_SEM_WAIT, req.cmd);
+  bool done = halSemTake(motionCompleteSemaphore, timeoutMs);
+  TRACE_END(TR_SEM_WAIT, req.cmd);
+  if (!done) {
     Serial.println("ERROR: Motion timeout");
     return false;
   }
@@ -751,9 +1091,9 @@ void homeToLimit() {
   setDir(DIR_HOME_TOWARD_LIMIT);
 
   // First approach with timeout
-  uint32_t startTime = millis();
+  uint32_t startTime = halMillis();
   while (!limitHit()) {
-    if (millis() - startTime > HOMING_TIMEOUT_MS) {
+    if (halMillis() - startTime > HOMING_TIMEOUT_MS) {
       Serial.println("ERROR: Homing timeout on first approach!");
       stepperEnable(false);
       g_motionActive = false;
@@ -762,16 +1102,16 @@ void homeToLimit() {
     doStepBlocking(HOME_STEP_US);
   }
   setLED(0, 255, 0); // Green when limit is hit
-  delay(200);
+  halDelayMs(200);
 
   setDir(!DIR_HOME_TOWARD_LIMIT);
   for (int i=0; i<BACKOFF_STEPS; i++) doStepBlocking(HOME_STEP_US);
   setDir(DIR_HOME_TOWARD_LIMIT);
 
   // Second approach with timeout
-  startTime = millis();
+  startTime = halMillis();
   while (!limitHit()) {
-    if (millis() - startTime > HOMING_TIMEOUT_MS) {
+    if (halMillis() - startTime > HOMING_TIMEOUT_MS) {
       Serial.println("ERROR: Homing timeout on second approach!");
       stepperEnable(false);
       g_motionActive = false;
@@ -780,7 +1120,7 @@ void homeToLimit() {
     doStepBlocking(HOME_STEP_US);
   }
   setLED(0, 255, 0); // Green when limit is hit (second time)
-  delay(200);
+  halDelayMs(200);
   setDir(!DIR_HOME_TOWARD_LIMIT);
   for (int i=0; i<BACKOFF_STEPS/2; i++) doStepBlocking(HOME_STEP_US);
 
@@ -795,6 +1135,17 @@ void moveStepsBlocking(long steps, bool forward, int pulseUs) {
 }
 
 
+// Averaging strategies wrapped for the profiler (AveragingFn-compatible)
+double profiledPercentileBand(const float* samples, long count) {
+  PROF_SCOPE(PROF_AVG_PERCENTILE);
+  return avgPercentileBand(samples, count);
+}
+
+double profiledOneStdDev(const float* samples, long count) {
+  PROF_SCOPE(PROF_AVG_STDDEV);
+  return avgWithinOneStdDev(samples, count);
+}
+
 RunResult runTest() {
   const long steps_lower   = lround(SEG_LOWER_IN   * STEPS_PER_INCH);
   const long steps_noise   = lround(SEG_NOISE_IN   * STEPS_PER_INCH);
@@ -805,19 +1156,20 @@ RunResult runTest() {
   g_revSampleCount = 0;
   g_abortRequested = false;
   g_abortBtnDownAt = 0;
+  TRACE_BEGIN(TR_RUN, 0);
 
   // Homing
-  oledHeader("Homing...");
-  oled.display();
+  oledScreen(SCREEN_HOMING);
+  oledFlush();
   homeToLimitSafe();
+  cycleMark(STAGE_HOME_START);
 
   if (g_abortRequested) goto abort_cleanup;
 
   {
   // Lowering (no sampling)
-  oledHeader("Running (forward)...");
-  oled.println(F("Lowering..."));
-  oled.display();
+  oledScreen(SCREEN_LOWERING);
+  oledFlush();
   setLED(255, 150, 0);  // Yellow
 
   MotionRequest req;
@@ -833,12 +1185,13 @@ RunResult runTest() {
   req.pulseUs = STEP_PULSE_US;
   req.phase = PHASE_LOWERING;
   requestMotion(req);
+  cycleMark(STAGE_LOWER);
 
   if (g_abortRequested) goto abort_cleanup;
 
   // Forward measurement pass
-  oledHeader("Measuring (FWD)...");
-  oled.display();
+  oledScreen(SCREEN_MEASURING_FWD);
+  oledFlush();
   setLED(0, 255, 255);  // Cyan
 
   req.cmd = CMD_MEASURE_MOVE;
@@ -847,15 +1200,17 @@ RunResult runTest() {
   req.pulseUs = STEP_PULSE_US;
   req.phase = PHASE_MEASURING_FWD;
   requestMotion(req);
+  cycleMark(STAGE_MEASURE_FWD);
 
   if (g_abortRequested) goto abort_cleanup;
 
   // Pause between passes
-  delay(600);
+  halDelayMs(600);
+  cycleMark(STAGE_PAUSE);
 
   // Reverse measurement pass
-  oledHeader("Measuring (REV)...");
-  oled.display();
+  oledScreen(SCREEN_MEASURING_REV);
+  oledFlush();
   setLED(255, 0, 255);  // Magenta
 
   req.cmd = CMD_MEASURE_MOVE;
@@ -864,12 +1219,13 @@ RunResult runTest() {
   req.pulseUs = STEP_PULSE_US;
   req.phase = PHASE_MEASURING_REV;
   requestMotion(req);
+  cycleMark(STAGE_MEASURE_REV);
 
   if (g_abortRequested) goto abort_cleanup;
 
   // Return
-  oledHeader("Returning...");
-  oled.display();
+  oledScreen(SCREEN_RETURNING);
+  oledFlush();
   setLED(255, 150, 0);  // Yellow
 
   req.cmd = CMD_MOVE;
@@ -878,12 +1234,14 @@ RunResult runTest() {
   req.pulseUs = STEP_PULSE_US;
   req.phase = PHASE_RETURNING;
   requestMotion(req);
+  cycleMark(STAGE_RETURN);
 
   homeToLimitSafe();
 
   // Disable stepper
   req.cmd = CMD_DISABLE;
   requestMotion(req, 1000);
+  cycleMark(STAGE_HOME_END);
   }
 
   goto test_complete;  // Skip abort cleanup on normal path
@@ -891,16 +1249,16 @@ RunResult runTest() {
 abort_cleanup:
   {
     Serial.println("TEST ABORTED - homing...");
+    cycleAbort();
     g_collectSamples = false;
     g_abortRequested = false;  // Clear so forced home proceeds
     g_abortBtnDownAt = 0;
-    oledHeader("ABORTED");
-    oled.println(F("Homing..."));
-    oled.display();
+    oledScreen(SCREEN_ABORT_HOMING);
+    oledFlush();
     setLED(255, 0, 0);  // Red
 
     // Wait for button release before homing
-    while (digitalRead(BTN_START) == LOW) delay(10);
+    while (halDigitalRead(BTN_START) == LOW) halDelayMs(10);
 
     homeToLimitForce();
 
@@ -909,15 +1267,15 @@ abort_cleanup:
     requestMotion(reqDis, 1000);
 
     ledOff();
-    oledHeader("ABORTED");
-    oled.println(F("Test cancelled"));
-    oled.display();
-    delay(1500);
+    oledScreen(SCREEN_ABORT_DONE);
+    oledFlush();
+    halDelayMs(1500);
 
     RunResult abortResult;
     abortResult.avgFrictionLb = 0;
     abortResult.cof = 0;
     abortResult.avgBias = 0;
+    TRACE_END(TR_RUN, 0);
     return abortResult;
   }
 
@@ -932,12 +1290,26 @@ test_complete:
   Serial.println(g_fwdSampleCount + g_revSampleCount);
   Serial.println("========================\n");
 
+  // Both passes hold raw readings: convert them in one go
+  if (g_calibration == 0.0f) Serial.println("ERROR: Division by zero - g_calibration is 0!");
+  {
+    PROF_SCOPE(PROF_COUNTS_TO_POUNDS);
+    float c1, c2;
+    calCoefficients(&c1, &c2);
+    countsToPounds(g_fwdSamples, g_fwdSampleCount, g_tareRaw, c1, c2);
+    countsToPounds(g_revSamples, g_revSampleCount, g_tareRaw, c1, c2);
+  }
+
   // Paired midpoint COF calculation (handles trim internally)
   float trimFraction = SEG_TRIM_IN / SEG_MEASURE_IN;
-  CofResult cr = calculateCOF(g_fwdSamples, g_fwdSampleCount,
-                               g_revSamples, g_revSampleCount,
-                               NORMAL_FORCE_LB, trimFraction,
-                               avgPercentileBand);
+  CofResult cr;
+  {
+    PROF_SCOPE(PROF_CALCULATE_COF);
+    cr = calculateCOF(g_fwdSamples, g_fwdSampleCount,
+                      g_revSamples, g_revSampleCount,
+                      NORMAL_FORCE_LB, trimFraction,
+                      profiledPercentileBand);
+  }
 
   Serial.print("Paired samples used: ");
   Serial.println(cr.pairedCount);
@@ -950,19 +1322,24 @@ test_complete:
   Serial.print("Final COF:           ");
   Serial.println(cr.cof, 4);
   Serial.println("========================\n");
+  cycleMark(STAGE_COMPUTE);
 
-  // Test complete - pulse green 3 times
-  pulseLED(0, 255, 0, 3, 300);
+  // Test complete - pulse green 3 times while the dump and results go out
+  ledPulse(0, 255, 0, 3, 300);
+  cycleMark(STAGE_DONE_LED);
 
   RunResult rr;
   rr.avgFrictionLb = cr.avgForceLb;
   rr.cof = cr.cof;
   rr.avgBias = cr.avgBias;
+  TRACE_END(TR_RUN, 0);
   return rr;
 }
 
 // ----------------------------- CSV Data Dump --------------------------------
 void dumpTestDataCSV() {
+  PROF_SCOPE(PROF_CSV_DUMP);
+  TRACE_BEGIN(TR_CSV_DUMP, 0);
   // Raw samples (both passes, untrimmed)
   Serial.println("---CSV_START---");
   Serial.println("pass,index,force_lb");
@@ -985,14 +1362,80 @@ void dumpTestDataCSV() {
   dumpPairedDataCSV(g_fwdSamples, g_fwdSampleCount,
                     g_revSamples, g_revSampleCount,
                     trimFraction);
+
+  // Where this run's time went, up to the dump
+  cyclePrintRunCsv();
+  TRACE_END(TR_CSV_DUMP, 0);
+}
+
+// ----------------------------- Serial Commands ------------------------------
+// Single-character commands, polled while idle:
+//   p  print the profiler table     P  reset it
+//   t  dump the event trace (binary) T  clear it
+//   s  print cycle-time stats (p50/p95 per stage)
+//   i  print shared I2C bus stats    I  reset them
+//   w  toggle the tag-first workflow (saved; NFC_TAG_FIRST_ENABLED builds)
+//   m  cycle the tests per paddle, 1..5 (saved)
+//   q  toggle the calibration fit, linear/quadratic (saved; next calibration)
+//   l  toggle the calibration weights, one/multi-point (saved; next calibration)
+//   c  temperature check point (tare + CAL_WEIGHT_LB), from the idle loop
+//   k  print the temperature model and its points
+void pollSerialCommands() {
+  while (Serial.available() > 0) {
+    int c = Serial.read();
+    switch (c) {
+      case 'p': profilerPrint(); break;
+      case 'P': profilerReset(); Serial.println("Profiler reset"); break;
+      case 't': traceDump(Serial); break;
+      case 'T': traceClear(); Serial.println("Trace cleared"); break;
+      case 's': cycleStatsPrint(); break;
+      case 'r': ioRecordDump(Serial); break;
+      case 'd': displayStatsPrint(); break;
+      case 'D': displayStatsReset(); Serial.println("Display stats reset"); break;
+      case 'i': i2cBusStatsPrint(); break;
+      case 'I': i2cBusStatsReset(); Serial.println("I2C bus stats reset"); break;
+      case 'b': bootPrint(); break;
+      case 'z': tareTrackPrint(); break;
+      case 'n': nfcWriterStatsPrint(); break;
+      case 'w':
+#if NFC_TAG_FIRST_ENABLED
+        g_tagFirst = !g_tagFirst;
+        saveWorkflow();
+        Serial.println(g_tagFirst ? "Workflow: tag first" : "Workflow: tag after test");
+#else
+        Serial.println("Tag-first workflow not built in (NFC_TAG_FIRST_ENABLED)");
+#endif
+        break;
+      case 'm':
+        endPaddle();
+        g_testsPerPaddle = g_testsPerPaddle % TESTS_PER_PADDLE_MAX + 1;
+        saveWorkflow();
+        Serial.print("Tests per paddle: ");
+        Serial.println(g_testsPerPaddle);
+        break;
+      case 'q':
+        g_calOrder = g_calOrder == 1 ? 2 : 1;
+        saveWorkflow();
+        Serial.println(g_calOrder == 2 ? "Calibration fit: quadratic" : "Calibration fit: linear");
+        break;
+      case 'l':
+        g_calMulti = !g_calMulti;
+        saveWorkflow();
+        Serial.println(g_calMulti ? "Calibration weights: multi-point" : "Calibration weights: one");
+        break;
+      case 'c': g_tempCheckRequested = true; break;
+      case 'k': tempModelPrint(); break;
+      default: break;
+    }
+  }
 }
 
 // ----------------------------- Buttons --------------------------------------
 bool readButton(Btn& b, bool& shortPress, bool& longPress) {
   shortPress = false;
   longPress  = false;
-  bool cur = digitalRead(b.pin); // INPUT_PULLUP: LOW when pressed
-  uint32_t now = millis();
+  bool cur = halDigitalRead(b.pin); // INPUT_PULLUP: LOW when pressed
+  uint32_t now = halMillis();
 
   if (cur != b.last && (now - b.lastChange) > DEBOUNCE_MS) {
     b.last = cur;
@@ -1010,190 +1453,130 @@ bool readButton(Btn& b, bool& shortPress, bool& longPress) {
 // ----------------------------- RFID Functions -------------------------------
 // Display COF results with RFID prompt
 void displayTestResults(float cof, int machineID) {
-  oled.clearDisplay();
-
   char cofStr[10];
-  dtostrf(cof, 1, 3, cofStr);
-
-  // Display results - split screen vertically
-  oled.setTextSize(1);
-  oled.setTextColor(SSD1306_WHITE);
+  fmtFixed(cofStr, sizeof(cofStr), cof, 3);
 
-  // Left side: COF value
-  oled.setCursor(0, 8);
-  oled.println("COF");
-  oled.setCursor(0, 18);
-  oled.println("----------");
+  // Split screen: COF label, NFC prompt and skip hint are pre-rendered;
+  // only the value is drawn
+  oledScreen(SCREEN_RESULTS);
   oled.setCursor(0, 28);
   oled.setTextSize(2);
   oled.println(cofStr);
-
-  // Right side: Present NFC prompt
   oled.setTextSize(1);
-  oled.setCursor(75, 20);
-  oled.println("Present");
-  oled.setCursor(80, 30);
-  oled.println("NFC");
+  drawResultPlots();
+
+  oledFlush();
+}
 
-  // Bottom: skip hint
-  oled.setCursor(0, 56);
-  oled.println("hold button to skip");
+// Sparkline of the last test's paired friction against position (min/max
+// per column, dotted line at the reported average) and a histogram of the
+// same values, both scaled to their min..max. Draws into areas the results
+// screen leaves blank, so the flush only adds their pages.
+void drawResultPlots() {
+  PROF_SCOPE(PROF_RESULT_PLOT);
+  long n = 0;
+  const float* paired = cofLastPaired(&n);
+  if (!paired) return;
+
+  decimateMinMax(paired, n, OLED_WIDTH, g_plotMin, g_plotMax);
+  float lo = g_plotMin[0], hi = g_plotMax[0];
+  for (int c = 1; c < OLED_WIDTH; c++) {
+    if (g_plotMin[c] < lo) lo = g_plotMin[c];
+    if (g_plotMax[c] > hi) hi = g_plotMax[c];
+  }
+  float span = (hi > lo) ? hi - lo : 1.0f;
 
-  oled.display();
+  const int bottom = PLOT_SPARK_Y + PLOT_SPARK_H - 1;
+  for (int c = 0; c < OLED_WIDTH; c++) {
+    int yTop = bottom - (int)((g_plotMax[c] - lo) * (PLOT_SPARK_H - 1) / span + 0.5f);
+    int yBot = bottom - (int)((g_plotMin[c] - lo) * (PLOT_SPARK_H - 1) / span + 0.5f);
+    oled.drawFastVLine(c, yTop, yBot - yTop + 1, SSD1306_WHITE);
+  }
+  if (g_lastAvgLb >= lo && g_lastAvgLb <= hi) {
+    int yAvg = bottom - (int)((g_lastAvgLb - lo) * (PLOT_SPARK_H - 1) / span + 0.5f);
+    for (int c = 0; c < OLED_WIDTH; c += 4) oled.drawPixel(c, yAvg, SSD1306_INVERSE);
+  }
+
+  uint16_t peak = histogramBins(paired, n, lo, hi, g_plotBins, PLOT_HIST_BINS);
+  if (!peak) return;
+  for (int b = 0; b < PLOT_HIST_BINS; b++) {
+    if (!g_plotBins[b]) continue;
+    // Any non-empty bin gets at least one pixel
+    int h = (int)(((uint32_t)g_plotBins[b] * PLOT_HIST_H + peak - 1) / peak);
+    oled.fillRect(PLOT_HIST_X + 2 * b, PLOT_HIST_H - h, 2, h, SSD1306_WHITE);
+  }
 }
 
 // Display RFID write success
 void displayRFIDSuccess() {
-  oled.clearDisplay();
-  oled.setTextSize(2);
-  oled.setTextColor(SSD1306_WHITE);
-  oled.setCursor(20, 24);
-  oled.println("Success!");
-  oled.display();
-  pulseLED(0, 255, 0, 2, 300); // Green pulse
-  delay(1500);
+  oledScreen(SCREEN_NFC_SUCCESS);
+  oledFlush();
+  ledPulse(0, 255, 0, 2, 300); // Green pulse
+  halDelayMs(1500);
 }
 
 // Display RFID retry prompt
 void displayRFIDRetry(int attemptsLeft) {
-  oled.clearDisplay();
-  oled.setTextSize(1);
-  oled.setTextColor(SSD1306_WHITE);
-  oled.setCursor(30, 20);
-  oled.println("Try again");
+  oledScreen(SCREEN_NFC_RETRY);
   oled.setCursor(15, 35);
   oled.print("(");
   oled.print(attemptsLeft);
   oled.print(" attempts left)");
-  oled.display();
+  oledFlush();
   setLED(255, 150, 0); // Orange/yellow for retry
-  delay(1000);
+  halDelayMs(1000);
   ledOff();
 }
 
 // Display RFID write final failure
 void displayRFIDFinalFailure() {
-  oled.clearDisplay();
-  oled.setTextSize(1);
-  oled.setTextColor(SSD1306_WHITE);
-  oled.setCursor(15, 20);
-  oled.println("Write failed");
-  oled.setCursor(10, 35);
-  oled.println("Continuing...");
-  oled.display();
-  pulseLED(255, 0, 0, 2, 300); // Red pulse for failure
-  delay(3000);
-}
-
-// Write measurement to RFID tag - single 5-minute poll, no retry screens.
-// Returns: true on success, false on skip (button hold), tag-full, or timeout.
-bool writeToRFID(float cofValue) {
-  Serial.println("Starting RFID write process...");
-  Serial.print("COF value: ");
-  Serial.println(cofValue, 3);
-
-  // Create measurement (CoF type)
-  PaddleDNA::Measurement measurement(
-    PaddleDNA::MeasurementType::CoF,
-    MACHINE_UUID,
-    FIXED_TIMESTAMP,
-    cofValue
-  );
-
-  const unsigned long TAG_WAIT_TIMEOUT = 300000;  // 5 minutes
-  const unsigned long SKIP_HOLD_MS = 2000;
-  unsigned long startTime = millis();
-  unsigned long lastPollTime = 0;
-  bool ledState = false;
-
-  while (millis() - startTime < TAG_WAIT_TIMEOUT) {
-    // Skip if button held >= 2s
-    if (digitalRead(BTN_START) == LOW) {
-      unsigned long holdStart = millis();
-      while (digitalRead(BTN_START) == LOW && (millis() - holdStart < SKIP_HOLD_MS)) {
-        delay(10);
-      }
-      if (millis() - holdStart >= SKIP_HOLD_MS) {
-        ledOff();
-        oled.clearDisplay();
-        oled.setTextSize(1);
-        oled.setTextColor(SSD1306_WHITE);
-        oled.setCursor(36, 24);
-        oled.println("Skipped");
-        oled.display();
-        setLED(255, 150, 0);
-        delay(1000);
-        ledOff();
-        return false;
-      }
-    }
+  oledScreen(SCREEN_NFC_FAILED);
+  oledFlush();
+  ledPulse(255, 0, 0, 2, 300); // Red pulse for failure
+  halDelayMs(3000);
+}
 
-    // Poll every 250ms
-    if (millis() - lastPollTime < 250) {
-      delay(10);
-      continue;
-    }
-    lastPollTime = millis();
-
-    // Blink blue while polling
-    ledState = !ledState;
-    if (ledState) setLED(0, 0, 255); else ledOff();
-
-    String msg;
-    PaddleDNA::AccumulateResult result = accumulator->accumulate(measurement, &msg);
-
-    Serial.print("Accumulate result: ");
-    Serial.print((int)result);
-    Serial.print(" - ");
-    Serial.println(msg);
-
-    switch (result) {
-      case PaddleDNA::AccumulateResult::Success:
-        ledOff();
-        displayRFIDSuccess();
-        return true;
-
-      case PaddleDNA::AccumulateResult::TagFull:
-        ledOff();
-        oled.clearDisplay();
-        oled.setTextSize(1);
-        oled.setTextColor(SSD1306_WHITE);
-        oled.setCursor(15, 16);
-        oled.println("Tag is full!");
-        oled.setCursor(10, 32);
-        oled.println("Use a new tag");
-        oled.display();
-        pulseLED(255, 0, 0, 3, 300);
-        delay(3000);
-        return false;
-
-      case PaddleDNA::AccumulateResult::NoTag:
-      case PaddleDNA::AccumulateResult::ReadError:
-      case PaddleDNA::AccumulateResult::WriteError:
-      case PaddleDNA::AccumulateResult::InvalidPayload:
-      case PaddleDNA::AccumulateResult::CryptoError:
-        // Keep polling silently - stay on the Present NFC screen
-        break;
-    }
+// Outcome of a queued tag write (NfcWriter.h)
+void displayNfcEvent(const NfcWriterEvent& ev) {
+  ledOff();
+  switch (ev.type) {
+    case NFC_EVT_WRITTEN:
+      displayRFIDSuccess();
+      break;
+
+    case NFC_EVT_TAG_FULL:
+      oledScreen(SCREEN_NFC_TAG_FULL);
+      oledFlush();
+      ledPulse(255, 0, 0, 3, 300);
+      halDelayMs(3000);
+      break;
+
+    case NFC_EVT_EXPIRED:   // waited 5 minutes for its tag
+      displayRFIDFinalFailure();
+      break;
   }
+}
 
-  // 5-minute timeout reached
+void displayNfcSkipped() {
+  ledOff();
+  oledScreen(SCREEN_NFC_SKIPPED);
+  oledFlush();
+  setLED(255, 150, 0);
+  halDelayMs(1000);
   ledOff();
-  displayRFIDFinalFailure();
-  return false;
 }
 
 // ----------------------------- Live Force Overlay ---------------------------
 unsigned long g_lastForceDrawMs = 0;
 void updateLiveForceLine(bool forceClear) {
   if (g_motionActive) return; // avoid OLED writes during motion
-  if (!nau.available()) return;
+  long raw;
+  if (!tareTrackLastRaw(&raw)) return;  // the sampling task owns the load cell
 
-  unsigned long now = millis();
+  unsigned long now = halMillis();
   if (!forceClear && (now - g_lastForceDrawMs) < 1000) return; // 1 Hz
   g_lastForceDrawMs = now;
 
-  long raw = nau.getReading();
   float lbs = rawToPounds(raw);
 
   // Draw a single-line overlay at the bottom without clearing the whole screen
@@ -1202,189 +1585,103 @@ void updateLiveForceLine(bool forceClear) {
   oled.setCursor(0, OLED_HEIGHT-10);
   oled.setTextSize(1);
   oled.setTextColor(SSD1306_WHITE);
+  char lbsStr[12];
+  fmtFixed(lbsStr, sizeof(lbsStr), lbs, 3);
   oled.print(F("Force (lb): "));
-  oled.println(String(lbs, 3));
-  oled.display();
+  oled.println(lbsStr);
+  oledFlush();
 }
 
 // ----------------------------- Setup / Loop ---------------------------------
-void setup() {
-  Serial.begin(115200);
-  delay(100);
-  Serial.println("\n\n=== ESP32 Paddle COF Tester Starting ===");
+// Boot steps, in the order of BOOT_TABLE. Each runs once its dependencies
+// are done; the helper-task steps (core >= 0) overlap the others.
 
-  pinMode(PIN_STEP, OUTPUT);
-  pinMode(PIN_DIR, OUTPUT);
-  pinMode(PIN_EN, OUTPUT);
-  pinMode(PIN_LIMIT, INPUT_PULLUP); // active-LOW
-  pinMode(BTN_START, INPUT_PULLUP); // active-LOW
-  Serial.println("GPIO pins configured");
+enum BootStepId {
+  BOOT_IO, BOOT_CRYPTO, BOOT_LOAD_CELL, BOOT_TASKS, BOOT_HOME,
+  BOOT_DISPLAY, BOOT_NFC, BOOT_I2C_CLOCK, BOOT_ACCUMULATOR,
+  BOOT_STEPS
+};
 
+static bool bootIo() {
+  halPinMode(PIN_STEP, OUTPUT);
+  halPinMode(PIN_DIR, OUTPUT);
+  halPinMode(PIN_EN, OUTPUT);
+  halPinMode(PIN_LIMIT, INPUT_PULLUP); // active-LOW
+  halPinMode(BTN_START, INPUT_PULLUP); // active-LOW
   stepperEnable(false);
-  Serial.println("Stepper disabled");
-
-  // Initialize RGB LED
-  Serial.print("Initializing RGB LED on pin ");
-  Serial.println(RGB_LED_PIN);
-  rgbLed.begin();
-  rgbLed.setBrightness(50);
-  rgbLed.show();
-  Serial.println("RGB LED initialized, testing colors...");
-
-  // Test LED with primary colors
-  setLED(255, 0, 0); // Red
-  Serial.println("LED: RED");
-  delay(300);
-  setLED(0, 255, 0); // Green
-  Serial.println("LED: GREEN");
-  delay(300);
-  setLED(0, 0, 255); // Blue
-  Serial.println("LED: BLUE");
-  delay(300);
-  ledOff();
-  Serial.println("LED: OFF");
+  Serial.println("GPIO pins configured, stepper disabled");
 
-  Serial.println("Initializing I2C and OLED...");
-  Wire.begin(I2C_SDA, I2C_SCL);
-  delay(100);  // Critical delay for ESP32-S3 I2C stability
-  oled.begin(SSD1306_SWITCHCAPVCC, OLED_ADDR);
-  oled.clearDisplay();
-  oled.display();
-  Serial.println("OLED ready");
-
-  // Initialize PaddleDNA NFC
-  Serial.println("Initializing PaddleDNA NFC...");
-  if (!nfc.begin(Wire)) {
-    Serial.println(F("NFC initialization failed!"));
-    oled.clearDisplay();
-    oled.setTextSize(1);
-    oled.setCursor(0, 20);
-    oled.println("NFC INIT FAILED!");
-    oled.setCursor(0, 35);
-    oled.println("Check connections");
-    oled.display();
-    pulseLED(255, 0, 0, 5, 300); // Red pulse error
-    delay(3000);
-    // Continue anyway - allow force measurements without RFID
-  } else {
-    Serial.println("NFC initialized successfully");
+  halLedBegin(50);
+  if (!ledAnimatorStart(0, 1)) {   // core 0, with the display task
+    Serial.println("ERROR: Failed to create LED task!");
+    return false;
   }
+  Serial.print("RGB LED initialized on pin ");
+  Serial.println(RGB_LED_PIN);
+  return true;
+}
 
-  // Initialize PaddleDNA Crypto
-  Serial.println("Initializing PaddleDNA Crypto...");
-  if (!crypto.begin(MACHINE_UUID, PRIVATE_KEY)) {
+static bool bootCrypto() {
+  if (!halCryptoBegin(MACHINE_UUID, PRIVATE_KEY)) {
     Serial.println(F("Crypto initialization failed!"));
-    oled.clearDisplay();
-    oled.setTextSize(1);
-    oled.setCursor(0, 20);
-    oled.println("CRYPTO INIT FAILED!");
-    oled.display();
-    pulseLED(255, 0, 0, 5, 300);
-    delay(3000);
-    // Continue anyway
-  } else {
-    Serial.println("Crypto initialized successfully");
+    return false;  // continue anyway
   }
+  Serial.println("Crypto initialized successfully");
+  return true;
+}
 
-  // Create MeasurementAccumulator (paddle UUID auto-detected from tag)
-  Serial.println("Creating MeasurementAccumulator...");
-  accumulator = new PaddleDNA::MeasurementAccumulator(nfc, crypto, 9);
-  Serial.println("MeasurementAccumulator created successfully");
-
-  Serial.println("Initializing NAU7802 load cell...");
-  Wire1.begin(NAU_SDA, NAU_SCL);
-  if (!nau.begin(Wire1)) {
-    Serial.println("ERROR: NAU7802 not detected!");
-    oled.clearDisplay();
-    oled.setCursor(0, 0);
-    oled.setTextSize(1);
-    oled.setTextColor(SSD1306_WHITE);
-    oled.println("NAU7802 NOT FOUND!");
-    oled.display();
-    pulseLED(255, 0, 0, 5, 300);
-    delay(3000);
-  }
-  nau.setGain(NAU7802_GAIN_128);
-  nau.setSampleRate(NAU7802_SPS_320);
-  nau.calibrateAFE();
+static bool bootLoadCell() {
+  bool ok = halLoadCellBegin();
+  if (!ok) Serial.println("ERROR: NAU7802 not detected!");
+  halLoadCellCalibrateAFE();
   loadCalibration();
+  loadTempModel();
   Serial.print("Calibration loaded: ");
   Serial.print(g_calibration);
   Serial.print(" counts/lb, Tare: ");
   Serial.println(g_tareRaw);
+  if (g_calPoints) {
+    Serial.print("Calibration fit: ");
+    Serial.print(g_calCurve != 0.0f ? "quadratic" : "linear");
+    Serial.print(", ");
+    Serial.print(g_calPoints);
+    Serial.print(" weights, residual rms ");
+    Serial.print(g_calRmsLb, 4);
+    Serial.print(" lb, max ");
+    Serial.print(g_calMaxLb, 4);
+    Serial.println(" lb");
+  }
+  return ok;
+}
 
-  // Auto-tare on boot. Doesn't affect COF (paired math cancels offset),
-  // but keeps the live force overlay honest after thermal/mechanical drift.
-  setLED(255, 0, 0);
-  g_tareRaw = nauReadRawAvg(HX_SAMPLES_TARE);
-  ledOff();
-  Serial.print("Auto-tare on boot: ");
-  Serial.println(g_tareRaw);
-
-  // ========== DUAL-CORE TASK INITIALIZATION ==========
-  Serial.println("\n=== Initializing Dual-Core Architecture ===");
-  Serial.print("setup() running on core: ");
-  Serial.println(xPortGetCoreID());
-
-  // Create inter-core communication
-  Serial.println("Creating motion command queue...");
-  motionCommandQueue = xQueueCreate(5, sizeof(MotionRequest));
+static bool bootTasks() {
+  bool ok = true;
+  motionCommandQueue = halQueueCreate(5, sizeof(MotionRequest));
   if (motionCommandQueue == NULL) {
     Serial.println("ERROR: Failed to create motion queue!");
+    ok = false;
   }
-
-  Serial.println("Creating motion complete semaphore...");
-  motionCompleteSemaphore = xSemaphoreCreateBinary();
+  motionCompleteSemaphore = halSemCreateBinary();
   if (motionCompleteSemaphore == NULL) {
     Serial.println("ERROR: Failed to create semaphore!");
+    ok = false;
   }
 
-  Serial.println("Creating motion task on Core 1 (high priority)...");
-  BaseType_t motionTaskCreated = xTaskCreatePinnedToCore(
-    motionTask,           // Function
-    "Motion",             // Name
-    4096,                 // Stack size (bytes)
-    NULL,                 // Parameter
-    3,                    // Priority (high - above default 1)
-    NULL,                 // Task handle
-    1                     // Core 1
-  );
-
-  if (motionTaskCreated != pdPASS) {
+  // Motion on core 1, above the default priority 1
+  if (!halTaskCreate(motionTask, "Motion", 4096, NULL, 3, 1)) {
     Serial.println("ERROR: Failed to create motion task!");
-  } else {
-    Serial.println("Motion task created successfully");
+    ok = false;
   }
-
-  Serial.println("Creating force sampling task on Core 0 (medium priority)...");
-  BaseType_t samplingTaskCreated = xTaskCreatePinnedToCore(
-    forceSamplingTask,
-    "ForceSample",
-    4096,
-    NULL,
-    2,                    // Priority (medium)
-    &forceSamplingTaskHandle,
-    0                     // Core 0
-  );
-
-  if (samplingTaskCreated != pdPASS) {
+  // Force sampling on core 0, medium priority
+  if (!halTaskCreate(forceSamplingTask, "ForceSample", 4096, NULL, 2, 0)) {
     Serial.println("ERROR: Failed to create sampling task!");
-  } else {
-    Serial.println("Force sampling task created successfully");
+    ok = false;
   }
+  if (ok) Serial.println("Motion and force sampling tasks created");
+  return ok;
+}
 
-  delay(200);  // Let tasks initialize
-  Serial.println("=== Dual-Core Architecture Initialized ===\n");
-  // ====================================================
-
-  showSplash();
-  Serial.println("Starting rainbow cycle...");
-  rainbowCycle(2000); // 2 second rainbow cycle on power-up
-  Serial.println("Rainbow cycle complete");
-  delay(500);
-
-  // Initialization homing sequence (keep "Powering On..." splash on screen)
-  Serial.println("Checking limit switch...");
+static bool bootHome() {
   if (!limitHit()) {
     Serial.println("Not at limit, starting homing sequence...");
     homeToLimitSafe();
@@ -1392,55 +1689,205 @@ void setup() {
   } else {
     Serial.println("Already at home position");
   }
-
   stepperEnable(false);
+  return true;
+}
+
+static bool bootDisplay() {
+  halI2cBegin();
+  halDelayMs(100);  // Critical delay for ESP32-S3 I2C stability
+  halDisplayBegin();
+  showSplash();     // "Powering On..." stays up until the idle screen
+  // Below sampling: flushes never delay a sample
+  if (!displayTaskStart(0, 1)) {
+    Serial.println("ERROR: Failed to create display task!");
+    return false;
+  }
+  Serial.println("OLED ready, display task created");
+  return true;
+}
+
+static bool bootNfc() {
+  if (!halNfcBegin()) {
+    Serial.println(F("NFC initialization failed!"));
+    return false;  // continue anyway - allow force measurements without RFID
+  }
+  Serial.println("NFC initialized successfully");
+  return true;
+}
+
+static bool bootI2cClock() {
+  // Shared bus runs at the Wire default until both devices have been probed
+  uint32_t i2cHz = halI2cProbeClock(I2C_MAX_CLOCK_HZ);
+  Serial.print("I2C bus: ");
+  Serial.print(i2cHz / 1000);
+  Serial.println(" kHz");
+  displayInvalidate();  // repaint in full at the new clock
+  return true;
+}
+
+static bool bootAccumulator() {
+  // Paddle UUID is auto-detected from the tag
+  halNfcAccumulatorBegin(9);
+  Serial.println("MeasurementAccumulator created successfully");
+  // Tag writes run beside the tests, on core 0 below the sampling task
+  if (!nfcWriterStart(MACHINE_UUID, 0, 1)) {
+    Serial.println("ERROR: Failed to create NFC writer task!");
+    return false;
+  }
+  return true;
+}
+
+// NFC and crypto bring-up, the display, the load cell's AFE calibration
+// and homing run concurrently. The helpers all go to core 0: homing keeps
+// core 1 busy stepping at priority 3, setup() just waits for it there.
+// There is no tare step: the sampling task tracks the tare once idle.
+static const BootStep BOOT_TABLE[BOOT_STEPS] = {
+  { "io",          bootIo,          0,                          BOOT_IN_CALLER },
+  { "crypto",      bootCrypto,      BOOT_AFTER(BOOT_IO),        0 },
+  { "load_cell",   bootLoadCell,    BOOT_AFTER(BOOT_IO),        0 },
+  { "tasks",       bootTasks,       BOOT_AFTER(BOOT_IO),        BOOT_IN_CALLER },
+  { "home",        bootHome,        BOOT_AFTER(BOOT_TASKS),     BOOT_IN_CALLER },
+  { "display",     bootDisplay,     BOOT_AFTER(BOOT_IO),        0 },
+  { "nfc",         bootNfc,         BOOT_AFTER(BOOT_DISPLAY),   0 },
+  { "i2c_clock",   bootI2cClock,    BOOT_AFTER(BOOT_NFC),       0 },
+  { "accumulator", bootAccumulator, BOOT_AFTER(BOOT_NFC) | BOOT_AFTER(BOOT_CRYPTO), 0 },
+};
+
+// Helper tasks leave the OLED alone; failures are shown together at the end
+static void showBootFailures(uint16_t failed) {
+  oledHeader("Boot errors");
+  if (failed & BOOT_AFTER(BOOT_NFC))       oled.println(F("NFC INIT FAILED!"));
+  if (failed & BOOT_AFTER(BOOT_CRYPTO))    oled.println(F("CRYPTO INIT FAILED!"));
+  if (failed & BOOT_AFTER(BOOT_LOAD_CELL)) oled.println(F("NAU7802 NOT FOUND!"));
+  if (failed & ~(BOOT_AFTER(BOOT_NFC) | BOOT_AFTER(BOOT_CRYPTO) |
+                 BOOT_AFTER(BOOT_LOAD_CELL))) {
+    oled.println(F("SETUP FAILED!"));
+  }
+  oled.println(F("Check connections"));
+  oledFlush();
+  ledPulse(255, 0, 0, 5, 300); // Red pulse error
+  halDelayMs(3000);
+}
+
+void setup() {
+  Serial.begin(115200);
+  halDelayMs(100);
+  Serial.println("\n\n=== ESP32 Paddle COF Tester Starting ===");
+
+  halBegin(HAL_CONFIG);
+
+  uint16_t failed = bootRun(BOOT_TABLE, BOOT_STEPS);
+  if (failed) showBootFailures(failed);
+
+  // LED self-test, then the power-up rainbow: cosmetic, they play on
+  // while the tester is already idle
+  ledPlay(LED_SELF_TEST, 4);
+  ledRainbow(2000, true);
+
+  bootReady();
+  Serial.print("Boot ready in ");
+  Serial.print(bootReadyMs());
+  Serial.println(" ms");
+  bootPrint();
 
   // Boot calibration: if START button is held during power-up, enter calibration
-  if (digitalRead(BTN_START) == LOW) {
+  if (halDigitalRead(BTN_START) == LOW) {
     Serial.println("START button held at boot - entering calibration mode");
     oledHeader("Boot Calibration");
     oled.println(F("Button held..."));
-    oled.display();
+    oledFlush();
     // Wait for release before starting calibration
-    while (digitalRead(BTN_START) == LOW) delay(10);
-    delay(200);
-    doCalibration3lb();
+    while (halDigitalRead(BTN_START) == LOW) halDelayMs(10);
+    halDelayMs(200);
+    doCalibration();
   }
 
   Serial.println("=== Setup complete, entering main loop ===\n");
 }
 
 void loop() {
-  // Idle screen
-  Serial.println("Entering idle state");
-  ledOff(); // Turn off LED during idle
-  oled.clearDisplay();
-  oled.setTextColor(SSD1306_WHITE);
-  // "Paddle COF" = 10 chars * 12px = 120px @ size 2; center in 128px
-  oled.setTextSize(2);
-  oled.setCursor(4, 12);
-  oled.print(F("Paddle COF"));
-  // "press button to start" = 21 chars * 6px = 126px @ size 1
-  oled.setTextSize(1);
-  oled.setCursor(1, 36);
-  oled.print(F("press button to test paddle"));
-  if (g_hasResult) {
-    oled.setCursor(0, 54);
-    oled.print(F("Last test: "));
-    oled.print(String(g_lastCOF, 3));
+  // Idle screen, unless the last result's screen is still asking for its tag
+  if (!g_resultShown) {
+    Serial.println("Entering idle state");
+    oledScreen(SCREEN_IDLE);
+    uint8_t pending = nfcWriterPending();
+    if (pending) {
+      oled.setCursor(0, 0);
+      oled.print(pending);
+      oled.print(F(" awaiting NFC tag"));
+    }
+    if (g_hasResult) {
+      oled.setCursor(0, 54);
+      oled.print(F("Last test: "));
+      char cofStr[10];
+      fmtFixed(cofStr, sizeof(cofStr), g_lastCOF, 3);
+      oled.print(cofStr);
+    }
+    oledFlush();
   }
-  oled.display();
+  // Blink blue while results wait for their tags, once any pulse is done
+  if (nfcWriterPending()) ledPlayNext(LED_TAG_WAIT, 2, LED_FOREVER);
+  else                    ledOff();
 
   g_motionActive = false;
+  // Auto-tare in the background while idle and unloaded. Doesn't affect
+  // COF (paired math cancels offset), but keeps the force readings honest
+  // after thermal/mechanical drift.
+  tareTrackStart((long)(TARE_MAX_SPREAD_LB * fabsf(g_calibration)),
+                 (long)(TARE_MAX_STEP_LB * fabsf(g_calibration)));
   while (true) {
+    if (tareTrackValid()) g_tareRaw = tareTrackCurrent();
+
+    // A queued result reached its tag (or gave up): show it, then idle
+    NfcWriterEvent ev;
+    if (nfcWriterPollEvent(&ev)) {
+      g_resultShown = false;
+      displayNfcEvent(ev);
+      break;
+    }
+
+    if (g_tempCheckRequested) {
+      g_tempCheckRequested = false;
+      doTempCheck();
+      g_resultShown = false;
+      break;   // back through the idle screen; tracking restarts
+    }
+
     bool sp=false, lp=false;
     readButton(btnStart, sp, lp);
+    if (lp && nfcWriterSkipOldest()) {
+      Serial.println("Oldest NFC result skipped");
+      g_resultShown = false;
+      displayNfcSkipped();
+      break;
+    }
+    if (sp && nfcWriterFull()) {
+      Serial.println(HAL_NFC_TAG_UUID ? "NFC queue full - present a tag or hold START to skip"
+                                      : "NFC result waiting - present its tag or hold START to skip");
+      endPaddle();   // so its tag can take what it has
+      ledPulse(255, 0, 0, 1, 300);
+      sp = false;
+    }
     if (sp) {
       Serial.println("START button pressed - Running test...");
+      g_testsRun++;
+      g_resultShown = false;
+      tareTrackStop();
+      if (tareTrackValid()) g_tareRaw = tareTrackCurrent();
+      tempCompApply();
+      // The record carries the calibration as this test applies it
+      ioRecordBegin(g_calibration * g_gainComp, g_calCurve / (g_gainComp * g_gainComp),
+                    g_tareRaw);
+      cycleBegin();
+      // Tag first: the paddle's tag is read while it is tested
+      if (g_tagFirst) nfcWriterPrefetch();
       RunResult r = runTest();
 
       // Check if test was aborted (COF == 0)
       if (r.cof == 0 && r.avgFrictionLb == 0) {
+        if (g_tagFirst) nfcWriterPrefetchCancel();
+        ioRecordEnd();
         Serial.println("Test was aborted, returning to idle");
         break;
       }
@@ -1453,22 +1900,32 @@ void loop() {
       Serial.println(r.cof, 3);
 
       dumpTestDataCSV();
+      cycleMark(STAGE_CSV_DUMP);
 
-      // Display results with "Present NFC tag..." message
+      // Display results with "Present NFC tag..." message. The tag is
+      // written in the background; the next test can start right away.
       displayTestResults(r.cof, MACHINE_ID);
-
-      // Write to RFID tag (with retry and abort handling)
-      Serial.println("Entering RFID write mode...");
-      bool rfidSuccess = writeToRFID(r.cof);
-
-      if (rfidSuccess) {
-        Serial.println("RFID write successful");
+      bool more = ++g_paddleTest < g_testsPerPaddle;
+      if (more) {
+        oled.setCursor(75, 40);
+        oled.print(F("test "));
+        oled.print(g_paddleTest);
+        oled.print('/');
+        oled.print(g_testsPerPaddle);
+        oledFlush();
       } else {
-        Serial.println("RFID write failed or aborted");
+        g_paddleTest = 0;
       }
+      nfcWriterQueue(r.cof, FIXED_TIMESTAMP, more);
+      g_resultShown = true;
+      cycleMark(STAGE_NFC);
+      cycleEnd();
+      ioRecordEnd();
+      cyclePrintLast();
 
       break; // back to idle
     }
-    delay(10);
+    pollSerialCommands();
+    halDelayMs(10);
   }
 }
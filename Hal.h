@@ -0,0 +1,243 @@
+#ifndef HAL_H
+#define HAL_H
+
+#include <Arduino.h>
+
+// ---------------------------------------------------------------------------
+// Hardware abstraction layer
+// ---------------------------------------------------------------------------
+// Thin link-time interfaces between the tester logic and the platform.
+// HalEsp32.cpp implements them on the device (Arduino core, FreeRTOS,
+// NAU7802, SSD1306, PaddleDNA). host/src/HalHost.cpp implements them on
+// Linux with std::thread and simulated peripherals. Exactly one
+// implementation is linked into a build; there is no runtime dispatch.
+
+// ---------------------------------------------------------------------------
+// Board wiring, handed to halBegin() from the USER CONFIG section
+// ---------------------------------------------------------------------------
+struct HalConfig {
+  uint8_t pinStep;
+  uint8_t pinDir;
+  uint8_t pinEnable;
+  uint8_t pinLimit;
+  uint8_t pinButton;
+  uint8_t pinRgbLed;
+  uint8_t i2cSda;     // shared bus (OLED + RFID)
+  uint8_t i2cScl;
+  uint8_t nauSda;     // load cell bus
+  uint8_t nauScl;
+  uint8_t oledAddr;
+  uint8_t pinNfcIrq;  // reader IRQ (active-LOW), or HAL_NO_PIN
+};
+
+#define HAL_NO_PIN 0xFF
+
+void halBegin(const HalConfig& cfg);
+
+// Task primitive handles, opaque per platform (see Task primitives)
+typedef struct HalQueueImpl* HalQueue;
+typedef struct HalSemImpl*   HalSemaphore;
+
+// ---------------------------------------------------------------------------
+// Clock
+// ---------------------------------------------------------------------------
+uint32_t halMillis();
+uint32_t halMicros();
+void     halDelayMs(uint32_t ms);
+void     halDelayUs(uint32_t us);
+
+// CPU cycle counter for profiling (wraps; take differences only)
+uint32_t halCycleCount();
+uint32_t halCpuFreqMhz();
+
+// ---------------------------------------------------------------------------
+// GPIO (stepper driver, limit switch, button)
+// ---------------------------------------------------------------------------
+void halPinMode(uint8_t pin, uint8_t mode);
+void halDigitalWrite(uint8_t pin, uint8_t level);
+int  halDigitalRead(uint8_t pin);
+
+// ---------------------------------------------------------------------------
+// RGB status LED
+// ---------------------------------------------------------------------------
+void halLedBegin(uint8_t brightness);
+void halLedSet(uint8_t r, uint8_t g, uint8_t b);
+void halLedOff();
+
+// ---------------------------------------------------------------------------
+// Display (SSD1306 128x64 on the shared I2C bus)
+// ---------------------------------------------------------------------------
+// HalDisplay exposes the Adafruit_GFX drawing subset used by the sketch.
+#if defined(ARDUINO)
+#include <Adafruit_SSD1306.h>
+typedef Adafruit_SSD1306 HalDisplay;
+#else
+#include "SimDisplay.h"
+typedef SimDisplay HalDisplay;
+#endif
+
+HalDisplay& halDisplay();
+void        halI2cBegin();                 // shared OLED/RFID bus
+bool        halDisplayBegin();
+
+// Shared bus clock. halI2cProbeClock() steps down HAL_I2C_CLOCKS from maxHz
+// and keeps the first clock at which the OLED acknowledges repeatedly and
+// the NFC reader (if halNfcBegin() found one) completes its init exchange.
+// Call after halDisplayBegin() and halNfcBegin(). Returns the clock in Hz;
+// the bus stays at the Wire default (100 kHz) until then.
+#define HAL_I2C_CLOCKS { 1000000UL, 800000UL, 400000UL, 100000UL }
+uint32_t    halI2cProbeClock(uint32_t maxHz);
+uint32_t    halI2cClockHz();
+
+// Writes the rectangle pages page0..page1 x columns col0..col1 of a
+// page-major 128-column frame straight to the panel's GDDRAM: one addressing
+// transaction, then the rows back to back in data transactions of at most
+// I2C_DISPLAY_SLICE_US of bus time each (I2cBus.h). Yields the shared bus
+// to a waiting NFC transfer between them. Returns the bytes put on the bus,
+// addressing and control bytes included.
+uint32_t    halDisplayWriteRect(uint8_t page0, uint8_t page1, uint8_t col0,
+                                uint8_t col1, const uint8_t* frame);
+
+// ---------------------------------------------------------------------------
+// Load cell (NAU7802, gain 128, 320 SPS, on its own I2C bus)
+// ---------------------------------------------------------------------------
+bool halLoadCellBegin();
+void halLoadCellCalibrateAFE();
+bool halLoadCellAvailable();
+long halLoadCellRead();
+
+// Internal temperature sensor, in °C by the datasheet's nominal transfer
+// (109 mV at 25 °C, +360 µV/°C): good for changes more than absolutes.
+// Switches the converter to the sensor at gain 1 and back, which takes
+// about HAL_TEMP_READ_MS of conversions; load-cell readings due meanwhile
+// are dropped. Only while nothing else reads the load cell.
+#define HAL_TEMP_READ_MS 30
+bool halLoadCellReadTempC(float* degC);
+
+// ---------------------------------------------------------------------------
+// Persistent storage (NVS Preferences on the device)
+// ---------------------------------------------------------------------------
+bool  halPrefsBegin(const char* ns, bool readOnly);
+void  halPrefsEnd();
+float halPrefsGetFloat(const char* key, float defaultValue);
+void  halPrefsPutFloat(const char* key, float value);
+long  halPrefsGetLong(const char* key, long defaultValue);
+void  halPrefsPutLong(const char* key, long value);
+
+// ---------------------------------------------------------------------------
+// NFC / PaddleDNA
+// ---------------------------------------------------------------------------
+// Released PaddleDNA writes through MeasurementAccumulator::accumulate(),
+// which finds the tag itself and does not say which paddle it belongs to.
+// Build with -DHAL_NFC_TAG_UUID=1 against a PaddleDNA whose NFC class has
+// readPaddleUuid() for halNfcDetectTag() and UUID-checked writes.
+#ifndef HAL_NFC_TAG_UUID
+#define HAL_NFC_TAG_UUID 0
+#endif
+
+// Mirrors PaddleDNA::AccumulateResult so callers stay library-agnostic.
+enum HalNfcResult {
+  HAL_NFC_SUCCESS,
+  HAL_NFC_NO_TAG,
+  HAL_NFC_TAG_FULL,
+  HAL_NFC_READ_ERROR,
+  HAL_NFC_WRITE_ERROR,
+  HAL_NFC_INVALID_PAYLOAD,
+  HAL_NFC_CRYPTO_ERROR,
+  HAL_NFC_WRONG_TAG       // HAL only: not the paddle the write was meant for
+};
+
+bool halNfcBegin();
+bool halCryptoBegin(const uint8_t machineUuid[16], const uint8_t privateKey[32]);
+void halNfcAccumulatorBegin(uint8_t maxMeasurements);
+
+// Tag discovery only: true if a tag answered, with the paddle UUID its
+// records are keyed by (the one accumulate() writes under). Needs
+// HAL_NFC_TAG_UUID.
+bool halNfcDetectTag(uint8_t paddleUuid[16]);
+
+// Card detect: puts the reader in its low-power card-detect mode, where it
+// watches the field without bus traffic and pulls its IRQ line when a tag
+// is in it. The IRQ gives wake once; arm again after each wake. The next
+// reader call takes the reader out of the mode. False if the board has no
+// IRQ line (pinNfcIrq is HAL_NO_PIN) or the reader cannot: poll instead.
+// Entering the mode needs NFC::enterCardDetect(), which released PaddleDNA
+// does not have; build with -DHAL_NFC_CARD_DETECT=1 against one that does.
+#ifndef HAL_NFC_CARD_DETECT
+#define HAL_NFC_CARD_DETECT 0
+#endif
+bool halNfcArmTagIrq(HalSemaphore wake);
+
+// Appends count CoF measurements (cofs[i] taken at timestamps[i]) to the
+// tag in the field, within one acquisition of the bus. Released PaddleDNA
+// only has accumulate(), so each measurement is its own tag discovery and
+// read-modify-write. Build with -DHAL_NFC_STAGED_COMMIT=1 against a
+// PaddleDNA whose MeasurementAccumulator has openSession(),
+// stageMeasurement(), commitSession() and closeSession() to write them all
+// in a single write of the tag's payload instead.
+//
+// *written receives how many went onto the tag: all of them with
+// HAL_NFC_SUCCESS, the first ones that still fit with HAL_NFC_TAG_FULL.
+// With any other result, none did in a staged commit; without one, the
+// ones before the failure did. If paddleUuid is not NULL, the tag
+// found must carry it: any other tag is refused with HAL_NFC_WRONG_TAG and
+// nothing is written (without HAL_NFC_TAG_UUID the tag cannot be checked
+// and is always refused). msg receives the library's status text
+// (truncated to msgLen).
+#ifndef HAL_NFC_STAGED_COMMIT
+#define HAL_NFC_STAGED_COMMIT 0
+#endif
+#define HAL_NFC_MAX_BATCH 8
+HalNfcResult halNfcAccumulate(const uint8_t machineUuid[16], const uint8_t* paddleUuid,
+                              const uint32_t* timestamps, const float* cofs, uint8_t count,
+                              uint8_t* written, char* msg, size_t msgLen);
+
+// Tag-first session: open discovers the tag and reads its records once,
+// keeping them cached; commit appends measurements as halNfcAccumulate()
+// does and writes them back to the same tag without discovering or reading
+// it again. Commit closes the session whatever the result; close drops one
+// that is not needed. Needs the staged-commit session API and tag UUIDs to
+// match the session to its result: the tag-first workflow is built only
+// with -DNFC_TAG_FIRST_ENABLED=1 -DHAL_NFC_TAG_UUID=1
+// -DHAL_NFC_STAGED_COMMIT=1.
+#ifndef NFC_TAG_FIRST_ENABLED
+#define NFC_TAG_FIRST_ENABLED 0
+#endif
+#if NFC_TAG_FIRST_ENABLED && !(HAL_NFC_TAG_UUID && HAL_NFC_STAGED_COMMIT)
+#error "NFC_TAG_FIRST_ENABLED needs HAL_NFC_TAG_UUID and HAL_NFC_STAGED_COMMIT"
+#endif
+HalNfcResult halNfcSessionOpen(uint8_t paddleUuid[16], char* msg, size_t msgLen);
+HalNfcResult halNfcSessionCommit(const uint8_t machineUuid[16], const uint32_t* timestamps,
+                                 const float* cofs, uint8_t count, uint8_t* written,
+                                 char* msg, size_t msgLen);
+void         halNfcSessionClose();
+
+// ---------------------------------------------------------------------------
+// Task primitives
+// ---------------------------------------------------------------------------
+typedef void (*HalTaskFn)(void* arg);
+
+const uint32_t HAL_WAIT_FOREVER = 0xFFFFFFFFu;
+
+bool halTaskCreate(HalTaskFn fn, const char* name, uint32_t stackBytes,
+                   void* arg, int priority, int core);
+void halTaskDelayMs(uint32_t ms);    // yields to other tasks
+void halTaskExit();                  // ends the calling task; a task function
+                                     // must end with it, never just return
+int  halCoreId();
+void halDisableCore1Wdt();
+
+HalQueue halQueueCreate(uint32_t length, uint32_t itemSize);
+bool     halQueueSend(HalQueue q, const void* item, uint32_t timeoutMs);
+bool     halQueueReceive(HalQueue q, void* item, uint32_t timeoutMs);
+
+HalSemaphore halSemCreateBinary();
+bool         halSemGive(HalSemaphore s);
+bool         halSemTake(HalSemaphore s, uint32_t timeoutMs);
+
+// Short critical section shared by both cores. Not reentrant; keep the
+// body to a few memory operations (no blocking or HAL I/O calls).
+void halCriticalEnter();
+void halCriticalExit();
+
+#endif // HAL_H
@@ -0,0 +1,526 @@
+#include "Hal.h"
+#include "I2cBus.h"
+#include "IoRecorder.h"
+#include <Wire.h>
+#include <Adafruit_GFX.h>
+#include <Adafruit_SSD1306.h>
+#include <SparkFun_Qwiic_Scale_NAU7802_Arduino_Library.h>
+#include <Preferences.h>
+#include <Adafruit_NeoPixel.h>
+#include <PaddleDNA.h>
+#include <esp_cpu.h>
+
+// ---------------------------------------------------------------------------
+// Device drivers (owned here; the sketch only sees Hal.h)
+// ---------------------------------------------------------------------------
+
+static HalConfig          s_cfg;
+static NAU7802            s_nau;
+static Preferences        s_prefs;
+static Adafruit_NeoPixel  s_rgbLed;
+
+static PaddleDNA::NFC                         s_nfc;
+static PaddleDNA::Crypto                      s_crypto;
+static PaddleDNA::MeasurementAccumulator*     s_accumulator = nullptr;
+
+void halBegin(const HalConfig& cfg) {
+  s_cfg = cfg;
+  ioRecordConfigure(cfg);
+}
+
+// ---------------------------------------------------------------------------
+// Clock
+// ---------------------------------------------------------------------------
+uint32_t halMillis()              { return millis(); }
+uint32_t halMicros()              { return micros(); }
+void     halDelayMs(uint32_t ms)  { delay(ms); }
+void     halDelayUs(uint32_t us)  { delayMicroseconds(us); }
+uint32_t halCycleCount()          { return (uint32_t)esp_cpu_get_cycle_count(); }
+uint32_t halCpuFreqMhz()          { return getCpuFrequencyMhz(); }
+
+// ---------------------------------------------------------------------------
+// GPIO
+// ---------------------------------------------------------------------------
+void halPinMode(uint8_t pin, uint8_t mode)        { pinMode(pin, mode); }
+
+void halDigitalWrite(uint8_t pin, uint8_t level) {
+  digitalWrite(pin, level);
+  ioRecordPinWrite(pin, level);
+}
+
+int halDigitalRead(uint8_t pin) {
+  int level = digitalRead(pin);
+  ioRecordPinRead(pin, level);
+  return level;
+}
+
+// ---------------------------------------------------------------------------
+// RGB LED
+// ---------------------------------------------------------------------------
+void halLedBegin(uint8_t brightness) {
+  s_rgbLed.updateType(NEO_GRB + NEO_KHZ800);
+  s_rgbLed.updateLength(1);
+  s_rgbLed.setPin(s_cfg.pinRgbLed);
+  s_rgbLed.begin();
+  s_rgbLed.setBrightness(brightness);
+  s_rgbLed.show();
+}
+
+void halLedSet(uint8_t r, uint8_t g, uint8_t b) {
+  s_rgbLed.setPixelColor(0, s_rgbLed.Color(r, g, b));
+  s_rgbLed.show();
+}
+
+void halLedOff() {
+  s_rgbLed.clear();
+  s_rgbLed.show();
+}
+
+// ---------------------------------------------------------------------------
+// Display
+// ---------------------------------------------------------------------------
+HalDisplay& halDisplay() {
+  // 128x64, matches OLED_WIDTH/OLED_HEIGHT in the sketch. The library
+  // switches Wire to 400 kHz for its own transfers and back to 100 kHz after;
+  // only begin() (before the clock probe) and the DISPLAY_TASK_ENABLED=0
+  // fallback still go through it.
+  static Adafruit_SSD1306 display(128, 64, &Wire);
+  return display;
+}
+
+// Wire's transmit buffer sized for a whole frame plus its control byte, so
+// display data transactions are limited by the bus slice, not the buffer
+// (a full-screen refresh at 400 kHz is 1 + 5 transactions instead of
+// Adafruit_SSD1306's eleven). Resizing only works before Wire.begin().
+static const size_t I2C_TXN_BYTES = 1 + 128 * 8;
+
+#ifndef I2C_BUFFER_LENGTH
+#define I2C_BUFFER_LENGTH 32
+#endif
+
+static size_t   s_i2cBufBytes = I2C_BUFFER_LENGTH;
+static uint32_t s_i2cHz       = 100000;   // Wire default until the probe
+static bool     s_nfcPresent  = false;
+
+void halI2cBegin() {
+  if (Wire.setBufferSize(I2C_TXN_BYTES) == I2C_TXN_BYTES) s_i2cBufBytes = I2C_TXN_BYTES;
+  Wire.begin(s_cfg.i2cSda, s_cfg.i2cScl);
+  i2cBusBegin();   // the display task and NFC transfers share Wire
+}
+
+static bool i2cAcks(uint8_t addr) {
+  Wire.beginTransmission(addr);
+  return Wire.endTransmission() == 0;
+}
+
+uint32_t halI2cProbeClock(uint32_t maxHz) {
+  static const uint32_t clocks[] = HAL_I2C_CLOCKS;
+  uint32_t chosen = 100000;
+  i2cBusAcquire(I2C_CLIENT_NFC);
+  for (size_t i = 0; i < sizeof(clocks) / sizeof(clocks[0]); i++) {
+    if (clocks[i] > maxHz) continue;
+    Wire.setClock(clocks[i]);
+    bool ok = true;
+    // An ACK alone says little about signal margin; ask several times
+    for (int n = 0; n < 16 && ok; n++) ok = i2cAcks(s_cfg.oledAddr);
+    // The reader has to get through a real command/response exchange
+    if (ok && s_nfcPresent) ok = s_nfc.begin(Wire);
+    if (ok) {
+      chosen = clocks[i];
+      break;
+    }
+  }
+  Wire.setClock(chosen);
+  s_i2cHz = chosen;
+  i2cBusRelease();
+  return chosen;
+}
+
+uint32_t halI2cClockHz() { return s_i2cHz; }
+
+bool halDisplayBegin() {
+  i2cBusAcquire(I2C_CLIENT_DISPLAY);
+  bool ok = halDisplay().begin(SSD1306_SWITCHCAPVCC, s_cfg.oledAddr);
+  i2cBusRelease();
+  return ok;
+}
+
+uint32_t halDisplayWriteRect(uint8_t page0, uint8_t page1, uint8_t col0,
+                             uint8_t col1, const uint8_t* frame) {
+  // Data transactions are capped at I2C_DISPLAY_SLICE_US of bus time (well
+  // inside Wire's 50 ms timeout), the longest an NFC transfer waits for the
+  // bus, and at the buffer, minus the control byte
+  uint32_t cap = s_i2cHz / 9 * I2C_DISPLAY_SLICE_US / 1000000;
+  if (cap > s_i2cBufBytes - 1) cap = s_i2cBufBytes - 1;
+  const uint16_t span = col1 - col0 + 1;
+  uint32_t bytes = 0;
+
+  i2cBusAcquire(I2C_CLIENT_DISPLAY);
+  Wire.beginTransmission(s_cfg.oledAddr);
+  Wire.write((uint8_t)0x00);                 // command stream
+  Wire.write((uint8_t)SSD1306_COLUMNADDR);
+  Wire.write(col0);
+  Wire.write(col1);
+  Wire.write((uint8_t)SSD1306_PAGEADDR);
+  Wire.write(page0);
+  Wire.write(page1);
+  Wire.endTransmission();
+  bytes += 8;
+
+  // The panel wraps from col1 to col0 of the next page by itself, so the
+  // rows stream back to back regardless of where transactions split
+  uint32_t open = 0;                         // data bytes in the open transaction
+  for (uint8_t p = page0; p <= page1; p++) {
+    const uint8_t* row = frame + p * 128 + col0;
+    uint16_t done = 0;
+    while (done < span) {
+      if (!open) {
+        Wire.beginTransmission(s_cfg.oledAddr);
+        Wire.write((uint8_t)0x40);           // data stream
+        bytes += 2;
+      }
+      uint16_t len = span - done;
+      if (len > cap - open) len = cap - open;
+      Wire.write(row + done, len);
+      done += len;
+      open += len;
+      bytes += len;
+      if (open == cap) {
+        Wire.endTransmission();
+        open = 0;
+        i2cBusYield();   // the panel keeps its address across NFC transfers
+      }
+    }
+  }
+  if (open) Wire.endTransmission();
+  i2cBusRelease();
+  return bytes;
+}
+
+// ---------------------------------------------------------------------------
+// Load cell
+// ---------------------------------------------------------------------------
+bool halLoadCellBegin() {
+  Wire1.begin(s_cfg.nauSda, s_cfg.nauScl);
+  bool ok = s_nau.begin(Wire1);
+  s_nau.setGain(NAU7802_GAIN_128);
+  s_nau.setSampleRate(NAU7802_SPS_320);
+  return ok;
+}
+
+void halLoadCellCalibrateAFE() { s_nau.calibrateAFE(); }
+bool halLoadCellAvailable()    { return s_nau.available(); }
+
+long halLoadCellRead() {
+  long raw = s_nau.getReading();
+  ioRecordAdc(raw);
+  return raw;
+}
+
+// Temperature sensor: gain 1, input range +-VREF/2 (LDO at 3.3 V, as
+// begin() sets it). The first conversions after a switch are settling.
+static const float   NAU_TEMP_VREF_V   = 3.3f;
+static const float   NAU_TEMP_V_25C    = 0.109f;
+static const float   NAU_TEMP_V_PER_C  = 0.000360f;
+static const uint8_t NAU_TEMP_SETTLE   = 3;   // conversions dropped after each switch
+static const uint8_t NAU_TEMP_READINGS = 4;
+
+static bool nauNextReading(long* raw) {
+  uint32_t t0 = millis();
+  while (!s_nau.available()) {
+    if (millis() - t0 > 20) return false;   // 320 SPS: one is due every 3 ms
+    delay(1);
+  }
+  *raw = s_nau.getReading();
+  return true;
+}
+
+bool halLoadCellReadTempC(float* degC) {
+  s_nau.setGain(NAU7802_GAIN_1);
+  s_nau.setBit(NAU7802_I2C_CONTROL_TS, NAU7802_I2C_CONTROL);
+  long raw = 0, sum = 0;
+  bool ok = true;
+  for (uint8_t i = 0; ok && i < NAU_TEMP_SETTLE + NAU_TEMP_READINGS; i++) {
+    ok = nauNextReading(&raw);
+    if (i >= NAU_TEMP_SETTLE) sum += raw;
+  }
+  s_nau.clearBit(NAU7802_I2C_CONTROL_TS, NAU7802_I2C_CONTROL);
+  s_nau.setGain(NAU7802_GAIN_128);
+  for (uint8_t i = 0; i < NAU_TEMP_SETTLE; i++) nauNextReading(&raw);
+  if (!ok) return false;
+
+  float volts = (float)sum / NAU_TEMP_READINGS / 8388608.0f * (NAU_TEMP_VREF_V / 2.0f);
+  *degC = 25.0f + (volts - NAU_TEMP_V_25C) / NAU_TEMP_V_PER_C;
+  return true;
+}
+
+// ---------------------------------------------------------------------------
+// Persistent storage
+// ---------------------------------------------------------------------------
+bool  halPrefsBegin(const char* ns, bool readOnly)  { return s_prefs.begin(ns, readOnly); }
+void  halPrefsEnd()                                 { s_prefs.end(); }
+float halPrefsGetFloat(const char* key, float def)  { return s_prefs.getFloat(key, def); }
+void  halPrefsPutFloat(const char* key, float v)    { s_prefs.putFloat(key, v); }
+long  halPrefsGetLong(const char* key, long def)    { return s_prefs.getLong(key, def); }
+void  halPrefsPutLong(const char* key, long v)      { s_prefs.putLong(key, v); }
+
+// ---------------------------------------------------------------------------
+// NFC / PaddleDNA
+// ---------------------------------------------------------------------------
+bool halNfcBegin() {
+  i2cBusAcquire(I2C_CLIENT_NFC);
+  bool ok = s_nfc.begin(Wire);
+  i2cBusRelease();
+  s_nfcPresent = ok;
+  return ok;
+}
+
+#if HAL_NFC_TAG_UUID
+bool halNfcDetectTag(uint8_t paddleUuid[16]) {
+  if (!s_nfcPresent) return false;
+  i2cBusAcquire(I2C_CLIENT_NFC);
+  bool found = s_nfc.readPaddleUuid(paddleUuid);
+  i2cBusRelease();
+  return found;
+}
+#endif
+
+#if HAL_NFC_CARD_DETECT
+// The IRQ line stays attached once armed; the ISR only acts while armed
+static volatile bool s_nfcIrqArmed = false;
+static HalSemaphore  s_nfcIrqWake = NULL;
+static bool          s_nfcIrqAttached = false;
+
+static void IRAM_ATTR nfcIrqIsr() {
+  if (!s_nfcIrqArmed) return;
+  s_nfcIrqArmed = false;
+  BaseType_t woken = pdFALSE;
+  xSemaphoreGiveFromISR((SemaphoreHandle_t)s_nfcIrqWake, &woken);
+  if (woken) portYIELD_FROM_ISR();
+}
+
+bool halNfcArmTagIrq(HalSemaphore wake) {
+  if (!s_nfcPresent || s_cfg.pinNfcIrq == HAL_NO_PIN) return false;
+  if (!s_nfcIrqAttached) {
+    pinMode(s_cfg.pinNfcIrq, INPUT_PULLUP);
+    attachInterrupt(digitalPinToInterrupt(s_cfg.pinNfcIrq), nfcIrqIsr, FALLING);
+    s_nfcIrqAttached = true;
+  }
+  s_nfcIrqWake = wake;
+  i2cBusAcquire(I2C_CLIENT_NFC);
+  bool ok = s_nfc.enterCardDetect();
+  i2cBusRelease();
+  if (!ok) return false;
+  s_nfcIrqArmed = true;
+  // A tag already in the field may have pulled the line before the edge
+  // could be seen
+  if (digitalRead(s_cfg.pinNfcIrq) == LOW && s_nfcIrqArmed) {
+    s_nfcIrqArmed = false;
+    xSemaphoreGive((SemaphoreHandle_t)wake);
+  }
+  return true;
+}
+#else
+bool halNfcArmTagIrq(HalSemaphore) { return false; }
+#endif
+
+bool halCryptoBegin(const uint8_t machineUuid[16], const uint8_t privateKey[32]) {
+  return s_crypto.begin(machineUuid, privateKey);
+}
+
+void halNfcAccumulatorBegin(uint8_t maxMeasurements) {
+  // paddle UUID is auto-detected from the tag
+  s_accumulator = new PaddleDNA::MeasurementAccumulator(s_nfc, s_crypto, maxMeasurements);
+}
+
+static HalNfcResult toHalResult(PaddleDNA::AccumulateResult r) {
+  switch (r) {
+    case PaddleDNA::AccumulateResult::Success:        return HAL_NFC_SUCCESS;
+    case PaddleDNA::AccumulateResult::NoTag:          return HAL_NFC_NO_TAG;
+    case PaddleDNA::AccumulateResult::TagFull:        return HAL_NFC_TAG_FULL;
+    case PaddleDNA::AccumulateResult::ReadError:      return HAL_NFC_READ_ERROR;
+    case PaddleDNA::AccumulateResult::WriteError:     return HAL_NFC_WRITE_ERROR;
+    case PaddleDNA::AccumulateResult::InvalidPayload: return HAL_NFC_INVALID_PAYLOAD;
+    case PaddleDNA::AccumulateResult::CryptoError:    return HAL_NFC_CRYPTO_ERROR;
+  }
+  return HAL_NFC_READ_ERROR;
+}
+
+// PaddleDNA reports through a String; one kept at a reserved capacity is
+// reassigned in place instead of allocating per poll
+static String s_nfcText;
+
+static void copyText(char* msg, size_t msgLen) {
+  if (msg && msgLen > 0) {
+    strncpy(msg, s_nfcText.c_str(), msgLen - 1);
+    msg[msgLen - 1] = '\0';
+  }
+}
+
+#if HAL_NFC_STAGED_COMMIT
+// Stages the measurements into the open session's cached payload, then
+// writes it back once. Those that no longer fit are left out (TagFull).
+// Caller holds the bus.
+static PaddleDNA::AccumulateResult commitBatch(const uint8_t machineUuid[16],
+                                               const uint32_t* timestamps, const float* cofs,
+                                               uint8_t count, uint8_t* written) {
+  uint8_t staged = 0;
+  while (staged < count) {
+    PaddleDNA::Measurement measurement(
+      PaddleDNA::MeasurementType::CoF,
+      machineUuid,
+      timestamps[staged],
+      cofs[staged]
+    );
+    if (!s_accumulator->stageMeasurement(measurement)) break;   // payload full
+    staged++;
+  }
+  if (staged == 0) return PaddleDNA::AccumulateResult::TagFull;
+  PaddleDNA::AccumulateResult r = s_accumulator->commitSession(&s_nfcText);
+  if (r != PaddleDNA::AccumulateResult::Success) return r;
+  *written = staged;
+  return (staged < count) ? PaddleDNA::AccumulateResult::TagFull : r;
+}
+#else
+// One accumulate() per measurement, in order; stops at the first that does
+// not go onto the tag. Caller holds the bus.
+static PaddleDNA::AccumulateResult accumulateEach(const uint8_t machineUuid[16],
+                                                  const uint32_t* timestamps, const float* cofs,
+                                                  uint8_t count, uint8_t* written) {
+  PaddleDNA::AccumulateResult r = PaddleDNA::AccumulateResult::Success;
+  while (*written < count) {
+    PaddleDNA::Measurement measurement(
+      PaddleDNA::MeasurementType::CoF,
+      machineUuid,
+      timestamps[*written],
+      cofs[*written]
+    );
+    r = s_accumulator->accumulate(measurement, &s_nfcText);
+    if (r != PaddleDNA::AccumulateResult::Success) break;
+    (*written)++;
+  }
+  return r;
+}
+#endif
+
+// The tag in the field carries the expected paddle UUID: HAL_NFC_SUCCESS,
+// or why not. Caller holds the bus.
+static HalNfcResult checkTag(const uint8_t expected[16]) {
+#if HAL_NFC_TAG_UUID
+  uint8_t found[16];
+  if (!s_nfc.readPaddleUuid(found)) return HAL_NFC_NO_TAG;
+  return memcmp(found, expected, 16) == 0 ? HAL_NFC_SUCCESS : HAL_NFC_WRONG_TAG;
+#else
+  (void)expected;
+  return HAL_NFC_WRONG_TAG;   // no way to tell
+#endif
+}
+
+HalNfcResult halNfcAccumulate(const uint8_t machineUuid[16], const uint8_t* expectedUuid,
+                              const uint32_t* timestamps, const float* cofs, uint8_t count,
+                              uint8_t* written, char* msg, size_t msgLen) {
+  *written = 0;
+  if (!s_accumulator) return HAL_NFC_READ_ERROR;
+
+  s_nfcText.reserve(96);
+  i2cBusAcquire(I2C_CLIENT_NFC);
+  if (expectedUuid) {
+    HalNfcResult check = checkTag(expectedUuid);
+    if (check != HAL_NFC_SUCCESS) {
+      i2cBusRelease();
+      if (msg && msgLen > 0) snprintf(msg, msgLen, "%s", check == HAL_NFC_NO_TAG ? "no tag" : "wrong tag");
+      return check;
+    }
+  }
+#if HAL_NFC_STAGED_COMMIT
+  uint8_t paddleUuid[16];   // discovered from the tag
+  PaddleDNA::AccumulateResult r = s_accumulator->openSession(paddleUuid, &s_nfcText);
+  if (r == PaddleDNA::AccumulateResult::Success) {
+    r = commitBatch(machineUuid, timestamps, cofs, count, written);
+  }
+  i2cBusRelease();
+  s_accumulator->closeSession();
+#else
+  PaddleDNA::AccumulateResult r = accumulateEach(machineUuid, timestamps, cofs, count, written);
+  i2cBusRelease();
+#endif
+  copyText(msg, msgLen);
+  return toHalResult(r);
+}
+
+#if NFC_TAG_FIRST_ENABLED
+HalNfcResult halNfcSessionOpen(uint8_t paddleUuid[16], char* msg, size_t msgLen) {
+  if (!s_accumulator) return HAL_NFC_READ_ERROR;
+  s_nfcText.reserve(96);
+  i2cBusAcquire(I2C_CLIENT_NFC);
+  PaddleDNA::AccumulateResult r = s_accumulator->openSession(paddleUuid, &s_nfcText);
+  i2cBusRelease();
+  copyText(msg, msgLen);
+  return toHalResult(r);
+}
+
+HalNfcResult halNfcSessionCommit(const uint8_t machineUuid[16], const uint32_t* timestamps,
+                                 const float* cofs, uint8_t count, uint8_t* written,
+                                 char* msg, size_t msgLen) {
+  *written = 0;
+  if (!s_accumulator) return HAL_NFC_READ_ERROR;
+  s_nfcText.reserve(96);
+  i2cBusAcquire(I2C_CLIENT_NFC);
+  PaddleDNA::AccumulateResult r = commitBatch(machineUuid, timestamps, cofs, count, written);
+  i2cBusRelease();
+  s_accumulator->closeSession();
+  copyText(msg, msgLen);
+  return toHalResult(r);
+}
+
+void halNfcSessionClose() {
+  if (s_accumulator) s_accumulator->closeSession();
+}
+#endif
+
+// ---------------------------------------------------------------------------
+// Task primitives (FreeRTOS)
+// ---------------------------------------------------------------------------
+static TickType_t toTicks(uint32_t timeoutMs) {
+  return (timeoutMs == HAL_WAIT_FOREVER) ? portMAX_DELAY : pdMS_TO_TICKS(timeoutMs);
+}
+
+bool halTaskCreate(HalTaskFn fn, const char* name, uint32_t stackBytes,
+                   void* arg, int priority, int core) {
+  return xTaskCreatePinnedToCore(fn, name, stackBytes, arg, priority,
+                                 NULL, core) == pdPASS;
+}
+
+void halTaskDelayMs(uint32_t ms) { vTaskDelay(pdMS_TO_TICKS(ms)); }
+void halTaskExit()               { vTaskDelete(NULL); }
+int  halCoreId()                 { return xPortGetCoreID(); }
+void halDisableCore1Wdt()        { disableCore1WDT(); }
+
+HalQueue halQueueCreate(uint32_t length, uint32_t itemSize) {
+  return (HalQueue)xQueueCreate(length, itemSize);
+}
+
+bool halQueueSend(HalQueue q, const void* item, uint32_t timeoutMs) {
+  return xQueueSend((QueueHandle_t)q, item, toTicks(timeoutMs)) == pdTRUE;
+}
+
+bool halQueueReceive(HalQueue q, void* item, uint32_t timeoutMs) {
+  return xQueueReceive((QueueHandle_t)q, item, toTicks(timeoutMs)) == pdTRUE;
+}
+
+HalSemaphore halSemCreateBinary() {
+  return (HalSemaphore)xSemaphoreCreateBinary();
+}
+
+bool halSemGive(HalSemaphore s) {
+  return xSemaphoreGive((SemaphoreHandle_t)s) == pdTRUE;
+}
+
+bool halSemTake(HalSemaphore s, uint32_t timeoutMs) {
+  return xSemaphoreTake((SemaphoreHandle_t)s, toTicks(timeoutMs)) == pdTRUE;
+}
+
+static portMUX_TYPE s_criticalMux = portMUX_INITIALIZER_UNLOCKED;
+
+void halCriticalEnter() { portENTER_CRITICAL(&s_criticalMux); }
+void halCriticalExit()  { portEXIT_CRITICAL(&s_criticalMux); }
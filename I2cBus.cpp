@@ -0,0 +1,113 @@
+#include "I2cBus.h"
+#include "Trace.h"
+
+static HalSemaphore   s_grant[I2C_CLIENT_COUNT];    // hands the bus to a waiter
+static uint8_t        s_waiting[I2C_CLIENT_COUNT];  // blocked in i2cBusAcquire()
+static bool           s_ready = false;
+static bool           s_busy = false;
+static I2cClient      s_owner = I2C_CLIENT_NFC;
+static uint32_t       s_ownedSinceUs = 0;
+
+static I2cClientStats s_stats[I2C_CLIENT_COUNT];
+static uint32_t       s_statsSinceMs = 0;
+
+static const char* const CLIENT_NAMES[I2C_CLIENT_COUNT] = { "nfc", "display" };
+
+void i2cBusBegin() {
+  if (s_ready) return;
+  for (int c = 0; c < I2C_CLIENT_COUNT; c++) s_grant[c] = halSemCreateBinary();
+  s_ready = true;
+}
+
+// Blocks until the bus is ours. Stats are only touched by the owner.
+static void acquire(I2cClient client, bool resuming) {
+  uint32_t t0 = halMicros();
+  halCriticalEnter();
+  bool contended = s_busy;
+  if (contended) s_waiting[client]++;
+  else           s_busy = true;
+  halCriticalExit();
+
+  if (contended) {
+    TRACE_BEGIN(TR_I2C_WAIT, client);
+    halSemTake(s_grant[client], HAL_WAIT_FOREVER);
+    TRACE_END(TR_I2C_WAIT, client);
+  }
+
+  uint32_t now = halMicros();
+  s_owner = client;
+  s_ownedSinceUs = now;
+  I2cClientStats& s = s_stats[client];
+  if (!resuming) s.acquires++;
+  if (contended) {
+    uint32_t waited = now - t0;
+    if (!resuming) s.contended++;
+    s.waitUs += waited;
+    if (waited > s.waitMaxUs) s.waitMaxUs = waited;
+  }
+}
+
+void i2cBusAcquire(I2cClient client) {
+  if (s_ready) acquire(client, false);
+}
+
+void i2cBusRelease() {
+  if (!s_ready) return;
+  s_stats[s_owner].holdUs += halMicros() - s_ownedSinceUs;
+
+  int next = -1;
+  halCriticalEnter();
+  for (int c = 0; c < I2C_CLIENT_COUNT; c++) {
+    if (s_waiting[c]) {
+      s_waiting[c]--;
+      next = c;
+      break;
+    }
+  }
+  if (next < 0) s_busy = false;
+  halCriticalExit();
+
+  // The bus stays busy: ownership passes straight to the waiter, so a
+  // lower-priority client arriving now cannot slip in ahead of it
+  if (next >= 0) halSemGive(s_grant[next]);
+}
+
+bool i2cBusYield() {
+  if (!s_ready) return false;
+  I2cClient self = s_owner;
+  bool higher = false;
+  halCriticalEnter();
+  for (int c = 0; c < self; c++) higher |= (s_waiting[c] != 0);
+  halCriticalExit();
+  if (!higher) return false;
+
+  s_stats[self].yields++;
+  i2cBusRelease();
+  acquire(self, true);
+  return true;
+}
+
+I2cClientStats i2cBusStats(I2cClient client) { return s_stats[client]; }
+
+void i2cBusStatsReset() {
+  memset(s_stats, 0, sizeof(s_stats));
+  s_statsSinceMs = halMillis();
+}
+
+void i2cBusStatsPrint() {
+  Serial.println("---I2C_STATS_START---");
+  Serial.print("window_ms,"); Serial.println(halMillis() - s_statsSinceMs);
+  Serial.print("i2c_hz,");    Serial.println((unsigned long)halI2cClockHz());
+  Serial.println("client,acquires,contended,wait_ms,wait_max_us,hold_ms,yields");
+  for (int c = 0; c < I2C_CLIENT_COUNT; c++) {
+    I2cClientStats s = s_stats[c];
+    Serial.print(CLIENT_NAMES[c]);                Serial.print(',');
+    Serial.print(s.acquires);                     Serial.print(',');
+    Serial.print(s.contended);                    Serial.print(',');
+    Serial.print(s.waitUs / 1000.0, 2);           Serial.print(',');
+    Serial.print(s.waitMaxUs);                    Serial.print(',');
+    Serial.print(s.holdUs / 1000.0, 2);           Serial.print(',');
+    Serial.println(s.yields);
+  }
+  Serial.println("---I2C_STATS_END---");
+}
@@ -0,0 +1,61 @@
+#ifndef I2C_BUS_H
+#define I2C_BUS_H
+
+#include "Hal.h"
+
+// ---------------------------------------------------------------------------
+// Shared I2C bus arbitration (OLED + NFC reader on Wire)
+// ---------------------------------------------------------------------------
+// Every transfer on the shared bus runs between i2cBusAcquire() and
+// i2cBusRelease(). The bus has one owner at a time; when it is released,
+// it goes straight to the highest-priority waiting client, whatever the
+// arrival order, so an NFC poll never queues behind display flushes.
+//
+// Long transfers are split into transactions (the HAL caps display data
+// transactions at I2C_DISPLAY_SLICE_US of bus time) and call
+// i2cBusYield() between them: if a higher-priority client is waiting, the
+// owner hands the bus over and queues again. A display flush interrupted
+// this way resumes where it stopped, since the panel keeps its own address
+// pointer. An NFC poll therefore waits at most one display slice.
+//
+// The HAL implementations do the bracketing; the sketch never calls these.
+// The stats ('i' serial command, friction_sim --i2c-stats) show what each
+// client waited for the bus and for how long it held it.
+
+// Highest priority first
+enum I2cClient {
+  I2C_CLIENT_NFC,      // tag polls and writes; an operator is waiting
+  I2C_CLIENT_DISPLAY,  // OLED flushes; cosmetic, can wait a frame
+  I2C_CLIENT_COUNT
+};
+
+// Longest display data transaction, in µs of bus time: the worst-case
+// wait of an NFC poll that arrives during a flush
+#ifndef I2C_DISPLAY_SLICE_US
+#define I2C_DISPLAY_SLICE_US 5000
+#endif
+
+struct I2cClientStats {
+  uint32_t acquires;   // i2cBusAcquire() calls
+  uint32_t contended;  // ... that found the bus owned
+  uint64_t waitUs;     // time spent waiting for the bus, after yields too
+  uint32_t waitMaxUs;  // longest wait
+  uint64_t holdUs;     // time spent owning it
+  uint32_t yields;     // times it handed the bus to a higher priority
+};
+
+// Called by halI2cBegin(); acquire/release are no-ops before it
+void i2cBusBegin();
+
+void i2cBusAcquire(I2cClient client);
+void i2cBusRelease();
+
+// Between transactions: lets a waiting higher-priority client go first.
+// Returns true if the bus was handed over (and has been reacquired).
+bool i2cBusYield();
+
+I2cClientStats i2cBusStats(I2cClient client);
+void           i2cBusStatsReset();
+void           i2cBusStatsPrint();
+
+#endif // I2C_BUS_H
@@ -0,0 +1,239 @@
+#include "IoRecorder.h"
+
+#if IO_RECORD_ENABLED
+
+static uint8_t        s_buf[IO_RECORD_BYTES];
+static uint32_t       s_used     = 0;
+static uint16_t       s_flags    = 0;
+static volatile bool  s_active   = false;
+static uint32_t       s_startUs  = 0;
+static uint32_t       s_durationUs = 0;
+static uint32_t       s_lastTs   = 0;     // session-relative µs of the previous record
+static long           s_lastRaw  = 0;
+static float          s_calibration = 0.0f;
+static int32_t        s_tareRaw  = 0;
+static float          s_calCurve = 0.0f;
+
+static uint8_t s_pinStep = 0xFF, s_pinDir = 0xFF, s_pinEnable = 0xFF;
+static uint8_t s_pinLimit = 0xFF, s_pinButton = 0xFF;
+
+// Last level seen per edge type (0xFF = none yet). Outputs are tracked
+// outside sessions too, so each session starts with the DIR/EN state; inputs
+// restart per session so the first read is always recorded.
+static uint8_t s_level[IO_END];
+
+// Open step run
+static bool     s_runOpen  = false;
+static bool     s_stepHigh = false;
+static uint32_t s_runStart = 0;
+static uint32_t s_runLast  = 0;
+static uint32_t s_runCount = 0;
+
+// Largest record: tag + 3 five-byte varints
+static const uint32_t MAX_RECORD_BYTES = 16;
+
+// ---------------------------------------------------------------------------
+// Encoding (call with the critical section held)
+// ---------------------------------------------------------------------------
+
+static uint8_t* putVarint(uint8_t* p, uint32_t v) {
+  while (v >= 0x80) {
+    *p++ = (uint8_t)(v | 0x80);
+    v >>= 7;
+  }
+  *p++ = (uint8_t)v;
+  return p;
+}
+
+static uint32_t zigzag(int32_t v) {
+  return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+}
+
+// Reserves room for one record and writes its tag and time delta. Returns
+// NULL (and stops the session) once the buffer is full.
+static uint8_t* beginRecord(uint8_t tag, uint32_t ts) {
+  if (IO_RECORD_BYTES - s_used < MAX_RECORD_BYTES) {
+    s_flags |= IO_FLAG_OVERFLOW;
+    s_active = false;
+    return NULL;
+  }
+  uint8_t* p = s_buf + s_used;
+  *p++ = tag;
+  p = putVarint(p, zigzag((int32_t)(ts - s_lastTs)));
+  s_lastTs = ts;
+  return p;
+}
+
+static void commit(uint8_t* end) {
+  s_used = (uint32_t)(end - s_buf);
+}
+
+static void putEdge(IoEventType type, uint8_t level, uint32_t ts) {
+  uint8_t* p = beginRecord((uint8_t)(type | (level ? 0x10 : 0)), ts);
+  if (p) commit(p);
+}
+
+static void flushRun() {
+  if (!s_runOpen) return;
+  s_runOpen = false;
+  uint8_t* p = beginRecord(IO_STEPS, s_runStart);
+  if (!p) return;
+  p = putVarint(p, s_runCount);
+  p = putVarint(p, s_runLast - s_runStart);
+  commit(p);
+}
+
+// A step extends the open run if it lands near the run's line extrapolated
+// one more interval: within IO_STEP_JITTER_PCT of the interval, so interrupt
+// latency on single pulses doesn't split runs, but never less than
+// IO_STEP_JITTER_US.
+static void addStep(uint32_t ts) {
+  if (s_runOpen && s_runCount >= 2) {
+    uint32_t span      = s_runLast - s_runStart;
+    uint32_t interval  = span / (s_runCount - 1);
+    uint32_t predicted = s_runStart + (uint32_t)((uint64_t)span * s_runCount / (s_runCount - 1));
+    int32_t  tol = (int32_t)(interval * IO_STEP_JITTER_PCT / 100);
+    if (tol < IO_STEP_JITTER_US) tol = IO_STEP_JITTER_US;
+    int32_t  err = (int32_t)(ts - predicted);
+    if (err >= -tol && err <= tol) {
+      s_runLast = ts;
+      s_runCount++;
+      return;
+    }
+    flushRun();
+  } else if (s_runOpen) {
+    s_runLast = ts;
+    s_runCount = 2;
+    return;
+  }
+  s_runOpen  = true;
+  s_runStart = s_runLast = ts;
+  s_runCount = 1;
+}
+
+// ---------------------------------------------------------------------------
+// Session
+// ---------------------------------------------------------------------------
+
+void ioRecordConfigure(const HalConfig& cfg) {
+  s_pinStep   = cfg.pinStep;
+  s_pinDir    = cfg.pinDir;
+  s_pinEnable = cfg.pinEnable;
+  s_pinLimit  = cfg.pinLimit;
+  s_pinButton = cfg.pinButton;
+  memset(s_level, 0xFF, sizeof(s_level));
+}
+
+void ioRecordBegin(float calibration, float calCurve, long tareRaw) {
+  halCriticalEnter();
+  s_used = 0;
+  s_flags = 0;
+  s_lastTs = 0;
+  s_lastRaw = 0;
+  s_runOpen = false;
+  s_durationUs = 0;
+  s_calibration = calibration;
+  s_tareRaw = (int32_t)tareRaw;
+  s_calCurve = calCurve;
+  s_startUs = halMicros();
+  if (s_level[IO_DIR] != 0xFF)    putEdge(IO_DIR, s_level[IO_DIR], 0);
+  if (s_level[IO_ENABLE] != 0xFF) putEdge(IO_ENABLE, s_level[IO_ENABLE], 0);
+  s_level[IO_LIMIT] = s_level[IO_BUTTON] = 0xFF;
+  s_active = true;
+  halCriticalExit();
+}
+
+void ioRecordEnd() {
+  halCriticalEnter();
+  if (s_active) {
+    s_durationUs = halMicros() - s_startUs;
+    flushRun();
+    uint8_t* p = beginRecord(IO_END, s_durationUs);
+    if (p) commit(p);
+  }
+  s_active = false;
+  halCriticalExit();
+}
+
+bool     ioRecordActive()  { return s_active; }
+uint32_t ioRecordStartUs() { return s_startUs; }
+
+// ---------------------------------------------------------------------------
+// HAL hooks
+// ---------------------------------------------------------------------------
+
+static void recordLevel(IoEventType type, uint8_t level) {
+  if (s_level[type] == level) return;
+  s_level[type] = level;
+  if (!s_active) return;
+  uint32_t ts = halMicros() - s_startUs;
+  if (type == IO_DIR || type == IO_ENABLE) flushRun();  // keep steps on their side
+  putEdge(type, level, ts);
+}
+
+void ioRecordPinWrite(uint8_t pin, uint8_t level) {
+  if (pin == s_pinStep) {
+    bool rising = level && !s_stepHigh;
+    s_stepHigh = (level != 0);
+    if (!rising || !s_active) return;
+    halCriticalEnter();
+    if (s_active) addStep(halMicros() - s_startUs);
+    halCriticalExit();
+    return;
+  }
+  IoEventType type;
+  if      (pin == s_pinDir)    type = IO_DIR;
+  else if (pin == s_pinEnable) type = IO_ENABLE;
+  else return;
+  halCriticalEnter();
+  recordLevel(type, level ? 1 : 0);
+  halCriticalExit();
+}
+
+void ioRecordPinRead(uint8_t pin, int level) {
+  IoEventType type;
+  if      (pin == s_pinLimit)  type = IO_LIMIT;
+  else if (pin == s_pinButton) type = IO_BUTTON;
+  else return;
+  halCriticalEnter();
+  recordLevel(type, level ? 1 : 0);
+  halCriticalExit();
+}
+
+void ioRecordAdc(long raw) {
+  if (!s_active) return;
+  halCriticalEnter();
+  if (s_active) {
+    uint8_t* p = beginRecord(IO_ADC, halMicros() - s_startUs);
+    if (p) {
+      p = putVarint(p, zigzag((int32_t)(raw - s_lastRaw)));
+      s_lastRaw = raw;
+      commit(p);
+    }
+  }
+  halCriticalExit();
+}
+
+// ---------------------------------------------------------------------------
+// Dump
+// ---------------------------------------------------------------------------
+
+void ioRecordDump(Print& out) {
+  IoRecordHeader h;
+  h.magic       = IO_RECORD_MAGIC;
+  h.version     = IO_RECORD_VERSION;
+  h.flags       = s_flags;
+  h.bytes       = s_used;
+  h.durationUs  = s_durationUs;
+  h.calibration = s_calibration;
+  h.tareRaw     = s_tareRaw;
+  h.calCurve    = s_calCurve;
+
+  out.println("---IOREC_START---");
+  out.write((const uint8_t*)&h, sizeof(h));
+  out.write(s_buf, s_used);
+  out.println();
+  out.println("---IOREC_END---");
+}
+
+#endif // IO_RECORD_ENABLED
@@ -0,0 +1,111 @@
+#ifndef IO_RECORDER_H
+#define IO_RECORDER_H
+
+#include "Hal.h"
+
+// ---------------------------------------------------------------------------
+// Hardware I/O session recorder
+// ---------------------------------------------------------------------------
+// Logs every HAL-level event of one test cycle, from the START press to the
+// end of the NFC step: step pulses, DIR and EN writes, limit-switch and
+// button edges (as the firmware read them) and load-cell readings. The HAL
+// implementations feed it from halDigitalWrite/halDigitalRead/
+// halLoadCellRead; the sketch only brackets the session.
+//
+// The log is a compact byte stream in a static buffer:
+//   - consecutive step pulses collapse into one record (count + span) as
+//     long as they stay close to a straight line in time; decoded pulse
+//     times are spread evenly over the span, so they carry up to
+//     IO_STEP_JITTER_PCT of an interval of error, but gaps and rate
+//     changes start a new record
+//   - timestamps are zigzag-varint deltas from the previous record
+//   - readings are zigzag-varint deltas from the previous reading
+// A full test needs about 25 KB. If the buffer fills, recording stops and
+// the header's overflow flag is set.
+//
+// Dump format (little-endian), framed by text marker lines:
+//   ---IOREC_START---\n
+//   IoRecordHeader, then header.bytes of records
+//   \n---IOREC_END---\n
+// friction_sim --replay-io feeds a dump back through the simulated rig.
+//
+// Record layout: one tag byte (IoEventType in the low nibble, pin level in
+// bit 4 for edge records), varint dt, then
+//   IO_STEPS  varint count, varint span (first to last rising edge, µs)
+//   IO_ADC    zigzag varint raw delta
+// Edge and IO_END records carry no payload.
+//
+// Build with -DIO_RECORD_ENABLED=0 to compile the recorder out.
+
+#ifndef IO_RECORD_ENABLED
+#define IO_RECORD_ENABLED 1
+#endif
+
+#ifndef IO_RECORD_BYTES
+#define IO_RECORD_BYTES 49152
+#endif
+
+#define IO_RECORD_MAGIC   0x4F495446UL // "FTIO"
+#define IO_RECORD_VERSION 2
+#define IO_STEP_JITTER_PCT 25          // step run tolerance, % of the interval
+#define IO_STEP_JITTER_US  4           // ... but at least this
+
+enum IoEventType {
+  IO_STEPS  = 1,
+  IO_DIR    = 2,
+  IO_ENABLE = 3,
+  IO_LIMIT  = 4,
+  IO_BUTTON = 5,
+  IO_ADC    = 6,
+  IO_END    = 7
+};
+
+enum IoRecordFlags {
+  IO_FLAG_OVERFLOW = 1
+};
+
+struct IoRecordHeader {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t flags;        // IoRecordFlags
+  uint32_t bytes;        // record bytes that follow
+  uint32_t durationUs;   // session length
+  float    calibration;  // counts per lb at the time of the test
+  int32_t  tareRaw;      // tare offset at the time of the test
+  float    calCurve;     // quadratic term, lb per count^2 (LoadCellCal.h)
+};
+
+#if IO_RECORD_ENABLED
+
+// Called by halBegin() so pins can be told apart
+void ioRecordConfigure(const HalConfig& cfg);
+
+// Session bracket (sketch). The calibration context goes into the header so
+// a replay converts readings exactly as the device did.
+void ioRecordBegin(float calibration, float calCurve, long tareRaw);
+void ioRecordEnd();
+
+// HAL hooks
+void ioRecordPinWrite(uint8_t pin, uint8_t level);
+void ioRecordPinRead(uint8_t pin, int level);
+void ioRecordAdc(long raw);
+
+bool     ioRecordActive();
+uint32_t ioRecordStartUs();   // halMicros() at the last ioRecordBegin()
+void     ioRecordDump(Print& out);
+
+#else
+
+inline void ioRecordConfigure(const HalConfig&) {}
+inline void ioRecordBegin(float, float, long) {}
+inline void ioRecordEnd() {}
+inline void ioRecordPinWrite(uint8_t, uint8_t) {}
+inline void ioRecordPinRead(uint8_t, int) {}
+inline void ioRecordAdc(long) {}
+inline bool ioRecordActive() { return false; }
+inline uint32_t ioRecordStartUs() { return 0; }
+inline void ioRecordDump(Print& out) { out.println("I/O recording disabled (IO_RECORD_ENABLED=0)"); }
+
+#endif // IO_RECORD_ENABLED
+
+#endif // IO_RECORDER_H
@@ -0,0 +1,217 @@
+#include "LedAnimator.h"
+
+struct LedAnimation {
+  LedKeyframe frames[LED_MAX_KEYFRAMES];
+  uint8_t     count;
+  uint8_t     repeats;
+};
+
+// Shared with the task, guarded by halCritical
+static LedAnimation s_cur;
+static LedAnimation s_next;
+static bool         s_hasCur = false;
+static bool         s_hasNext = false;
+static uint32_t     s_curStartMs = 0;
+static uint32_t     s_gen = 0;          // bumped whenever s_cur changes or stops
+
+static HalSemaphore s_wake = NULL;      // new animation posted
+static HalSemaphore s_ledLock = NULL;   // serializes halLedSet() calls
+static uint32_t     s_shown = 0xFFFFFFFFu;  // packed RGB on the LED
+
+static void postWake() {
+  if (s_wake) halSemGive(s_wake);
+}
+
+static void store(LedAnimation& a, const LedKeyframe* frames, uint8_t count, uint8_t repeats) {
+  if (count > LED_MAX_KEYFRAMES) count = LED_MAX_KEYFRAMES;
+  memcpy(a.frames, frames, count * sizeof(LedKeyframe));
+  a.count = count;
+  a.repeats = repeats;
+}
+
+// Writes a color unless the animation it was computed for (gen) has been
+// replaced or stopped meanwhile
+static void show(uint8_t r, uint8_t g, uint8_t b, uint32_t gen) {
+  uint32_t packed = ((uint32_t)r << 16) | ((uint32_t)g << 8) | b;
+  if (s_ledLock) halSemTake(s_ledLock, HAL_WAIT_FOREVER);
+  halCriticalEnter();
+  bool current = (gen == s_gen);
+  halCriticalExit();
+  if (current && packed != s_shown) {
+    halLedSet(r, g, b);
+    s_shown = packed;
+  }
+  if (s_ledLock) halSemGive(s_ledLock);
+}
+
+static uint8_t lerp(uint8_t from, uint8_t to, uint32_t t, uint32_t span) {
+  return (uint8_t)((int)from + ((int)to - (int)from) * (int32_t)t / (int32_t)span);
+}
+
+// Color of animation a at elapsedMs, and how long it stays valid (one frame
+// during a fade, the rest of a hold). Returns false once the last repeat
+// has finished; the color is then the final keyframe's.
+static bool evaluate(const LedAnimation& a, uint32_t elapsedMs,
+                     uint8_t rgb[3], uint32_t* validMs) {
+  const LedKeyframe& last = a.frames[a.count - 1];
+  uint32_t period = 0;
+  for (uint8_t k = 0; k < a.count; k++) period += a.frames[k].rampMs + a.frames[k].holdMs;
+
+  if (period == 0 || (a.repeats != LED_FOREVER && elapsedMs >= period * a.repeats)) {
+    rgb[0] = last.r; rgb[1] = last.g; rgb[2] = last.b;
+    *validMs = 0;
+    return false;
+  }
+
+  uint32_t t = elapsedMs % period;
+  const LedKeyframe* prev = &last;
+  for (uint8_t k = 0; k < a.count; k++) {
+    const LedKeyframe& f = a.frames[k];
+    if (t < f.rampMs) {
+      rgb[0] = lerp(prev->r, f.r, t, f.rampMs);
+      rgb[1] = lerp(prev->g, f.g, t, f.rampMs);
+      rgb[2] = lerp(prev->b, f.b, t, f.rampMs);
+      *validMs = LED_FRAME_MS;
+      return true;
+    }
+    t -= f.rampMs;
+    if (t < f.holdMs) {
+      rgb[0] = f.r; rgb[1] = f.g; rgb[2] = f.b;
+      *validMs = f.holdMs - t;
+      return true;
+    }
+    t -= f.holdMs;
+    prev = &f;
+  }
+  rgb[0] = last.r; rgb[1] = last.g; rgb[2] = last.b;
+  *validMs = LED_FRAME_MS;
+  return true;
+}
+
+static void ledTask(void*) {
+  LedAnimation anim;
+  uint32_t gen = 0, startMs = 0;
+  bool playing = false;
+  for (;;) {
+    halCriticalEnter();
+    if (s_gen != gen || playing != s_hasCur) {
+      gen = s_gen;
+      playing = s_hasCur;
+      startMs = s_curStartMs;
+      if (playing) anim = s_cur;
+    }
+    halCriticalExit();
+
+    if (!playing) {
+      halSemTake(s_wake, HAL_WAIT_FOREVER);
+      continue;
+    }
+
+    uint8_t rgb[3];
+    uint32_t validMs;
+    bool more = evaluate(anim, halMillis() - startMs, rgb, &validMs);
+    show(rgb[0], rgb[1], rgb[2], gen);
+    if (more) {
+      halSemTake(s_wake, validMs ? validMs : 1);
+      continue;
+    }
+
+    // Finished: start the queued animation, if this one is still current
+    halCriticalEnter();
+    if (gen == s_gen) {
+      if (s_hasNext) {
+        s_cur = s_next;
+        s_hasNext = false;
+        s_curStartMs = halMillis();
+      } else {
+        s_hasCur = false;
+      }
+      s_gen++;
+    }
+    halCriticalExit();
+  }
+}
+
+// ---------------------------------------------------------------------------
+// API
+// ---------------------------------------------------------------------------
+
+bool ledAnimatorStart(int core, int priority) {
+  s_wake = halSemCreateBinary();
+  s_ledLock = halSemCreateBinary();
+  if (!s_wake || !s_ledLock) return false;
+  halSemGive(s_ledLock);
+  return halTaskCreate(ledTask, "LED", 2048, NULL, priority, core);
+}
+
+void ledPlay(const LedKeyframe* frames, uint8_t count, uint8_t repeats) {
+  if (!count) return;
+  halCriticalEnter();
+  store(s_cur, frames, count, repeats);
+  s_hasCur = true;
+  s_hasNext = false;
+  s_curStartMs = halMillis();
+  s_gen++;
+  halCriticalExit();
+  postWake();
+}
+
+void ledPlayNext(const LedKeyframe* frames, uint8_t count, uint8_t repeats) {
+  if (!count) return;
+  halCriticalEnter();
+  bool idle = !s_hasCur;
+  if (idle) {
+    store(s_cur, frames, count, repeats);
+    s_hasCur = true;
+    s_curStartMs = halMillis();
+    s_gen++;
+  } else {
+    store(s_next, frames, count, repeats);
+    s_hasNext = true;
+  }
+  halCriticalExit();
+  if (idle) postWake();
+}
+
+void ledSolid(uint8_t r, uint8_t g, uint8_t b) {
+  halCriticalEnter();
+  s_hasCur = false;
+  s_hasNext = false;
+  uint32_t gen = ++s_gen;
+  halCriticalExit();
+  show(r, g, b, gen);
+}
+
+void ledOff() { ledSolid(0, 0, 0); }
+
+bool ledBusy() {
+  halCriticalEnter();
+  bool busy = s_hasCur || s_hasNext;
+  halCriticalExit();
+  return busy;
+}
+
+void ledPulse(uint8_t r, uint8_t g, uint8_t b, uint8_t times, uint16_t pulseMs,
+              bool afterCurrent) {
+  // Fade in and out over pulseMs, 100 ms dark between pulses
+  const LedKeyframe pulse[] = {
+    { r, g, b, (uint16_t)(pulseMs / 2), 0 },
+    { 0, 0, 0, (uint16_t)(pulseMs / 2), 100 },
+  };
+  if (afterCurrent) ledPlayNext(pulse, 2, times);
+  else              ledPlay(pulse, 2, times);
+}
+
+void ledRainbow(uint16_t durationMs, bool afterCurrent) {
+  // The color wheel is piecewise linear between red, green and blue
+  uint16_t third = durationMs / 3;
+  const LedKeyframe wheel[] = {
+    { 255,   0,   0, 0,     0 },
+    {   0, 255,   0, third, 0 },
+    {   0,   0, 255, third, 0 },
+    { 255,   0,   0, third, 0 },
+    {   0,   0,   0, 0,     0 },
+  };
+  if (afterCurrent) ledPlayNext(wheel, 5, 1);
+  else              ledPlay(wheel, 5, 1);
+}
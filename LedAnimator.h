@@ -0,0 +1,47 @@
+#ifndef LED_ANIMATOR_H
+#define LED_ANIMATOR_H
+
+#include "Hal.h"
+
+// ---------------------------------------------------------------------------
+// RGB status LED animations
+// ---------------------------------------------------------------------------
+// Effects are keyframe lists played by a low-priority task, so the caller
+// returns at once instead of spinning in delay() loops. Each keyframe fades
+// linearly to its color over rampMs, then holds it for holdMs. The first
+// keyframe fades from the last one, so a list loops seamlessly; give it
+// rampMs 0 to start with a jump. After the last repeat the LED keeps the
+// last keyframe's color.
+//
+// ledPlay() replaces whatever is playing. ledPlayNext() starts once the
+// current animation finishes (one slot: a later call replaces it), so a
+// status blink can wait for a "done" pulse. ledSolid() and ledOff() stop
+// both and set the color immediately; an animation frame computed before
+// them is never written after them.
+//
+// Animations posted before ledAnimatorStart() begin when the task starts.
+
+#define LED_MAX_KEYFRAMES 8
+#define LED_FRAME_MS      10     // update period during fades
+#define LED_FOREVER       0xFF   // repeats: until replaced or stopped
+
+struct LedKeyframe {
+  uint8_t  r, g, b;
+  uint16_t rampMs;   // fade from the previous keyframe's color
+  uint16_t holdMs;   // then hold this color
+};
+
+bool ledAnimatorStart(int core, int priority);
+
+void ledPlay(const LedKeyframe* frames, uint8_t count, uint8_t repeats = 1);
+void ledPlayNext(const LedKeyframe* frames, uint8_t count, uint8_t repeats = 1);
+void ledSolid(uint8_t r, uint8_t g, uint8_t b);
+void ledOff();
+bool ledBusy();   // an animation is playing or queued
+
+// Stock effects; afterCurrent queues them with ledPlayNext()
+void ledPulse(uint8_t r, uint8_t g, uint8_t b, uint8_t times, uint16_t pulseMs,
+              bool afterCurrent = false);
+void ledRainbow(uint16_t durationMs, bool afterCurrent = false);
+
+#endif // LED_ANIMATOR_H
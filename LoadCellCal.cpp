@@ -0,0 +1,65 @@
+#include "LoadCellCal.h"
+#include <math.h>
+
+bool loadCellFit(const long* counts, const float* lb, uint8_t n, uint8_t order,
+                 LoadCellFit* fit) {
+  if (order < 1 || order > 2 || n < order || n > CAL_MAX_POINTS) return false;
+
+  // Normal equations in u = x / max|x|: raw counts run to 1e6 and their
+  // fourth powers would swamp a double's mantissa
+  double scale = 0.0;
+  for (uint8_t i = 0; i < n; i++) scale = fmax(scale, fabs((double)counts[i]));
+  if (scale == 0.0) return false;
+
+  double s2 = 0, s3 = 0, s4 = 0, sy1 = 0, sy2 = 0;
+  for (uint8_t i = 0; i < n; i++) {
+    double u = counts[i] / scale, y = lb[i];
+    s2 += u * u;
+    s3 += u * u * u;
+    s4 += u * u * u * u;
+    sy1 += u * y;
+    sy2 += u * u * y;
+  }
+
+  double a1, a2 = 0.0;
+  if (order == 1) {
+    a1 = sy1 / s2;
+  } else {
+    double det = s2 * s4 - s3 * s3;
+    if (det <= 1e-9 * s2 * s4) return false;   // fewer than two distinct readings
+    a1 = (sy1 * s4 - sy2 * s3) / det;
+    a2 = (s2 * sy2 - s3 * sy1) / det;
+  }
+
+  LoadCellFit f;
+  f.c1 = (float)(a1 / scale);
+  f.c2 = (float)(a2 / (scale * scale));
+  double sq = 0.0, worst = 0.0;
+  for (uint8_t i = 0; i < n; i++) {
+    double u = counts[i] / scale;
+    double r = u * (a1 + a2 * u) - lb[i];
+    sq += r * r;
+    worst = fmax(worst, fabs(r));
+  }
+  f.rmsLb = (float)sqrt(sq / n);
+  f.maxLb = (float)worst;
+  *fit = f;
+  return true;
+}
+
+float poundsToCounts(float lb, float c1, float c2) {
+  // Root of c2*x^2 + c1*x - lb nearest lb / c1, in the form that stays
+  // accurate as c2 goes to 0
+  float disc = c1 * c1 + 4.0f * c2 * lb;
+  if (disc < 0.0f) return 0.0f;
+  float den = c1 >= 0.0f ? c1 + sqrtf(disc) : c1 - sqrtf(disc);
+  return den != 0.0f ? 2.0f * lb / den : 0.0f;
+}
+
+void countsToPounds(float* values, long n, long tareRaw, float c1, float c2) {
+  const float tare = (float)tareRaw;
+  for (long i = 0; i < n; i++) {
+    float x = values[i] - tare;
+    values[i] = x * (c1 + c2 * x);
+  }
+}
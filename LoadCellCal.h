@@ -0,0 +1,43 @@
+#ifndef LOAD_CELL_CAL_H
+#define LOAD_CELL_CAL_H
+
+#include <Arduino.h>
+
+// ---------------------------------------------------------------------------
+// Load-cell calibration: least-squares fit and bulk conversion
+// ---------------------------------------------------------------------------
+// Force is a polynomial in the reading above the tare, x = raw - tare
+// (counts), with no constant term, since the tare is zero load by definition:
+//
+//   lb = c1*x + c2*x^2 = x*(c1 + c2*x)
+//
+// c2 is 0 for a linear calibration; the single-weight calibration is the
+// linear fit through one point, c1 = 1 / counts-per-lb.
+//
+// The sampling task stores raw readings in the pass buffers (a 24-bit reading
+// is exact in a float) and the finished passes are converted in place with
+// countsToPounds(), so the sampling loop does no arithmetic per reading.
+
+#define CAL_MAX_POINTS 8
+
+struct LoadCellFit {
+  float c1;      // lb per count
+  float c2;      // lb per count^2; 0 for a linear fit
+  float rmsLb;   // residuals at the calibration weights
+  float maxLb;
+};
+
+// Fits order 1 (linear) or 2 (quadratic) to n calibration weights: counts[i]
+// above the tare under lb[i]. Needs n >= order and distinct, nonzero
+// readings; false leaves *fit untouched.
+bool loadCellFit(const long* counts, const float* lb, uint8_t n, uint8_t order,
+                 LoadCellFit* fit);
+
+// Converts n raw readings to lb in place (Horner form, no division)
+void countsToPounds(float* values, long n, long tareRaw, float c1, float c2);
+
+// The inverse for one weight: counts above the tare that read as lb, or 0
+// if no reading does
+float poundsToCounts(float lb, float c1, float c2);
+
+#endif // LOAD_CELL_CAL_H
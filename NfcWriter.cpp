@@ -0,0 +1,488 @@
+#include "NfcWriter.h"
+#include "Profiler.h"
+#include "Trace.h"
+
+struct NfcPending {
+  uint32_t seq;
+  float    cof;
+  uint32_t timestamp;
+  uint32_t queuedMs;
+  bool     more;          // the next result is the same paddle's
+  bool     bound;         // paddle holds the UUID of the tag it goes to
+  uint8_t  paddle[16];
+};
+
+// A paddle's results, copied out for one tag write
+struct NfcBatch {
+  uint32_t seq;           // first result's
+  uint32_t queuedMs;      // first result's
+  uint8_t  count;
+  uint32_t timestamps[NFC_MAX_PENDING];
+  float    cofs[NFC_MAX_PENDING];
+};
+
+#define NFC_MAX_EVENTS (NFC_MAX_PENDING * 2)
+
+// Shared with the task, guarded by halCritical
+static NfcPending     s_pending[NFC_MAX_PENDING];   // oldest first
+static uint8_t        s_count = 0;
+static uint32_t       s_nextSeq = 1;
+static NfcWriterEvent s_events[NFC_MAX_EVENTS];     // ring, oldest dropped when full
+static uint8_t        s_evHead = 0;
+static uint8_t        s_evCount = 0;
+static NfcWriterStats s_stats = {};
+static bool           s_prefetch = false;   // tag-first: read the next tag now
+
+static uint8_t      s_machineUuid[16];
+static HalSemaphore s_wake = NULL;   // queued, or skipped
+
+// Writer task only
+static uint8_t s_lastWritten[16];
+static bool    s_lastInField = false;   // that tag has not left the reader yet (UUIDs only)
+static bool    s_fieldEmpty = true;     // the last poll found no tag
+static bool    s_irq = false;           // card detect armed; else poll
+static uint32_t s_irqRetryMs = 0;       // after a failed arm, the next try
+#if NFC_TAG_FIRST_ENABLED
+static uint8_t s_sessionUuid[16];
+static bool    s_sessionOpen = false;   // its records are read and cached
+#endif
+
+static void printUuid(const uint8_t uuid[16]) {
+  static const char hex[] = "0123456789abcdef";
+  char text[33];
+  for (int i = 0; i < 16; i++) {
+    text[2 * i]     = hex[uuid[i] >> 4];
+    text[2 * i + 1] = hex[uuid[i] & 0x0F];
+  }
+  text[32] = '\0';
+  Serial.print(text);
+}
+
+// Callers hold halCritical
+static int findSeq(uint32_t seq) {
+  for (uint8_t i = 0; i < s_count; i++) {
+    if (s_pending[i].seq == seq) return i;
+  }
+  return -1;
+}
+
+static void removeAt(uint8_t i, uint8_t n) {
+  memmove(&s_pending[i], &s_pending[i + n], (s_count - i - n) * sizeof(NfcPending));
+  s_count -= n;
+}
+
+// Results in the batch starting at i, or 0 while its paddle's last test is
+// still to come (only the newest batch can be open)
+static uint8_t batchLen(uint8_t i) {
+  for (uint8_t j = i; j < s_count; j++) {
+    if (!s_pending[j].more) return (uint8_t)(j - i + 1);
+  }
+  return 0;
+}
+
+// No room for a new paddle's result. Without tag UUIDs a tag cannot be
+// told from another, so only one paddle's results may wait at a time: a
+// complete batch holds the queue until it is written, skipped or expired.
+static bool queueFull() {
+  return s_count >= NFC_MAX_PENDING || (!HAL_NFC_TAG_UUID && batchLen(0) > 0);
+}
+
+static void pushEvent(NfcWriterEventType type, float cof, uint8_t count, uint32_t waitedMs) {
+  uint8_t slot = (uint8_t)((s_evHead + s_evCount) % NFC_MAX_EVENTS);
+  if (s_evCount == NFC_MAX_EVENTS) {
+    s_evHead = (uint8_t)((s_evHead + 1) % NFC_MAX_EVENTS);
+  } else {
+    s_evCount++;
+  }
+  s_events[slot].type = type;
+  s_events[slot].cof = cof;
+  s_events[slot].count = count;
+  s_events[slot].waitedMs = waitedMs;
+}
+
+static void expireOld() {
+  uint32_t now = halMillis();
+  halCriticalEnter();
+  for (uint8_t i = 0, n; i < s_count && (n = batchLen(i)) > 0; ) {
+    uint32_t waited = now - s_pending[i].queuedMs;
+    if (waited < NFC_TAG_WAIT_MS) { i += n; continue; }
+    pushEvent(NFC_EVT_EXPIRED, s_pending[i + n - 1].cof, n, waited);
+    s_stats.expired += n;
+    removeAt(i, n);
+  }
+  halCriticalExit();
+}
+
+// Binds the tag to a complete batch of pending results and copies it out.
+// False if the tag has none waiting for it. A NULL uuid (no tag UUIDs)
+// takes the oldest complete batch without binding it.
+static bool claimFor(const uint8_t* uuid, NfcBatch* batch) {
+  halCriticalEnter();
+  int pick = -1;
+  uint8_t n = 0;
+  for (uint8_t i = 0; i < s_count && uuid && pick < 0 && (n = batchLen(i)) > 0; i += n) {
+    if (s_pending[i].bound && memcmp(s_pending[i].paddle, uuid, 16) == 0) pick = i;
+  }
+  for (uint8_t i = 0; i < s_count && pick < 0 && (n = batchLen(i)) > 0; i += n) {
+    if (s_pending[i].bound) continue;
+    for (uint8_t j = i; uuid && j < i + n; j++) {
+      s_pending[j].bound = true;
+      memcpy(s_pending[j].paddle, uuid, 16);
+    }
+    pick = i;
+  }
+  if (pick >= 0) {
+    batch->seq = s_pending[pick].seq;
+    batch->queuedMs = s_pending[pick].queuedMs;
+    batch->count = n;
+    for (uint8_t k = 0; k < n; k++) {
+      batch->timestamps[k] = s_pending[pick + k].timestamp;
+      batch->cofs[k] = s_pending[pick + k].cof;
+    }
+  }
+  halCriticalExit();
+  return pick >= 0;
+}
+
+// One look at the field
+static void notePoll(bool found) {
+  halCriticalEnter();
+  s_stats.polls++;
+  halCriticalExit();
+  s_fieldEmpty = !found;
+}
+
+#if HAL_NFC_TAG_UUID
+// A new tag in the field, or false: none, or the one just written
+static bool detectNew(uint8_t uuid[16]) {
+  bool found = halNfcDetectTag(uuid);
+  notePoll(found);
+  if (!found) {
+    s_lastInField = false;
+    return false;
+  }
+  if (s_lastInField && memcmp(uuid, s_lastWritten, 16) == 0) return false;
+  s_lastInField = false;
+  return true;
+}
+#endif
+
+static void printResult(const char* what, HalNfcResult result, const char* msg) {
+  Serial.print(what);
+  Serial.print(" result: ");
+  Serial.print((int)result);
+  Serial.print(" - ");
+  Serial.println(msg);
+}
+
+// The batch's write is final: the first `written` results are on the tag
+// (uuid, or NULL if unknown), the rest did not fit. Takes the batch off the
+// queue.
+static void finishBatch(const NfcBatch& batch, const uint8_t* uuid, uint8_t written) {
+  if (uuid) {
+    memcpy(s_lastWritten, uuid, 16);
+    s_lastInField = true;
+  }
+  uint32_t waited = halMillis() - batch.queuedMs;
+  uint8_t full = batch.count - written;
+  halCriticalEnter();
+  int i = findSeq(batch.seq);
+  if (i >= 0) removeAt((uint8_t)i, batch.count);   // else skipped meanwhile
+  s_stats.tagWrites += HAL_NFC_STAGED_COMMIT ? 1 : written;
+  if (written) {
+    s_stats.written += written;
+    if (waited > s_stats.waitMaxMs) s_stats.waitMaxMs = waited;
+    pushEvent(NFC_EVT_WRITTEN, batch.cofs[written - 1], written, waited);
+  }
+  if (full) {
+    s_stats.tagFull += full;
+    pushEvent(NFC_EVT_TAG_FULL, batch.cofs[batch.count - 1], full, waited);
+  }
+  halCriticalExit();
+
+  if (uuid) {
+    Serial.print("NFC: paddle ");
+    printUuid(uuid);
+  } else {
+    Serial.print("NFC: tag");
+  }
+  Serial.print(" written: ");
+  for (uint8_t k = 0; k < batch.count; k++) {
+    Serial.print(k ? ", COF " : "COF ");
+    Serial.print(batch.cofs[k], 3);
+    if (k >= written) Serial.print(" (tag full)");
+  }
+  Serial.print(" after ");
+  Serial.print(waited);
+  Serial.println(" ms");
+}
+
+static void pollOnce() {
+  NfcBatch batch;
+#if HAL_NFC_TAG_UUID
+  uint8_t uuid[16];
+  if (!detectNew(uuid)) return;
+  if (!claimFor(uuid, &batch)) return;   // unknown tag, or its results are gone
+  const uint8_t* paddle = uuid;          // the write must find this tag again
+#else
+  // No tag UUIDs: the write finds the tag itself, and the oldest complete
+  // batch goes to whichever tag is presented
+  if (!claimFor(NULL, &batch)) return;
+  const uint8_t* paddle = NULL;
+#endif
+
+  char msg[64];
+  uint8_t written = 0;
+  HalNfcResult result;
+  {
+    PROF_SCOPE(PROF_NFC_ACCUMULATE);
+    TRACE_BEGIN(TR_NFC_POLL, 0);
+    result = halNfcAccumulate(s_machineUuid, paddle, batch.timestamps, batch.cofs, batch.count,
+                              &written, msg, sizeof(msg));
+    TRACE_END(TR_NFC_POLL, result);
+  }
+#if !HAL_NFC_TAG_UUID
+  notePoll(result != HAL_NFC_NO_TAG);
+  if (result == HAL_NFC_NO_TAG) return;   // the usual outcome: not worth a line
+#endif
+  printResult("Accumulate", result, msg);
+
+  // Other results: the tag moved, was swapped for another (wrong tag) or
+  // misread; retry it on the next poll. Without staged commits the results
+  // before the failure are on the tag already: only the rest are retried,
+  // on the same tag.
+  if (result != HAL_NFC_SUCCESS && result != HAL_NFC_TAG_FULL) {
+    if (written) {
+      NfcBatch done = batch;
+      done.count = written;
+      finishBatch(done, paddle, written);
+      s_lastInField = false;
+    }
+    return;
+  }
+  finishBatch(batch, paddle, written);
+}
+
+#if NFC_TAG_FIRST_ENABLED
+// Tag-first: read the next paddle's tag while its test runs
+static void openSession() {
+  uint8_t uuid[16];
+  if (!detectNew(uuid)) return;
+
+  char msg[64];
+  HalNfcResult result = halNfcSessionOpen(s_sessionUuid, msg, sizeof(msg));
+  if (result != HAL_NFC_SUCCESS) {
+    printResult("Session open", result, msg);
+    return;   // moved away, or misread: next poll
+  }
+  s_sessionOpen = true;
+  halCriticalEnter();
+  s_stats.sessions++;
+  halCriticalExit();
+  Serial.print("NFC: paddle ");
+  printUuid(s_sessionUuid);
+  Serial.println(" read, waiting for its results");
+}
+
+// The open session's tag takes the paddle's completed batch, or the
+// session is dropped (test aborted). A failed commit leaves the batch
+// bound to the tag for the polling path to retry.
+static void finishSession() {
+  s_sessionOpen = false;
+  NfcBatch batch;
+  if (!claimFor(s_sessionUuid, &batch)) {
+    halNfcSessionClose();
+    return;
+  }
+
+  char msg[64];
+  uint8_t written = 0;
+  HalNfcResult result;
+  {
+    PROF_SCOPE(PROF_NFC_ACCUMULATE);
+    TRACE_BEGIN(TR_NFC_POLL, 0);
+    result = halNfcSessionCommit(s_machineUuid, batch.timestamps, batch.cofs, batch.count,
+                                 &written, msg, sizeof(msg));
+    TRACE_END(TR_NFC_POLL, result);
+  }
+  printResult("Commit", result, msg);
+
+  if (result != HAL_NFC_SUCCESS && result != HAL_NFC_TAG_FULL) {
+    halNfcSessionClose();
+    return;
+  }
+  finishBatch(batch, s_sessionUuid, written);
+}
+#endif
+
+static void nfcWriterTask(void*) {
+  for (;;) {
+    halCriticalEnter();
+    bool ready = batchLen(0) > 0;   // a paddle's results are complete
+    bool prefetch = s_prefetch;
+    halCriticalExit();
+#if NFC_TAG_FIRST_ENABLED
+    if (s_sessionOpen) {
+      if (ready || !prefetch) finishSession();
+      else halSemTake(s_wake, HAL_WAIT_FOREVER);   // until the tests end
+      continue;
+    }
+#endif
+    // With nothing to write, keep watching a written tag until it leaves,
+    // so presenting it again later counts as a new tag
+    if (!ready && !prefetch && !s_lastInField) {
+      halSemTake(s_wake, HAL_WAIT_FOREVER);
+      continue;
+    }
+    expireOld();
+#if NFC_TAG_FIRST_ENABLED
+    if (prefetch && !ready) openSession();
+    else                    pollOnce();
+    if (s_sessionOpen) continue;
+#else
+    pollOnce();
+#endif
+
+    // An empty field is left to the reader's card detect, which wakes the
+    // task when a tag arrives. A tag in the field (just written, unknown,
+    // or misread) is polled until it leaves, as arrivals are all the IRQ
+    // reports.
+    // A failed arm (no IRQ line, or the reader did not take the command)
+    // polls until the next try.
+    uint32_t waitMs = NFC_POLL_MS;
+    if (s_fieldEmpty && (int32_t)(halMillis() - s_irqRetryMs) >= 0) {
+      s_irq = halNfcArmTagIrq(s_wake);
+      if (s_irq) waitMs = NFC_IRQ_RECHECK_MS;
+      else       s_irqRetryMs = halMillis() + NFC_IRQ_RETRY_MS;
+    }
+    halSemTake(s_wake, waitMs);
+  }
+}
+
+// ---------------------------------------------------------------------------
+// API
+// ---------------------------------------------------------------------------
+
+bool nfcWriterStart(const uint8_t machineUuid[16], int core, int priority) {
+  memcpy(s_machineUuid, machineUuid, 16);
+  s_wake = halSemCreateBinary();
+  if (!s_wake) return false;
+  // PaddleDNA signs on the task's stack
+  return halTaskCreate(nfcWriterTask, "NfcWriter", 8192, NULL, priority, core);
+}
+
+bool nfcWriterQueue(float cof, uint32_t timestamp, bool more) {
+  halCriticalEnter();
+  bool ok = !queueFull();
+  if (ok) {
+    NfcPending& p = s_pending[s_count++];
+    p.seq = s_nextSeq++;
+    p.cof = cof;
+    p.timestamp = timestamp;
+    p.queuedMs = halMillis();
+    p.more = more;
+    p.bound = false;
+    s_stats.queued++;
+    if (!more) s_prefetch = false;   // an open session takes the batch
+  }
+  uint8_t pending = s_count;
+  halCriticalExit();
+  if (!ok) return false;
+
+  if (s_wake) halSemGive(s_wake);
+  Serial.print("NFC: queued COF ");
+  Serial.print(cof, 3);
+  Serial.print(", ");
+  Serial.print(pending);
+  Serial.println(" pending");
+  return true;
+}
+
+bool nfcWriterPrefetch() {
+#if NFC_TAG_FIRST_ENABLED
+  halCriticalEnter();
+  bool ok = batchLen(0) == 0;   // else the tags due first are the pending ones
+  s_prefetch = ok;
+  halCriticalExit();
+  if (ok && s_wake) halSemGive(s_wake);
+  return ok;
+#else
+  return false;   // not built in
+#endif
+}
+
+void nfcWriterPrefetchCancel() {
+  halCriticalEnter();
+  s_prefetch = false;
+  halCriticalExit();
+  if (s_wake) halSemGive(s_wake);
+}
+
+void nfcWriterEndBatch() {
+  halCriticalEnter();
+  if (s_count) s_pending[s_count - 1].more = false;
+  halCriticalExit();
+  if (s_wake) halSemGive(s_wake);
+}
+
+bool nfcWriterSkipOldest() {
+  halCriticalEnter();
+  uint8_t n = batchLen(0);
+  if (!n) n = s_count;   // the open batch is the only one
+  if (n) {
+    removeAt(0, n);
+    s_stats.skipped += n;
+  }
+  halCriticalExit();
+  return n > 0;
+}
+
+bool nfcWriterFull() {
+  halCriticalEnter();
+  bool full = queueFull();
+  halCriticalExit();
+  return full;
+}
+
+uint8_t nfcWriterPending() {
+  halCriticalEnter();
+  uint8_t n = s_count;
+  halCriticalExit();
+  return n;
+}
+
+bool nfcWriterPollEvent(NfcWriterEvent* ev) {
+  halCriticalEnter();
+  bool any = s_evCount > 0;
+  if (any) {
+    *ev = s_events[s_evHead];
+    s_evHead = (uint8_t)((s_evHead + 1) % NFC_MAX_EVENTS);
+    s_evCount--;
+  }
+  halCriticalExit();
+  return any;
+}
+
+NfcWriterStats nfcWriterStats() {
+  halCriticalEnter();
+  NfcWriterStats s = s_stats;
+  halCriticalExit();
+  return s;
+}
+
+void nfcWriterStatsPrint() {
+  NfcWriterStats s = nfcWriterStats();
+  Serial.println("---NFC_STATS_START---");
+  Serial.print("pending,");     Serial.println(nfcWriterPending());
+  Serial.print("queued,");      Serial.println(s.queued);
+  Serial.print("written,");     Serial.println(s.written);
+  Serial.print("tag_full,");    Serial.println(s.tagFull);
+  Serial.print("expired,");     Serial.println(s.expired);
+  Serial.print("skipped,");     Serial.println(s.skipped);
+  Serial.print("polls,");       Serial.println(s.polls);
+  Serial.print("sessions,");    Serial.println(s.sessions);
+  Serial.print("tag_writes,");  Serial.println(s.tagWrites);
+  Serial.print("irq,");         Serial.println(s_irq ? 1 : 0);
+  Serial.print("wait_max_ms,"); Serial.println(s.waitMaxMs);
+  Serial.println("---NFC_STATS_END---");
+}
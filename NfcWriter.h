@@ -0,0 +1,98 @@
+#ifndef NFC_WRITER_H
+#define NFC_WRITER_H
+
+#include "Hal.h"
+
+// ---------------------------------------------------------------------------
+// NFC writer task: pending results wait for their tags in the background
+// ---------------------------------------------------------------------------
+// A finished test queues its COF with nfcWriterQueue() and the tester is
+// free for the next paddle (see below for builds without tag UUIDs). While anything is pending, the writer task
+// looks for tags and matches them by the paddle UUID the tag carries. With
+// the field empty it sleeps in the reader's card-detect mode until the
+// reader's IRQ reports a tag, so waiting costs no bus traffic and a tag is
+// read as soon as it arrives. A tag in the field, or a build without card
+// detect (HAL_NFC_CARD_DETECT, NFC_IRQ_PIN), is polled every NFC_POLL_MS
+// instead; a failed arm is tried again after NFC_IRQ_RETRY_MS. A pending
+// result is bound to the first tag presented for it: if that tag is
+// already bound to a result, the write retries that result; otherwise the
+// oldest unbound result is bound to it, so tags are expected in test order.
+// The write refuses any tag but the bound one. A tag that was just written
+// is ignored until it has left the field, so a tag left on the reader never
+// takes the next paddle's result. Matching by UUID needs HAL_NFC_TAG_UUID.
+//
+// Without it (the default build) each poll is an accumulate() of the
+// pending batch, which goes to whichever tag is in the field. So only one
+// paddle's results may wait: once its batch is complete, nfcWriterFull()
+// holds the next test back until the batch is written, skipped or expired,
+// and tags cannot be presented out of order. The writer cannot see a tag
+// leave either: a written tag left on the reader until the next paddle's
+// test has finished takes that result too.
+//
+// A paddle tested several times queues each result with more = true but
+// the last. Its results form one batch. The batch is bound to one tag and
+// written once complete, so the tag is not wanted before then: in a single
+// read-modify-write of the tag's payload with HAL_NFC_STAGED_COMMIT, else
+// one accumulate() per result in one bus acquisition. Whatever does not fit on the tag is
+// reported as tag full. nfcWriterEndBatch() completes an open batch early,
+// and skipping or expiry drops a whole batch.
+//
+// Tag-first workflow (NFC_TAG_FIRST_ENABLED, see Hal.h): nfcWriterPrefetch()
+// at START has the task read the next tag that shows up while the test
+// runs and keep its session open. The batch completed at the end of the
+// paddle's last test is bound to that tag and committed at once, without
+// waiting for a poll or reading the tag again. Prefetching only starts with
+// no complete batch pending, as their tags are due first. If no tag showed
+// up, the result waits for its tag as usual; nfcWriterPrefetchCancel() (test
+// aborted) drops the session. Without the workflow built in,
+// nfcWriterPrefetch() returns false.
+//
+// Results leave the queue when written, when the tag is full, when they
+// have waited NFC_TAG_WAIT_MS, or when skipped. The first three are
+// reported as events for the sketch's loop to show.
+
+#define NFC_MAX_PENDING  8
+#define NFC_POLL_MS      250        // without card detect, or a tag in the field
+#define NFC_IRQ_RECHECK_MS 5000     // card detect: in case an IRQ went missing
+#define NFC_IRQ_RETRY_MS 5000       // card detect failed to arm: try again after
+#define NFC_TAG_WAIT_MS  300000UL   // 5 minutes
+
+enum NfcWriterEventType {
+  NFC_EVT_WRITTEN,
+  NFC_EVT_TAG_FULL,
+  NFC_EVT_EXPIRED
+};
+
+struct NfcWriterEvent {
+  NfcWriterEventType type;
+  float              cof;        // the last one the outcome covers
+  uint8_t            count;      // results it covers
+  uint32_t           waitedMs;   // from queueing the batch to the outcome
+};
+
+struct NfcWriterStats {
+  uint32_t queued;
+  uint32_t written;
+  uint32_t tagFull;
+  uint32_t expired;
+  uint32_t skipped;
+  uint32_t polls;
+  uint32_t sessions;    // tags read ahead of their result
+  uint32_t tagWrites;   // payload writes: one per batch staged, else per result
+  uint32_t waitMaxMs;   // longest queue-to-write time
+};
+
+bool    nfcWriterStart(const uint8_t machineUuid[16], int core, int priority);
+bool    nfcWriterQueue(float cof, uint32_t timestamp, bool more);   // false: queue full
+void    nfcWriterEndBatch();                             // the open batch is complete
+bool    nfcWriterPrefetch();                             // false: results pending
+void    nfcWriterPrefetchCancel();
+bool    nfcWriterSkipOldest();                           // oldest batch; false: none
+bool    nfcWriterFull();                                 // the next test's result would be refused
+uint8_t nfcWriterPending();                              // results, not batches
+bool    nfcWriterPollEvent(NfcWriterEvent* ev);          // from loop()
+
+NfcWriterStats nfcWriterStats();
+void           nfcWriterStatsPrint();
+
+#endif // NFC_WRITER_H
@@ -0,0 +1,76 @@
+#include "Profiler.h"
+
+#if PROFILING_ENABLED
+
+// ---------------------------------------------------------------------------
+// Tables
+// ---------------------------------------------------------------------------
+// One row set per core. A row is only written by tasks on its own core, so
+// the hot path needs no lock; a print racing a record may show a row that is
+// one call stale.
+
+static ProfStat s_table[2][PROF_COUNT];
+
+static const char* const PROF_NAMES[PROF_COUNT] = {
+  "calculateCOF",
+  "avgPercentileBand",
+  "avgWithinOneStdDev",
+  "countsToPounds",
+  "oledFlush",
+  "nfcAccumulate",
+  "dumpTestDataCSV",
+  "displayFlush",
+  "displayFullFrame",
+  "resultPlot",
+};
+
+void profilerRecord(ProfId id, uint32_t cycles) {
+  ProfStat& s = s_table[halCoreId() & 1][id];
+  if (s.calls == 0 || cycles < s.minCycles) s.minCycles = cycles;
+  if (cycles > s.maxCycles) s.maxCycles = cycles;
+  s.totalCycles += cycles;
+  s.calls++;
+}
+
+void profilerReset() {
+  memset(s_table, 0, sizeof(s_table));
+}
+
+ProfStat profilerStat(ProfId id) {
+  ProfStat out = { 0, 0, 0, 0 };
+  for (int c = 0; c < 2; c++) {
+    const ProfStat& s = s_table[c][id];
+    if (s.calls == 0) continue;
+    if (out.calls == 0 || s.minCycles < out.minCycles) out.minCycles = s.minCycles;
+    if (s.maxCycles > out.maxCycles) out.maxCycles = s.maxCycles;
+    out.totalCycles += s.totalCycles;
+    out.calls += s.calls;
+  }
+  return out;
+}
+
+// ---------------------------------------------------------------------------
+// Report
+// ---------------------------------------------------------------------------
+
+void profilerPrint() {
+  float mhz = (float)halCpuFreqMhz();
+  char line[96];
+
+  Serial.println("---PROFILE_START---");
+  Serial.print("cpu_mhz,");
+  Serial.println((unsigned long)halCpuFreqMhz());
+  Serial.println("scope,calls,total_us,avg_us,min_us,max_us");
+  for (int i = 0; i < PROF_COUNT; i++) {
+    ProfStat s = profilerStat((ProfId)i);
+    float avg = (s.calls > 0) ? (float)s.totalCycles / s.calls : 0.0f;
+    snprintf(line, sizeof(line), "%s,%lu,%.1f,%.2f,%.2f,%.2f",
+             PROF_NAMES[i], (unsigned long)s.calls,
+             (double)(s.totalCycles / mhz), (double)(avg / mhz),
+             (double)(s.minCycles / mhz), (double)(s.maxCycles / mhz));
+    Serial.println(line);
+  }
+  Serial.println("---PROFILE_END---");
+}
+
+#endif // PROFILING_ENABLED
@@ -0,0 +1,71 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include "Hal.h"
+
+// ---------------------------------------------------------------------------
+// Scoped cycle-count profiler
+// ---------------------------------------------------------------------------
+// PROF_SCOPE(id) measures the enclosing block with halCycleCount() and folds
+// it into a fixed table of call count / total / min / max. Each core has its
+// own table (no locks on the hot path); profilerPrint() merges them.
+//
+// Build with -DPROFILING_ENABLED=0 to compile every marker out.
+
+#ifndef PROFILING_ENABLED
+#define PROFILING_ENABLED 1
+#endif
+
+enum ProfId {
+  PROF_CALCULATE_COF,
+  PROF_AVG_PERCENTILE,
+  PROF_AVG_STDDEV,
+  PROF_COUNTS_TO_POUNDS,
+  PROF_OLED_FLUSH,
+  PROF_NFC_ACCUMULATE,
+  PROF_CSV_DUMP,
+  PROF_DISPLAY_FLUSH,
+  PROF_DISPLAY_FULL_FRAME,
+  PROF_RESULT_PLOT,
+  PROF_COUNT
+};
+
+struct ProfStat {
+  uint32_t calls;
+  uint64_t totalCycles;
+  uint32_t minCycles;
+  uint32_t maxCycles;
+};
+
+#if PROFILING_ENABLED
+
+void profilerRecord(ProfId id, uint32_t cycles);
+void profilerReset();
+void profilerPrint();                      // table to Serial
+ProfStat profilerStat(ProfId id);          // merged across cores
+
+class ProfScope {
+ public:
+  explicit ProfScope(ProfId id) : id_(id), start_(halCycleCount()) {}
+  ~ProfScope() { profilerRecord(id_, halCycleCount() - start_); }
+
+ private:
+  ProfId   id_;
+  uint32_t start_;
+};
+
+#define PROF_CONCAT_(a, b) a##b
+#define PROF_CONCAT(a, b)  PROF_CONCAT_(a, b)
+#define PROF_SCOPE(id)     ProfScope PROF_CONCAT(profScope_, __LINE__)(id)
+
+#else
+
+inline void profilerReset() {}
+inline void profilerPrint() { Serial.println("Profiling disabled (PROFILING_ENABLED=0)"); }
+inline ProfStat profilerStat(ProfId) { ProfStat s = { 0, 0, 0, 0 }; return s; }
+
+#define PROF_SCOPE(id) ((void)0)
+
+#endif // PROFILING_ENABLED
+
+#endif // PROFILER_H
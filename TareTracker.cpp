@@ -0,0 +1,194 @@
+#include "TareTracker.h"
+
+// Shared with the sampling task, guarded by halCritical
+static volatile bool s_tracking = false;
+static volatile bool s_polling = false;   // a poll holds the load cell
+static long          s_maxSpread = 0;
+static long          s_maxStep = 0;
+static long          s_tare = 0;
+static bool          s_valid = false;
+static long          s_lastRaw = 0;
+static bool          s_hasLast = false;
+static TareTrackStats s_stats = {};
+static float         s_tempC = 0.0f;
+static bool          s_hasTemp = false;
+static bool          s_tempDue = false;   // read it on the next poll
+
+// Sampling task only
+static long    s_window[TARE_WINDOW];
+static uint8_t s_filled = 0;
+static uint8_t s_confirm = 0;   // consecutive stable windows beyond maxStep
+static long    s_pending = 0;   // where they sit
+static uint32_t s_tempAtMs = 0;  // last temperature read
+
+static void sortLongs(long* v, uint8_t n) {
+  for (uint8_t i = 1; i < n; i++) {
+    long x = v[i];
+    int j = i - 1;
+    while (j >= 0 && v[j] > x) { v[j + 1] = v[j]; j--; }
+    v[j + 1] = x;
+  }
+}
+
+long interquartileMean(long* v, uint8_t n) {
+  if (n == 0) return 0;
+  sortLongs(v, n);
+  uint8_t lo = n / 4, hi = n - n / 4;
+  long long sum = 0;
+  for (uint8_t i = lo; i < hi; i++) sum += v[i];
+  return (long)(sum / (hi - lo));
+}
+
+static void acceptWindow() {
+  long level = interquartileMean(s_window, TARE_WINDOW);   // sorts
+  long spread = s_window[TARE_WINDOW * 3 / 4] - s_window[TARE_WINDOW / 4];
+
+  halCriticalEnter();
+  if (spread > s_maxSpread) {
+    s_stats.noisy++;
+    s_confirm = 0;
+  } else if (!s_valid) {
+    s_tare = level;
+    s_valid = true;
+    s_stats.accepted++;
+  } else if (labs(level - s_tare) <= s_maxStep) {
+    s_tare += (level - s_tare) >> TARE_SMOOTH_SHIFT;
+    s_stats.accepted++;
+    s_confirm = 0;
+  } else {
+    // Far away: only a level that keeps coming back is a new baseline
+    if (s_confirm == 0 || labs(level - s_pending) > s_maxStep) {
+      s_pending = level;
+      s_confirm = 0;
+    }
+    if (++s_confirm >= TARE_CONFIRM_WINDOWS) {
+      s_tare = level;
+      s_confirm = 0;
+      s_stats.accepted++;
+    } else {
+      s_stats.stepped++;
+    }
+  }
+  halCriticalExit();
+}
+
+void tareTrackStart(long maxSpread, long maxStep) {
+  halCriticalEnter();
+  s_maxSpread = maxSpread;
+  s_maxStep = maxStep;
+  s_hasLast = false;
+  s_tempDue = true;
+  s_tracking = true;
+  halCriticalExit();
+}
+
+void tareTrackStop() {
+  halCriticalEnter();
+  s_tracking = false;
+  halCriticalExit();
+  for (;;) {
+    halCriticalEnter();
+    bool busy = s_polling;
+    halCriticalExit();
+    if (!busy) return;
+    halTaskDelayMs(1);
+  }
+}
+
+void tareTrackReset(long tare) {
+  halCriticalEnter();
+  s_tare = tare;
+  s_valid = false;
+  halCriticalExit();
+}
+
+void tareTrackPoll() {
+  halCriticalEnter();
+  bool tracking = s_tracking;
+  s_polling = tracking;
+  halCriticalExit();
+  if (!tracking) {
+    s_filled = 0;   // a window never spans a test or a calibration
+    s_confirm = 0;
+    return;
+  }
+
+  bool tempDue = s_tempDue || halMillis() - s_tempAtMs >= TARE_TEMP_PERIOD_MS;
+  float degC;
+  if (tempDue && halLoadCellReadTempC(&degC)) {
+    halCriticalEnter();
+    s_tempC = degC;
+    s_hasTemp = true;
+    s_tempDue = false;
+    s_stats.temps++;
+    halCriticalExit();
+    s_tempAtMs = halMillis();
+    s_filled = 0;
+  } else if (halLoadCellAvailable()) {
+    long raw = halLoadCellRead();
+    halCriticalEnter();
+    s_lastRaw = raw;
+    s_hasLast = true;
+    halCriticalExit();
+    s_window[s_filled++] = raw;
+    if (s_filled == TARE_WINDOW) {
+      acceptWindow();
+      s_filled = 0;
+    }
+  }
+
+  halCriticalEnter();
+  s_polling = false;
+  halCriticalExit();
+}
+
+bool tareTrackValid() {
+  halCriticalEnter();
+  bool v = s_valid;
+  halCriticalExit();
+  return v;
+}
+
+long tareTrackCurrent() {
+  halCriticalEnter();
+  long t = s_tare;
+  halCriticalExit();
+  return t;
+}
+
+bool tareTrackLastRaw(long* raw) {
+  halCriticalEnter();
+  bool has = s_hasLast;
+  *raw = s_lastRaw;
+  halCriticalExit();
+  return has;
+}
+
+bool tareTrackTempC(float* degC) {
+  halCriticalEnter();
+  bool has = s_hasTemp;
+  *degC = s_tempC;
+  halCriticalExit();
+  return has;
+}
+
+TareTrackStats tareTrackStats() {
+  halCriticalEnter();
+  TareTrackStats s = s_stats;
+  halCriticalExit();
+  return s;
+}
+
+void tareTrackPrint() {
+  TareTrackStats st = tareTrackStats();
+  Serial.println("---TARE_START---");
+  Serial.print("valid,");    Serial.println(tareTrackValid() ? 1 : 0);
+  Serial.print("tare_raw,"); Serial.println(tareTrackCurrent());
+  Serial.print("accepted,"); Serial.println(st.accepted);
+  Serial.print("noisy,");    Serial.println(st.noisy);
+  Serial.print("stepped,");  Serial.println(st.stepped);
+  Serial.print("temps,");    Serial.println(st.temps);
+  float degC;
+  if (tareTrackTempC(&degC)) { Serial.print("temp_c,"); Serial.println(degC, 2); }
+  Serial.println("---TARE_END---");
+}
@@ -0,0 +1,61 @@
+#ifndef TARE_TRACKER_H
+#define TARE_TRACKER_H
+
+#include "Hal.h"
+
+// ---------------------------------------------------------------------------
+// Background tare tracking
+// ---------------------------------------------------------------------------
+// The force sampling task calls tareTrackPoll() whenever it is not
+// collecting a pass. While tracking is on (the tester is idle), each poll
+// takes the load-cell reading, if one is ready, into a window of
+// TARE_WINDOW readings. A full window whose interquartile range is within
+// maxSpread (nothing touching or shaking the rig) is accepted, and its
+// interquartile mean becomes the tare. The trimmed mean ignores the top
+// and bottom quarter of the window, so spikes do not bias it.
+//
+// Small changes are smoothed in, which follows thermal drift. A stable
+// window more than maxStep away from the current tare (a hand resting on
+// the sled, or a remounted load cell) is only believed once it repeats for
+// TARE_CONFIRM_WINDOWS windows in a row.
+//
+// Every TARE_TEMP_PERIOD_MS of tracking, and first thing when tracking
+// starts, a poll reads the NAU7802's temperature instead (TempComp.h). The
+// switch to the sensor and back disturbs the readings around it, so the
+// window restarts. Tests and calibrations never see one, since tracking is
+// stopped for them.
+//
+// The load cell has one owner at a time: tareTrackStop() returns only once
+// the poll in progress, if any, has finished its reading.
+
+#define TARE_WINDOW          32   // readings; ~0.3 s at the idle poll rate
+#define TARE_SMOOTH_SHIFT    2    // accepted small change: tare += delta / 4
+#define TARE_CONFIRM_WINDOWS 20
+#define TARE_TEMP_PERIOD_MS  60000UL
+
+struct TareTrackStats {
+  uint32_t accepted;   // windows that updated the tare
+  uint32_t noisy;      // rejected: interquartile range over maxSpread
+  uint32_t stepped;    // held back: far from the tare, not yet confirmed
+  uint32_t temps;      // temperature reads
+};
+
+void tareTrackStart(long maxSpread, long maxStep);   // raw counts
+void tareTrackStop();
+void tareTrackPoll();                   // from the sampling task
+// A new calibration tare (calibration, or the stored one at boot): drops
+// what tracking had accepted so far, so the next accepted window starts
+// from a fresh reading instead of the old baseline. Call while stopped.
+void tareTrackReset(long tare);
+
+bool tareTrackValid();                  // a window has been accepted
+long tareTrackCurrent();                // raw counts
+bool tareTrackLastRaw(long* raw);       // latest reading while tracking
+bool tareTrackTempC(float* degC);       // latest temperature; false: none yet
+TareTrackStats tareTrackStats();
+void tareTrackPrint();
+
+// Mean of the middle half of v (sorted in place); n <= TARE_WINDOW
+long interquartileMean(long* v, uint8_t n);
+
+#endif // TARE_TRACKER_H
@@ -0,0 +1,57 @@
+#include "TempComp.h"
+#include <math.h>
+
+void tempModelCalibrated(TempModel* m, TempPoint* pts, uint8_t* n,
+                         float degC, long tareRaw) {
+  m->refC = degC;
+  pts[0].degC = degC;
+  pts[0].tareRaw = tareRaw;
+  pts[0].gain = 1.0f;
+  *n = 1;
+}
+
+bool tempModelAddPoint(TempModel* m, TempPoint* pts, uint8_t* n,
+                       const TempPoint& p) {
+  if (*n == TEMP_MAX_POINTS) {
+    // Keep the calibration (point 0), drop the oldest check
+    for (uint8_t i = 2; i < *n; i++) pts[i - 1] = pts[i];
+    (*n)--;
+  }
+  pts[(*n)++] = p;
+
+  float lo = pts[0].degC, hi = lo;
+  double sumT = 0, sumZ = 0, sumG = 0;
+  for (uint8_t i = 0; i < *n; i++) {
+    lo = fminf(lo, pts[i].degC);
+    hi = fmaxf(hi, pts[i].degC);
+    sumT += pts[i].degC;
+    sumZ += pts[i].tareRaw - pts[0].tareRaw;   // small numbers for the sums
+    sumG += pts[i].gain;
+  }
+  if (hi - lo < TEMP_MIN_SPAN_C) return false;
+
+  double meanT = sumT / *n, meanZ = sumZ / *n, meanG = sumG / *n;
+  double stt = 0, stz = 0, stg = 0;
+  for (uint8_t i = 0; i < *n; i++) {
+    double dt = pts[i].degC - meanT;
+    stt += dt * dt;
+    stz += dt * ((pts[i].tareRaw - pts[0].tareRaw) - meanZ);
+    stg += dt * (pts[i].gain - meanG);
+  }
+  double zSlope = stz / stt, gSlope = stg / stt;
+  double gainAtRef = meanG + gSlope * (m->refC - meanT);
+  if (gainAtRef <= 0.0) return false;
+
+  m->offsetPerC = (float)zSlope;
+  m->gainPerC = (float)(gSlope / gainAtRef);
+  m->points = *n - 1;
+  return true;
+}
+
+long tempModelTare(const TempModel& m, long tareAtRef, float degC) {
+  return tareAtRef + lroundf(m.offsetPerC * (degC - m.refC));
+}
+
+float tempModelGain(const TempModel& m, float degC) {
+  return 1.0f + m.gainPerC * (degC - m.refC);
+}
@@ -0,0 +1,54 @@
+#ifndef TEMP_COMP_H
+#define TEMP_COMP_H
+
+#include <Arduino.h>
+
+// ---------------------------------------------------------------------------
+// Load-cell temperature compensation
+// ---------------------------------------------------------------------------
+// A linear model of how the load cell's zero and gain move with the
+// NAU7802's temperature, relative to the temperature of the last
+// calibration (refC):
+//
+//   tare(T)  = tare at calibration + offsetPerC * (T - refC)
+//   gain(T)  = 1 + gainPerC * (T - refC)      counts per lb scale by this
+//
+// The coefficients are learned from check points: a tare and the reading
+// under a known weight, taken at a known temperature. The calibration
+// itself is the first point (gain 1 by definition); a check later in the
+// shift, once the rig has warmed, adds another. A point's gain is its
+// reading over what the calibration predicts for the weight. Once the points
+// span TEMP_MIN_SPAN_C, least-squares lines through tare and gain against
+// temperature give the coefficients. Until then the previous coefficients
+// stand (zero on a new unit), so a fresh calibration keeps what an earlier
+// one learned.
+
+#define TEMP_MAX_POINTS  8      // oldest check points (not the calibration) drop first
+#define TEMP_MIN_SPAN_C  3.0f   // learning needs points this far apart
+
+struct TempPoint {
+  float degC;
+  long  tareRaw;
+  float gain;     // reading under the weight / the calibration's prediction
+};
+
+struct TempModel {
+  float   refC;         // temperature at the last calibration
+  float   offsetPerC;   // tare, raw counts per °C
+  float   gainPerC;     // gain, fraction per °C
+  uint8_t points;       // check points the coefficients came from; 0: none
+};
+
+// New calibration at degC: the history restarts with it as the only point
+void tempModelCalibrated(TempModel* m, TempPoint* pts, uint8_t* n,
+                         float degC, long tareRaw);
+
+// Adds a check point (dropping the oldest check if full) and refits. False
+// if the points do not span TEMP_MIN_SPAN_C yet; the model is unchanged.
+bool tempModelAddPoint(TempModel* m, TempPoint* pts, uint8_t* n,
+                       const TempPoint& p);
+
+long  tempModelTare(const TempModel& m, long tareAtRef, float degC);
+float tempModelGain(const TempModel& m, float degC);
+
+#endif // TEMP_COMP_H
@@ -0,0 +1,70 @@
+#include "TextFormat.h"
+#include <math.h>
+
+static const uint32_t POW10[FMT_MAX_DECIMALS + 1] = { 1, 10, 100, 1000, 10000, 100000, 1000000 };
+
+// Copies len bytes of s (not terminated) into out, truncating to cap - 1
+static size_t put(char* out, size_t cap, const char* s, size_t len) {
+  if (!cap) return 0;
+  if (len > cap - 1) len = cap - 1;
+  memcpy(out, s, len);
+  out[len] = '\0';
+  return len;
+}
+
+// Writes v's decimal digits, right-aligned, ending just before end
+static char* digitsBackwards(char* end, uint32_t v) {
+  do {
+    *--end = (char)('0' + v % 10);
+    v /= 10;
+  } while (v);
+  return end;
+}
+
+size_t fmtLong(char* out, size_t cap, long v) {
+  char tmp[12];
+  char* end = tmp + sizeof(tmp);
+  uint32_t mag = (v < 0) ? 0u - (uint32_t)v : (uint32_t)v;
+  char* p = digitsBackwards(end, mag);
+  if (v < 0) *--p = '-';
+  return put(out, cap, p, end - p);
+}
+
+size_t fmtFixed(char* out, size_t cap, float v, uint8_t decimals) {
+  if (isnan(v)) return put(out, cap, "nan", 3);
+  if (isinf(v)) return put(out, cap, "inf", 3);
+  if (v > 2147483520.0f || v < -2147483520.0f) return put(out, cap, "ovf", 3);
+  if (decimals > FMT_MAX_DECIMALS) decimals = FMT_MAX_DECIMALS;
+
+  // Integer and fraction split exactly in float, then the fraction is
+  // scaled and rounded; a carry bumps the integer part (0.9996 -> 1.000)
+  float    mag  = fabsf(v);
+  uint32_t ip   = (uint32_t)mag;
+  uint32_t frac = (uint32_t)((mag - (float)ip) * (float)POW10[decimals] + 0.5f);
+  if (frac >= POW10[decimals]) {
+    frac -= POW10[decimals];
+    ip++;
+  }
+
+  char tmp[24];
+  char* end = tmp + sizeof(tmp);
+  char* p = end;
+  if (decimals) {
+    for (uint8_t i = 0; i < decimals; i++) {
+      *--p = (char)('0' + frac % 10);
+      frac /= 10;
+    }
+    *--p = '.';
+  }
+  p = digitsBackwards(p, ip);
+  // No "-0.000": the sign only shows when a nonzero digit does
+  bool nonzero = false;
+  for (const char* q = p; q < end; q++) nonzero |= (*q > '0');
+  if (v < 0 && nonzero) *--p = '-';
+  return put(out, cap, p, end - p);
+}
+
+TextBuf& TextBuf::add(const char* s) {
+  len_ += put(buf_ + len_, cap_ - len_, s, strlen(s));
+  return *this;
+}
@@ -0,0 +1,57 @@
+#ifndef TEXT_FORMAT_H
+#define TEXT_FORMAT_H
+
+#include "Hal.h"
+
+// ---------------------------------------------------------------------------
+// Allocation-free text formatting
+// ---------------------------------------------------------------------------
+// Display and calibration text is built in fixed char buffers instead of
+// Arduino String, whose constructors and concatenations allocate and, over
+// weeks of uptime, fragment the heap. Output that does not fit is
+// truncated; the buffer is always NUL-terminated.
+//
+// fmtFixed() formats in single precision and integer arithmetic (no
+// double, which the ESP32-S3 FPU does not have, and no printf). It
+// rounds half away from zero and prints "nan", "inf" and, beyond
+// +/-2^31, "ovf" like Print::print(float).
+
+#define FMT_MAX_DECIMALS 6
+
+// Formats v with a fixed number of decimals (at most FMT_MAX_DECIMALS).
+// Returns the length written.
+size_t fmtFixed(char* out, size_t cap, float v, uint8_t decimals);
+
+// Formats v in decimal. Returns the length written.
+size_t fmtLong(char* out, size_t cap, long v);
+
+// Appends to a caller-owned buffer
+class TextBuf {
+ public:
+  TextBuf(char* buf, size_t cap) : buf_(buf), cap_(cap), len_(0) { if (cap_) buf_[0] = '\0'; }
+
+  TextBuf& add(const char* s);
+  TextBuf& add(long v)                       { len_ += fmtLong(buf_ + len_, cap_ - len_, v); return *this; }
+  TextBuf& addFixed(float v, uint8_t decimals) { len_ += fmtFixed(buf_ + len_, cap_ - len_, v, decimals); return *this; }
+  void     clear()                           { len_ = 0; if (cap_) buf_[0] = '\0'; }
+
+  const char* c_str() const  { return buf_; }
+  size_t      length() const { return len_; }
+
+ private:
+  char*  buf_;
+  size_t cap_;
+  size_t len_;
+};
+
+// TextBuf with its own N-byte storage, for locals
+template <size_t N>
+class FixedText : public TextBuf {
+ public:
+  FixedText() : TextBuf(storage_, N) {}
+
+ private:
+  char storage_[N];
+};
+
+#endif // TEXT_FORMAT_H
@@ -0,0 +1,46 @@
+#include "Trace.h"
+
+#if TRACE_ENABLED
+
+#include <atomic>
+
+static TraceEvent            s_ring[TRACE_CAPACITY];
+static std::atomic<uint32_t> s_head(0);   // total events ever reserved
+static uint32_t              s_base = 0;  // s_head at the last clear
+
+void traceRecord(TraceId id, TraceType type, int32_t arg) {
+  uint32_t seq = s_head.fetch_add(1, std::memory_order_relaxed);
+  TraceEvent& e = s_ring[seq & (TRACE_CAPACITY - 1)];
+  e.tsUs = halMicros();
+  e.id   = (uint16_t)id;
+  e.type = (uint8_t)type;
+  e.core = (uint8_t)halCoreId();
+  e.arg  = arg;
+}
+
+void traceClear() {
+  s_base = s_head.load();
+}
+
+void traceDump(Print& out) {
+  uint32_t head  = s_head.load();
+  uint32_t total = head - s_base;
+  uint32_t count = (total > TRACE_CAPACITY) ? TRACE_CAPACITY : total;
+
+  TraceHeader h;
+  h.magic     = TRACE_MAGIC;
+  h.version   = TRACE_VERSION;
+  h.eventSize = sizeof(TraceEvent);
+  h.count     = count;
+  h.dropped   = total - count;
+
+  out.println("---TRACE_START---");
+  out.write((const uint8_t*)&h, sizeof(h));
+  for (uint32_t seq = head - count; seq != head; seq++) {
+    out.write((const uint8_t*)&s_ring[seq & (TRACE_CAPACITY - 1)], sizeof(TraceEvent));
+  }
+  out.println();
+  out.println("---TRACE_END---");
+}
+
+#endif // TRACE_ENABLED
@@ -0,0 +1,110 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include "Hal.h"
+
+// ---------------------------------------------------------------------------
+// Event trace ring
+// ---------------------------------------------------------------------------
+// Fixed-size ring of timestamped events from both cores. Writers reserve a
+// slot with one atomic increment and never block; once the ring is full the
+// oldest events are overwritten. traceDump() is meant to be called while the
+// tester is idle (no concurrent writers).
+//
+// Dump format (little-endian), framed by text marker lines:
+//   ---TRACE_START---\n
+//   TraceHeader, then header.count TraceEvent records (oldest first)
+//   \n---TRACE_END---\n
+// host/tools/trace_to_chrome.cpp turns it into Chrome/Perfetto JSON.
+//
+// Build with -DTRACE_ENABLED=0 to compile every marker out.
+
+#ifndef TRACE_ENABLED
+#define TRACE_ENABLED 1
+#endif
+
+#define TRACE_CAPACITY 2048      // events, power of two (12 bytes each)
+#define TRACE_MAGIC    0x52545446UL // "FTTR"
+#define TRACE_VERSION  1
+
+enum TraceId {
+  TR_RUN,            // runTest()                          B/E
+  TR_MOTION,         // motion task command, arg = cmd     B/E
+  TR_PHASE,          // phase change, arg = MotionPhase    instant
+  TR_SAMPLING,       // sampling pass, arg = phase         B/E
+  TR_SAMPLE_COUNT,   // samples in current pass            counter
+  TR_QUEUE_SEND,     // requestMotion() send, arg = cmd    instant
+  TR_SEM_WAIT,       // requestMotion() completion wait    B/E
+  TR_OLED_FLUSH,     // oledFlush() (frame present)        B/E
+  TR_NFC_POLL,       // accumulate() call, arg = result    B/E
+  TR_CSV_DUMP,       // dumpTestDataCSV()                  B/E
+  TR_DISPLAY_FLUSH,  // display task bus write, arg = pages B/E
+  TR_I2C_WAIT,       // shared bus wait, arg = I2cClient   B/E
+  TR_ID_COUNT
+};
+
+enum TraceType {
+  TRACE_BEGIN_EVT   = 'B',
+  TRACE_END_EVT     = 'E',
+  TRACE_INSTANT_EVT = 'i',
+  TRACE_COUNTER_EVT = 'C'
+};
+
+struct TraceEvent {
+  uint32_t tsUs;
+  uint16_t id;     // TraceId
+  uint8_t  type;   // TraceType
+  uint8_t  core;
+  int32_t  arg;
+};
+
+struct TraceHeader {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t eventSize;
+  uint32_t count;    // events that follow
+  uint32_t dropped;  // events overwritten since the last clear
+};
+
+inline const char* traceName(uint16_t id) {
+  switch (id) {
+    case TR_RUN:          return "runTest";
+    case TR_MOTION:       return "motion";
+    case TR_PHASE:        return "phase";
+    case TR_SAMPLING:     return "sampling";
+    case TR_SAMPLE_COUNT: return "samples";
+    case TR_QUEUE_SEND:   return "queueSend";
+    case TR_SEM_WAIT:     return "motionWait";
+    case TR_OLED_FLUSH:   return "oledFlush";
+    case TR_NFC_POLL:     return "nfcPoll";
+    case TR_CSV_DUMP:     return "csvDump";
+    case TR_DISPLAY_FLUSH: return "displayFlush";
+    case TR_I2C_WAIT:     return "i2cWait";
+    default:              return "unknown";
+  }
+}
+
+#if TRACE_ENABLED
+
+void traceRecord(TraceId id, TraceType type, int32_t arg);
+void traceClear();
+void traceDump(Print& out);
+
+#define TRACE_BEGIN(id, arg)   traceRecord((id), TRACE_BEGIN_EVT, (int32_t)(arg))
+#define TRACE_END(id, arg)     traceRecord((id), TRACE_END_EVT, (int32_t)(arg))
+#define TRACE_INSTANT(id, arg) traceRecord((id), TRACE_INSTANT_EVT, (int32_t)(arg))
+#define TRACE_COUNTER(id, val) traceRecord((id), TRACE_COUNTER_EVT, (int32_t)(val))
+
+#else
+
+inline void traceClear() {}
+inline void traceDump(Print& out) { out.println("Tracing disabled (TRACE_ENABLED=0)"); }
+
+#define TRACE_BEGIN(id, arg)   ((void)0)
+#define TRACE_END(id, arg)     ((void)0)
+#define TRACE_INSTANT(id, arg) ((void)0)
+#define TRACE_COUNTER(id, val) ((void)0)
+
+#endif // TRACE_ENABLED
+
+#endif // TRACE_H
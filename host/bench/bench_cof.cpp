@@ -0,0 +1,165 @@
+// ---------------------------------------------------------------------------
+// CofCalculation microbenchmarks
+// ---------------------------------------------------------------------------
+// Each benchmark is parameterized over samples per pass and a noise profile
+// (and the trim fraction for calculateCOF / dumpPairedDataCSV). Synthetic
+// passes follow the sketch's convention: forward force = +friction + bias,
+// reverse = -friction + bias, reverse recorded in the opposite direction.
+//
+//   ./bench_cof --benchmark_out=new.json --benchmark_out_format=json
+//   python3 bench/compare_bench.py old.json new.json
+
+#include <benchmark/benchmark.h>
+#include "CofCalculation.h"
+#include <random>
+#include <vector>
+
+namespace {
+
+enum Noise {
+  NOISE_GAUSSIAN,   // white noise, 1σ = 0.02 lb
+  NOISE_UNIFORM,    // ±0.04 lb
+  NOISE_STICKSLIP,  // 0.05 lb sawtooth plus white noise
+  NOISE_SPIKES,     // white noise plus 2% outliers of up to 1 lb
+  NOISE_COUNT
+};
+
+const char* const NOISE_NAMES[NOISE_COUNT] = {
+  "gaussian", "uniform", "stickslip", "spikes"
+};
+
+const float NORMAL_FORCE_LB = 8.0f;
+const float FRICTION_LB     = 2.0f;
+const float BIAS_LB         = 0.1f;
+
+struct Passes {
+  std::vector<float> fwd;
+  std::vector<float> rev;
+};
+
+float noiseAt(Noise kind, long i, std::mt19937& rng) {
+  std::normal_distribution<float>       gauss(0.0f, 0.02f);
+  std::uniform_real_distribution<float> uni(-0.04f, 0.04f);
+  switch (kind) {
+    case NOISE_GAUSSIAN:  return gauss(rng);
+    case NOISE_UNIFORM:   return uni(rng);
+    case NOISE_STICKSLIP: return 0.05f * (float)(i % 40) / 40.0f + gauss(rng);
+    case NOISE_SPIKES: {
+      std::uniform_real_distribution<float> u01(0.0f, 1.0f);
+      float n = gauss(rng);
+      if (u01(rng) < 0.02f) n += u01(rng);
+      return n;
+    }
+    default: return 0.0f;
+  }
+}
+
+Passes makePasses(long count, Noise kind) {
+  std::mt19937 rng(12345);
+  Passes p;
+  p.fwd.resize(count);
+  p.rev.resize(count);
+  for (long i = 0; i < count; i++) p.fwd[i] =  FRICTION_LB + BIAS_LB + noiseAt(kind, i, rng);
+  for (long i = 0; i < count; i++) p.rev[i] = -FRICTION_LB + BIAS_LB + noiseAt(kind, i, rng);
+  return p;
+}
+
+// Paired friction values as calculateCOF hands them to the averaging step
+std::vector<float> makePaired(long count, Noise kind) {
+  Passes p = makePasses(count, kind);
+  std::vector<float> out(count);
+  for (long i = 0; i < count; i++) {
+    out[i] = fabsf(p.fwd[i] - p.rev[count - 1 - i]) / 2.0f;
+  }
+  return out;
+}
+
+// Trim fractions are passed as per-mille integers
+float trimArg(const benchmark::State& state) {
+  return (float)state.range(2) / 1000.0f;
+}
+
+void setLabels(benchmark::State& state, long samples) {
+  state.SetLabel(NOISE_NAMES[state.range(1)]);
+  state.SetItemsProcessed(state.iterations() * samples);
+}
+
+// ---------------------------------------------------------------------------
+// Benchmarks
+// ---------------------------------------------------------------------------
+
+void BM_CalculateCOF(benchmark::State& state, AveragingFn avgFn) {
+  long count = (long)state.range(0);
+  Passes p = makePasses(count, (Noise)state.range(1));
+  float trim = trimArg(state);
+  for (auto _ : state) {
+    CofResult r = calculateCOF(p.fwd.data(), count, p.rev.data(), count,
+                               NORMAL_FORCE_LB, trim, avgFn);
+    benchmark::DoNotOptimize(r);
+  }
+  setLabels(state, count);
+}
+
+void BM_AvgPercentileBand(benchmark::State& state) {
+  long count = (long)state.range(0);
+  std::vector<float> v = makePaired(count, (Noise)state.range(1));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(avgPercentileBand(v.data(), count));
+  }
+  setLabels(state, count);
+}
+
+void BM_AvgWithinOneStdDev(benchmark::State& state) {
+  long count = (long)state.range(0);
+  std::vector<float> v = makePaired(count, (Noise)state.range(1));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(avgWithinOneStdDev(v.data(), count));
+  }
+  setLabels(state, count);
+}
+
+// Measures formatting only: the host Serial is muted for the run
+void BM_DumpPairedDataCSV(benchmark::State& state) {
+  long count = (long)state.range(0);
+  Passes p = makePasses(count, (Noise)state.range(1));
+  float trim = trimArg(state);
+  Serial.mute(true);
+  for (auto _ : state) {
+    dumpPairedDataCSV(p.fwd.data(), count, p.rev.data(), count, trim);
+  }
+  Serial.mute(false);
+  setLabels(state, count);
+}
+
+// Sample counts span short tests up to a full pass (COF_MAX_SAMPLES);
+// 83 per-mille is the sketch's 0.25/3.0 trim.
+void cofArgs(benchmark::internal::Benchmark* b) {
+  b->ArgNames({"samples", "noise", "trim_pm"});
+  for (long n : {250, 1000, 2000, COF_MAX_SAMPLES})
+    for (int noise = 0; noise < NOISE_COUNT; noise++)
+      for (int trim : {0, 83, 250})
+        b->Args({n, noise, trim});
+}
+
+void avgArgs(benchmark::internal::Benchmark* b) {
+  b->ArgNames({"samples", "noise"});
+  for (long n : {250, 1000, 2000, COF_MAX_SAMPLES})
+    for (int noise = 0; noise < NOISE_COUNT; noise++)
+      b->Args({n, noise});
+}
+
+void dumpArgs(benchmark::internal::Benchmark* b) {
+  b->ArgNames({"samples", "noise", "trim_pm"});
+  for (long n : {250, 1000, 3000})
+    b->Args({n, NOISE_GAUSSIAN, 83});
+}
+
+}  // namespace
+
+BENCHMARK_CAPTURE(BM_CalculateCOF, percentile_band, avgPercentileBand)->Apply(cofArgs);
+BENCHMARK_CAPTURE(BM_CalculateCOF, one_stddev, avgWithinOneStdDev)->Apply(cofArgs);
+BENCHMARK(BM_AvgPercentileBand)->Apply(avgArgs);
+BENCHMARK(BM_AvgWithinOneStdDev)->Apply(avgArgs);
+BENCHMARK(BM_DumpPairedDataCSV)->Apply(dumpArgs);
+
+BENCHMARK_MAIN();
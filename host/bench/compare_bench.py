@@ -0,0 +1,68 @@
+#!/usr/bin/env python3
+"""Compare two bench_cof JSON outputs (--benchmark_out_format=json).
+
+    python3 compare_bench.py baseline.json candidate.json [--metric cpu_time]
+                             [--threshold 5]
+
+Prints per-benchmark time change and exits 1 if any benchmark got slower
+by more than --threshold percent.
+"""
+
+import argparse
+import json
+import sys
+
+
+def load(path, metric):
+    with open(path) as f:
+        data = json.load(f)
+    out = {}
+    for b in data.get("benchmarks", []):
+        # With --benchmark_repetitions use the median aggregate only
+        if b.get("run_type") == "aggregate" and b.get("aggregate_name") != "median":
+            continue
+        name = b["run_name"] if "run_name" in b else b["name"]
+        label = b.get("label", "")
+        key = f"{name} [{label}]" if label else name
+        out[key] = (b[metric], b.get("time_unit", "ns"))
+    return out
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__,
+                                 formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("baseline")
+    ap.add_argument("candidate")
+    ap.add_argument("--metric", default="cpu_time", choices=["cpu_time", "real_time"])
+    ap.add_argument("--threshold", type=float, default=5.0,
+                    help="regression limit in percent (default 5)")
+    args = ap.parse_args()
+
+    base = load(args.baseline, args.metric)
+    cand = load(args.candidate, args.metric)
+
+    width = max((len(k) for k in base.keys() | cand.keys()), default=10)
+    print(f"{'benchmark':<{width}}  {'baseline':>12}  {'candidate':>12}  {'change':>8}")
+
+    regressions = 0
+    for key in sorted(base.keys() | cand.keys()):
+        if key not in base or key not in cand:
+            side = "baseline" if key in base else "candidate"
+            print(f"{key:<{width}}  only in {side}")
+            continue
+        (t0, unit), (t1, _) = base[key], cand[key]
+        change = (t1 - t0) / t0 * 100.0 if t0 > 0 else 0.0
+        flag = ""
+        if change > args.threshold:
+            flag = "  SLOWER"
+            regressions += 1
+        elif change < -args.threshold:
+            flag = "  faster"
+        print(f"{key:<{width}}  {t0:>10.1f}{unit:>2}  {t1:>10.1f}{unit:>2}  {change:>+7.1f}%{flag}")
+
+    print(f"\n{regressions} regression(s) over {args.threshold:.1f}%")
+    return 1 if regressions else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
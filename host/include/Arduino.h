@@ -0,0 +1,121 @@
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+// ---------------------------------------------------------------------------
+// Minimal Arduino core surface for host builds
+// ---------------------------------------------------------------------------
+// Only the language-level pieces the sketch and CofCalculation rely on:
+// Print/Serial, String, F()/PROGMEM and a few numeric helpers. Hardware
+// access goes through Hal.h and is implemented in HalHost.cpp.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <string>
+
+typedef uint8_t byte;
+typedef bool    boolean;
+
+#define HIGH          1
+#define LOW           0
+#define INPUT         0x01
+#define OUTPUT        0x03
+#define INPUT_PULLUP  0x05
+
+#define DEC 10
+#define HEX 16
+
+#define PROGMEM
+#define pgm_read_byte(addr) (*(const uint8_t*)(addr))
+#define memcpy_P            memcpy
+
+class __FlashStringHelper;
+#define F(s) (reinterpret_cast<const __FlashStringHelper*>(s))
+
+template <class T, class U>
+inline auto min(const T& a, const U& b) -> decltype(a < b ? a : b) { return (a < b) ? a : b; }
+template <class T, class U>
+inline auto max(const T& a, const U& b) -> decltype(a > b ? a : b) { return (a > b) ? a : b; }
+
+char* dtostrf(double val, signed char width, unsigned char prec, char* buf);
+
+// ---------------------------------------------------------------------------
+// String (heap-backed, like the Arduino one)
+// ---------------------------------------------------------------------------
+class String {
+ public:
+  String(const char* s = "") : s_(s ? s : "") {}
+  String(const std::string& s) : s_(s) {}
+  String(char c) : s_(1, c) {}
+  String(int v, unsigned char base = DEC);
+  String(unsigned int v, unsigned char base = DEC);
+  String(long v, unsigned char base = DEC);
+  String(unsigned long v, unsigned char base = DEC);
+  String(float v, unsigned char decimals = 2);
+  String(double v, unsigned char decimals = 2);
+
+  const char* c_str() const { return s_.c_str(); }
+  unsigned int length() const { return (unsigned int)s_.size(); }
+
+  String& operator+=(const String& o) { s_ += o.s_; return *this; }
+  friend String operator+(const String& a, const String& b) { return String(a.s_ + b.s_); }
+  friend String operator+(const char* a, const String& b) { return String(std::string(a) + b.s_); }
+  friend String operator+(const String& a, const char* b) { return String(a.s_ + b); }
+
+ private:
+  std::string s_;
+};
+
+// ---------------------------------------------------------------------------
+// Print
+// ---------------------------------------------------------------------------
+class Print {
+ public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t c) = 0;
+  virtual size_t write(const uint8_t* buf, size_t n);
+  size_t write(const char* s) { return write((const uint8_t*)s, strlen(s)); }
+
+  size_t print(const __FlashStringHelper* s);
+  size_t print(const char* s);
+  size_t print(const String& s);
+  size_t print(char c);
+  size_t print(unsigned char v, int base = DEC);
+  size_t print(int v, int base = DEC);
+  size_t print(unsigned int v, int base = DEC);
+  size_t print(long v, int base = DEC);
+  size_t print(unsigned long v, int base = DEC);
+  size_t print(double v, int digits = 2);
+
+  size_t println();
+  template <class T> size_t println(const T& v) { size_t n = print(v); return n + println(); }
+  template <class T> size_t println(const T& v, int fmt) { size_t n = print(v, fmt); return n + println(); }
+
+ private:
+  size_t printNumber(unsigned long v, int base);
+};
+
+// ---------------------------------------------------------------------------
+// Serial -> stdout (line-buffered per thread so task output doesn't interleave)
+// ---------------------------------------------------------------------------
+class HardwareSerial : public Print {
+ public:
+  void begin(unsigned long) {}
+  int  available();
+  int  read();
+  void flush();
+  size_t write(uint8_t c) override;
+  using Print::write;
+
+  // Host only: drop all output (long simulation batches)
+  void mute(bool on) { muted_ = on; }
+
+ private:
+  bool muted_ = false;
+};
+
+extern HardwareSerial Serial;
+
+#endif // HOST_ARDUINO_H
@@ -0,0 +1,112 @@
+#include <Arduino.h>
+#include <stdio.h>
+#include <mutex>
+#include <string>
+
+// ---------------------------------------------------------------------------
+// Numeric helpers
+// ---------------------------------------------------------------------------
+
+char* dtostrf(double val, signed char width, unsigned char prec, char* buf) {
+  sprintf(buf, "%*.*f", (int)width, (int)prec, val);
+  return buf;
+}
+
+static std::string formatInt(long long v, int base) {
+  char buf[72];
+  if (base == HEX) snprintf(buf, sizeof(buf), "%llX", (unsigned long long)v);
+  else             snprintf(buf, sizeof(buf), "%lld", v);
+  return buf;
+}
+
+// The ESP32 core's String(float) formats through a malloc'd scratch buffer
+// of decimals + 42 bytes; doing the same keeps the heap soak honest
+static std::string formatFloatScratch(double v, int decimals) {
+  char* buf = (char*)malloc(decimals + 42);
+  if (!buf) return std::string();
+  snprintf(buf, decimals + 42, "%.*f", decimals, v);
+  std::string s(buf);
+  free(buf);
+  return s;
+}
+
+String::String(int v, unsigned char base)           : s_(formatInt(v, base)) {}
+String::String(unsigned int v, unsigned char base)  : s_(formatInt(v, base)) {}
+String::String(long v, unsigned char base)          : s_(formatInt(v, base)) {}
+String::String(unsigned long v, unsigned char base) : s_(formatInt((long long)v, base)) {}
+String::String(float v, unsigned char decimals)     : s_(formatFloatScratch(v, decimals)) {}
+String::String(double v, unsigned char decimals)    : s_(formatFloatScratch(v, decimals)) {}
+
+// ---------------------------------------------------------------------------
+// Print
+// ---------------------------------------------------------------------------
+
+size_t Print::write(const uint8_t* buf, size_t n) {
+  size_t out = 0;
+  for (size_t i = 0; i < n; i++) out += write(buf[i]);
+  return out;
+}
+
+size_t Print::print(const __FlashStringHelper* s) { return print(reinterpret_cast<const char*>(s)); }
+size_t Print::print(const char* s)                { return write(s); }
+size_t Print::print(const String& s)              { return write(s.c_str()); }
+size_t Print::print(char c)                       { return write((uint8_t)c); }
+
+size_t Print::print(unsigned char v, int base)    { return printNumber(v, base); }
+size_t Print::print(unsigned int v, int base)     { return printNumber(v, base); }
+size_t Print::print(unsigned long v, int base)    { return printNumber(v, base); }
+size_t Print::print(int v, int base)              { return print((long)v, base); }
+
+size_t Print::print(long v, int base) {
+  if (base == DEC && v < 0) {
+    size_t n = print('-');
+    return n + printNumber((unsigned long)(-v), base);
+  }
+  return printNumber((unsigned long)v, base);
+}
+
+// Stack buffer, like Print::printFloat() on the device: printing never
+// touches the heap
+size_t Print::print(double v, int digits) {
+  char buf[64];
+  snprintf(buf, sizeof(buf), "%.*f", digits, v);
+  return write(buf);
+}
+
+size_t Print::println() {
+  return write((const uint8_t*)"\r\n", 2);
+}
+
+size_t Print::printNumber(unsigned long v, int base) {
+  char buf[72];
+  if (base == HEX) snprintf(buf, sizeof(buf), "%lX", v);
+  else             snprintf(buf, sizeof(buf), "%lu", v);
+  return write(buf);
+}
+
+// ---------------------------------------------------------------------------
+// Serial
+// ---------------------------------------------------------------------------
+
+HardwareSerial Serial;
+
+static std::mutex s_stdoutMutex;
+static thread_local std::string t_line;
+
+size_t HardwareSerial::write(uint8_t c) {
+  if (muted_ || c == '\r') return 1;
+  t_line.push_back((char)c);
+  if (c == '\n') flush();
+  return 1;
+}
+
+void HardwareSerial::flush() {
+  if (t_line.empty()) return;
+  std::lock_guard<std::mutex> lock(s_stdoutMutex);
+  fwrite(t_line.data(), 1, t_line.size(), stdout);
+  fflush(stdout);
+  t_line.clear();
+}
+
+int HardwareSerial::available() { return 0; }
+int HardwareSerial::read()      { return -1; }
@@ -0,0 +1,53 @@
+#include "FrictionModel.h"
+#include <math.h>
+
+static const float TWO_PI_F = 6.28318531f;
+
+void seedRng(std::mt19937& rng, uint64_t seed) {
+  if (seed >> 32) {
+    std::seed_seq seq{ (uint32_t)seed, (uint32_t)(seed >> 32) };
+    rng.seed(seq);
+  } else {
+    rng.seed((uint32_t)seed);
+  }
+}
+
+FrictionModel::FrictionModel(const FrictionParams& p, uint64_t seed)
+  : p_(p), gauss_(0.0f, 1.0f), lastT_(0.0), lagged_(0.0f) {
+  seedRng(rng_, seed);
+}
+
+float FrictionModel::evaluate(double tSec, float posIn, bool moving, bool forward,
+                              const float* targetOverrideLb) {
+  float target = 0.0f;
+  if (moving) {
+    if (targetOverrideLb) {
+      target = *targetOverrideLb;
+    } else {
+      float dir = forward ? 1.0f : -1.0f;
+      float kinetic = p_.cof * p_.normalForceLb;
+      float surface = p_.surfaceLb * sinf(TWO_PI_F * posIn / p_.surfacePeriodIn);
+
+      // Sawtooth: force builds while stuck, drops on slip
+      float phase = posIn / p_.stickSlipPeriodIn;
+      phase -= floorf(phase);
+      float stick = p_.stickSlipLb * (phase - 0.5f);
+
+      target = dir * (kinetic + surface + stick);
+    }
+  }
+
+  // First-order settle toward the target
+  double dt = tSec - lastT_;
+  lastT_ = tSec;
+  if (p_.settleMs <= 0.0f || dt <= 0.0) {
+    if (p_.settleMs <= 0.0f) lagged_ = target;
+  } else {
+    float alpha = 1.0f - expf(-(float)dt * 1000.0f / p_.settleMs);
+    lagged_ += (target - lagged_) * alpha;
+  }
+
+  float drift = p_.driftLbPerMin * (float)(tSec / 60.0);
+  float noise = (p_.noiseLb > 0.0f) ? p_.noiseLb * gauss_(rng_) : 0.0f;
+  return lagged_ + p_.offsetLb + drift + noise;
+}
@@ -0,0 +1,60 @@
+#ifndef FRICTION_MODEL_H
+#define FRICTION_MODEL_H
+
+#include <stdint.h>
+#include <random>
+
+// ---------------------------------------------------------------------------
+// Friction force model
+// ---------------------------------------------------------------------------
+// Force seen by the load cell while the paddle is dragged across the test
+// surface, in lb, as a function of carriage position, direction and time.
+//
+//   kinetic   ±cof × normalForce, sign follows direction of travel
+//   surface   position-dependent variation shared by both passes (grain)
+//   stickSlip sawtooth over travelled distance, resets on each slip
+//   settle    first-order lag of the rig after a start/stop/reversal
+//   offset    constant load-cell offset (cancels in the paired math)
+//   drift     linear load-cell drift over time
+//   noise     white Gaussian noise
+//
+// Stateful (lag filter + RNG): call evaluate() with non-decreasing time.
+
+struct FrictionParams {
+  float cof               = 0.25f;
+  float normalForceLb     = 2.59f;
+  float surfaceLb         = 0.0f;   // amplitude of surface variation
+  float surfacePeriodIn   = 0.4f;
+  float stickSlipLb       = 0.0f;   // sawtooth peak-to-peak
+  float stickSlipPeriodIn = 0.05f;
+  float settleMs          = 20.0f;  // lag time constant
+  float offsetLb          = 0.0f;
+  float driftLbPerMin     = 0.0f;
+  float noiseLb           = 0.005f; // 1σ
+};
+
+// Seeds an engine from a 64-bit seed. A seed below 2^32 gives the same
+// stream as seeding with it directly, so existing 32-bit runs reproduce.
+void seedRng(std::mt19937& rng, uint64_t seed);
+
+class FrictionModel {
+ public:
+  FrictionModel(const FrictionParams& p, uint64_t seed);
+
+  // moving: carriage is stepping; forward: away from the limit switch.
+  // targetOverrideLb, if non-null, replaces kinetic+surface+stickSlip
+  // (used for trace replay).
+  float evaluate(double tSec, float posIn, bool moving, bool forward,
+                 const float* targetOverrideLb = nullptr);
+
+  const FrictionParams& params() const { return p_; }
+
+ private:
+  FrictionParams p_;
+  std::mt19937   rng_;
+  std::normal_distribution<float> gauss_;
+  double lastT_;
+  float  lagged_;
+};
+
+#endif // FRICTION_MODEL_H
@@ -0,0 +1,563 @@
+#include "HalHost.h"
+#include "I2cBus.h"
+#include "IoRecorder.h"
+#include "RigSim.h"
+#include "VirtualScheduler.h"
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// ---------------------------------------------------------------------------
+// Linux HAL: std::thread tasks, steady_clock time, RigSim peripherals
+// ---------------------------------------------------------------------------
+// Two runtimes:
+//   threaded       one std::thread per task; virtual time runs s_timeScale
+//                  times faster than the wall clock (queries scaled up,
+//                  waits scaled down)
+//   deterministic  every task is a VirtualScheduler fiber on one thread and
+//                  the clock is the scheduler's discrete-event time
+
+static RigSim*           s_rig = nullptr;
+static VirtualScheduler* s_sched = nullptr;
+static SimDisplay       s_display;
+static thread_local int t_core = 1;
+static double           s_timeScale = 1.0;
+
+static const std::chrono::steady_clock::time_point s_epoch =
+    std::chrono::steady_clock::now();
+
+void hostSetRig(RigSim* rig)      { s_rig = rig; }
+void hostSetCurrentCore(int core) { t_core = core; }
+void hostSetTimeScale(double scale) { s_timeScale = (scale > 0.0) ? scale : 1.0; }
+void hostUseScheduler(VirtualScheduler* sched) { s_sched = sched; }
+
+void halBegin(const HalConfig& cfg) {
+  if (s_rig) s_rig->attach(cfg);
+  ioRecordConfigure(cfg);
+}
+
+// ---------------------------------------------------------------------------
+// Clock
+// ---------------------------------------------------------------------------
+
+static uint64_t elapsedUs() {
+  if (s_sched) return s_sched->nowUs();
+  auto real = std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now() - s_epoch).count();
+  return (uint64_t)(real * s_timeScale / 1000.0);
+}
+
+// Wall-clock duration of a virtual-time wait
+static std::chrono::microseconds realWait(uint64_t virtualUs) {
+  return std::chrono::microseconds((int64_t)(virtualUs / s_timeScale));
+}
+
+uint32_t halMillis() { return (uint32_t)(elapsedUs() / 1000); }
+uint32_t halMicros() { return (uint32_t)elapsedUs(); }
+
+// Host "cycles" are wall-clock nanoseconds: profiles show real host CPU cost
+// regardless of time scale or scheduler
+uint32_t halCycleCount() {
+  return (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+uint32_t halCpuFreqMhz() { return 1000; }
+
+void halDelayMs(uint32_t ms) {
+  // delay() is vTaskDelay() on the ESP32: the core is released
+  if (s_sched) { s_sched->sleepUs((uint64_t)ms * 1000); return; }
+  halDelayUs(ms * 1000);
+}
+
+void halDelayUs(uint32_t us) {
+  // delayMicroseconds() spins: the core stays busy
+  if (s_sched) { s_sched->busyWaitUs(us); return; }
+
+  // Short waits spin like delayMicroseconds(); sleep_for overshoots by tens of µs
+  uint64_t until = elapsedUs() + us;
+  if (realWait(us).count() >= 200) {
+    std::this_thread::sleep_for(realWait(us));
+    return;
+  }
+  while (elapsedUs() < until) std::this_thread::yield();
+}
+
+// ---------------------------------------------------------------------------
+// GPIO / LED
+// ---------------------------------------------------------------------------
+
+void halPinMode(uint8_t, uint8_t) {}
+
+void halDigitalWrite(uint8_t pin, uint8_t level) {
+  if (s_rig) s_rig->pinWrite(pin, level, halMicros());
+  ioRecordPinWrite(pin, level);
+}
+
+int halDigitalRead(uint8_t pin) {
+  int level = s_rig ? s_rig->pinRead(pin, halMicros()) : HIGH;
+  ioRecordPinRead(pin, level);
+  return level;
+}
+
+void halLedBegin(uint8_t) {}
+void halLedSet(uint8_t, uint8_t, uint8_t) {}
+void halLedOff() {}
+
+// ---------------------------------------------------------------------------
+// Display
+// ---------------------------------------------------------------------------
+
+// Standard-mode clock, the Arduino Wire default, until halI2cProbeClock()
+static uint32_t s_i2cHz = 100000;
+
+// Per-transaction cost of the ESP32 I2C driver beyond the clocked bits
+// (command list setup, start/stop, completion interrupt)
+static const uint32_t I2C_TXN_OVERHEAD_US = 30;
+
+void hostI2cTransfer(uint32_t bytes, uint32_t transactions, uint32_t clockHz) {
+  if (!clockHz) clockHz = s_i2cHz;
+  uint64_t us = (uint64_t)bytes * 9 * 1000000 / clockHz +
+                (uint64_t)transactions * I2C_TXN_OVERHEAD_US;
+  if (s_sched) { s_sched->sleepUs(us); return; }
+  std::this_thread::sleep_for(realWait(us));
+}
+
+HalDisplay& halDisplay()  { return s_display; }
+void halI2cBegin()        { i2cBusBegin(); }
+
+uint32_t halI2cProbeClock(uint32_t maxHz) {
+  static const uint32_t clocks[] = HAL_I2C_CLOCKS;
+  uint32_t chosen = 100000;
+  i2cBusAcquire(I2C_CLIENT_NFC);
+  for (uint32_t hz : clocks) {
+    if (hz <= maxHz && (!s_rig || s_rig->i2cClockOk(hz))) {
+      chosen = hz;
+      break;
+    }
+  }
+  s_i2cHz = chosen;
+  i2cBusRelease();
+  return chosen;
+}
+
+uint32_t halI2cClockHz() { return s_i2cHz; }
+
+uint32_t halDisplayWriteRect(uint8_t page0, uint8_t page1, uint8_t col0,
+                             uint8_t col1, const uint8_t* frame) {
+  // Mirrors the device: one addressing transaction, then data transactions
+  // of up to one bus slice with a frame-sized Wire buffer, yielding to NFC
+  // transfers between them
+  uint32_t cap = s_i2cHz / 9 * I2C_DISPLAY_SLICE_US / 1000000;
+  if (cap > 1024) cap = 1024;
+  uint32_t span = col1 - col0 + 1;
+  uint32_t data = span * (page1 - page0 + 1);
+  uint32_t txns = (data + cap - 1) / cap;
+  uint32_t bytes = 8 + data + 2 * txns;
+
+  i2cBusAcquire(I2C_CLIENT_DISPLAY);
+  for (uint8_t p = page0; p <= page1; p++)
+    s_display.writeGddram(p, col0, col1, frame + p * 128 + col0);
+  hostI2cTransfer(8, 1);
+  for (uint32_t left = data; left; ) {
+    uint32_t len = (left < cap) ? left : cap;
+    hostI2cTransfer(2 + len, 1);
+    left -= len;
+    if (left) i2cBusYield();
+  }
+  i2cBusRelease();
+  return bytes;
+}
+
+bool halDisplayBegin()    { return s_display.begin(SSD1306_SWITCHCAPVCC, 0x3C); }
+
+// ---------------------------------------------------------------------------
+// Load cell
+// ---------------------------------------------------------------------------
+
+// Modeled NAU7802 power-up and internal offset calibration (estimates)
+static const uint32_t NAU_BEGIN_MS   = 50;
+static const uint32_t NAU_AFE_CAL_MS = 100;
+
+bool halLoadCellBegin() {
+  halDelayMs(NAU_BEGIN_MS);
+  return s_rig != nullptr;
+}
+
+void halLoadCellCalibrateAFE() { halDelayMs(NAU_AFE_CAL_MS); }
+
+bool halLoadCellAvailable() {
+  return s_rig && s_rig->loadCellAvailable(halMicros());
+}
+
+long halLoadCellRead() {
+  long raw = s_rig ? s_rig->loadCellRead(halMicros()) : 0;
+  ioRecordAdc(raw);
+  return raw;
+}
+
+bool halLoadCellReadTempC(float* degC) {
+  if (!s_rig) return false;
+  halDelayMs(HAL_TEMP_READ_MS);
+  *degC = s_rig->loadCellTempC(halMicros());
+  return true;
+}
+
+// ---------------------------------------------------------------------------
+// Persistent storage (in memory, survives for the life of the process)
+// ---------------------------------------------------------------------------
+
+static std::mutex                    s_prefsMutex;
+static std::string                   s_prefsNs;
+static std::map<std::string, double> s_prefs;
+
+static std::string prefsKey(const std::string& ns, const char* key) {
+  return ns + "/" + key;
+}
+
+void hostPrefsSeedFloat(const char* ns, const char* key, float value) {
+  std::lock_guard<std::mutex> lock(s_prefsMutex);
+  s_prefs[prefsKey(ns, key)] = value;
+}
+
+bool halPrefsBegin(const char* ns, bool) {
+  std::lock_guard<std::mutex> lock(s_prefsMutex);
+  s_prefsNs = ns;
+  return true;
+}
+
+void halPrefsEnd() {}
+
+static double prefsGet(const char* key, double def) {
+  std::lock_guard<std::mutex> lock(s_prefsMutex);
+  auto it = s_prefs.find(prefsKey(s_prefsNs, key));
+  return (it == s_prefs.end()) ? def : it->second;
+}
+
+static void prefsPut(const char* key, double value) {
+  std::lock_guard<std::mutex> lock(s_prefsMutex);
+  s_prefs[prefsKey(s_prefsNs, key)] = value;
+}
+
+float halPrefsGetFloat(const char* key, float def) { return (float)prefsGet(key, def); }
+void  halPrefsPutFloat(const char* key, float v)   { prefsPut(key, v); }
+long  halPrefsGetLong(const char* key, long def)   { return (long)prefsGet(key, (double)def); }
+void  halPrefsPutLong(const char* key, long v)     { prefsPut(key, (double)v); }
+
+// ---------------------------------------------------------------------------
+// NFC
+// ---------------------------------------------------------------------------
+
+// Modeled reader traffic: a tag search (command, ACK, status and response
+// reads) per accumulate() call, plus the read-modify-write of the tag's
+// records when one answers. Estimates; the library's exact exchange varies
+// with the tag.
+static const uint32_t NFC_POLL_BYTES = 48;
+static const uint32_t NFC_POLL_TXNS  = 6;
+static const uint32_t NFC_RMW_BYTES  = 1200;
+static const uint32_t NFC_RMW_TXNS   = 60;
+
+// Modeled bring-up times: reader wake-up and configuration, and the
+// signing key setup. Estimates, as above.
+static const uint32_t NFC_BEGIN_MS    = 150;
+static const uint32_t CRYPTO_BEGIN_MS = 200;
+
+bool halNfcBegin() {
+  i2cBusAcquire(I2C_CLIENT_NFC);
+  hostI2cTransfer(NFC_POLL_BYTES, NFC_POLL_TXNS);
+  i2cBusRelease();
+  halDelayMs(NFC_BEGIN_MS);
+  return true;
+}
+
+bool halNfcDetectTag(uint8_t paddleUuid[16]) {
+  i2cBusAcquire(I2C_CLIENT_NFC);
+  hostI2cTransfer(NFC_POLL_BYTES, NFC_POLL_TXNS);
+  bool found = s_rig && s_rig->nfcDetect(paddleUuid, halMillis());
+  i2cBusRelease();
+  return found;
+}
+
+// Card detect: one command puts the reader in the mode. The reader's own
+// field check, every NFC_SENSE_MS without bus traffic, is a task watching
+// the rig, and its IRQ line gives the armed semaphore.
+static const uint32_t NFC_ARM_BYTES = 12;
+static const uint32_t NFC_ARM_TXNS  = 2;
+static const uint32_t NFC_SENSE_MS  = 50;
+
+static HalSemaphore s_nfcIrqArm = nullptr;
+static HalSemaphore s_nfcIrqWake = nullptr;
+
+static void nfcIrqTask(void*) {
+  for (;;) {
+    halSemTake(s_nfcIrqArm, HAL_WAIT_FOREVER);
+    while (!s_rig->nfcFieldSense(halMillis())) halTaskDelayMs(NFC_SENSE_MS);
+    halSemGive(s_nfcIrqWake);
+  }
+}
+
+bool halNfcArmTagIrq(HalSemaphore wake) {
+  // As on the device: the library must offer the mode and the board wire
+  // the line
+  if (!HAL_NFC_CARD_DETECT || !s_rig || !s_rig->options().nfcIrq ||
+      s_rig->config().pinNfcIrq == HAL_NO_PIN) return false;
+  if (!s_nfcIrqArm) {
+    s_nfcIrqArm = halSemCreateBinary();
+    halTaskCreate(nfcIrqTask, "NfcIrq", 4096, nullptr, 5, 0);
+  }
+  i2cBusAcquire(I2C_CLIENT_NFC);
+  hostI2cTransfer(NFC_ARM_BYTES, NFC_ARM_TXNS);
+  i2cBusRelease();
+  s_nfcIrqWake = wake;
+  halSemGive(s_nfcIrqArm);
+  return true;
+}
+
+bool halCryptoBegin(const uint8_t*, const uint8_t*) {
+  halDelayMs(CRYPTO_BEGIN_MS);
+  return true;
+}
+void halNfcAccumulatorBegin(uint8_t)               {}
+
+// Each measurement beyond the first lengthens the payload write by its
+// signed record
+static const uint32_t NFC_MEAS_BYTES = 96;
+static const uint32_t NFC_MEAS_TXNS  = 5;
+
+static void nfcWriteTransfer(uint32_t bytes, uint32_t txns, uint8_t written) {
+  if (!written) return;
+  hostI2cTransfer(bytes + (written - 1u) * NFC_MEAS_BYTES, txns + (written - 1u) * NFC_MEAS_TXNS);
+}
+
+static void nfcResultText(HalNfcResult r, char* msg, size_t msgLen) {
+  if (!msg || msgLen == 0) return;
+  const char* text = "sim: no tag";
+  if      (r == HAL_NFC_SUCCESS)     text = "sim: written";
+  else if (r == HAL_NFC_TAG_FULL)    text = "sim: tag full";
+  else if (r == HAL_NFC_WRITE_ERROR) text = "sim: tag gone";
+  else if (r == HAL_NFC_WRONG_TAG)   text = "sim: wrong tag";
+  snprintf(msg, msgLen, "%s", text);
+}
+
+HalNfcResult halNfcAccumulate(const uint8_t*, const uint8_t* paddleUuid, const uint32_t*,
+                              const float* cofs, uint8_t count, uint8_t* written,
+                              char* msg, size_t msgLen) {
+  *written = 0;
+#if !HAL_NFC_TAG_UUID
+  if (paddleUuid) {   // as on the device: the tag cannot be checked
+    nfcResultText(HAL_NFC_WRONG_TAG, msg, msgLen);
+    return HAL_NFC_WRONG_TAG;
+  }
+#endif
+  i2cBusAcquire(I2C_CLIENT_NFC);
+  hostI2cTransfer(NFC_POLL_BYTES, NFC_POLL_TXNS);
+#if HAL_NFC_STAGED_COMMIT
+  HalNfcResult r = s_rig ? s_rig->nfcAccumulate(paddleUuid, cofs, count, halMillis(), written)
+                         : HAL_NFC_NO_TAG;
+  nfcWriteTransfer(NFC_RMW_BYTES, NFC_RMW_TXNS, *written);
+#else
+  // As on the device: one accumulate() per measurement, each its own tag
+  // search and read-modify-write
+  HalNfcResult r = HAL_NFC_NO_TAG;
+  for (uint8_t k = 0; s_rig && k < count; k++) {
+    if (k) hostI2cTransfer(NFC_POLL_BYTES, NFC_POLL_TXNS);
+    uint8_t one = 0;
+    r = s_rig->nfcAccumulate(paddleUuid, &cofs[k], 1, halMillis(), &one);
+    nfcWriteTransfer(NFC_RMW_BYTES, NFC_RMW_TXNS, one);
+    *written += one;
+    if (r != HAL_NFC_SUCCESS) break;
+  }
+#endif
+  i2cBusRelease();
+  nfcResultText(r, msg, msgLen);
+  return r;
+}
+
+// Tag-first session: the read half of the read-modify-write on open, the
+// write half on commit
+static const uint32_t NFC_HALF_BYTES = NFC_RMW_BYTES / 2;
+static const uint32_t NFC_HALF_TXNS  = NFC_RMW_TXNS / 2;
+
+HalNfcResult halNfcSessionOpen(uint8_t paddleUuid[16], char* msg, size_t msgLen) {
+  i2cBusAcquire(I2C_CLIENT_NFC);
+  hostI2cTransfer(NFC_POLL_BYTES, NFC_POLL_TXNS);
+  bool found = s_rig && s_rig->nfcSessionOpen(paddleUuid, halMillis());
+  if (found) hostI2cTransfer(NFC_HALF_BYTES, NFC_HALF_TXNS);
+  i2cBusRelease();
+  if (msg && msgLen > 0) snprintf(msg, msgLen, "%s", found ? "sim: session open" : "sim: no tag");
+  return found ? HAL_NFC_SUCCESS : HAL_NFC_NO_TAG;
+}
+
+HalNfcResult halNfcSessionCommit(const uint8_t*, const uint32_t*, const float* cofs,
+                                 uint8_t count, uint8_t* written, char* msg, size_t msgLen) {
+  *written = 0;
+  i2cBusAcquire(I2C_CLIENT_NFC);
+  HalNfcResult r = s_rig ? s_rig->nfcSessionCommit(cofs, count, halMillis(), written)
+                         : HAL_NFC_READ_ERROR;
+  nfcWriteTransfer(NFC_HALF_BYTES, NFC_HALF_TXNS, *written);
+  i2cBusRelease();
+  nfcResultText(r, msg, msgLen);
+  return r;
+}
+
+void halNfcSessionClose() {
+  if (s_rig) s_rig->nfcSessionClose();
+}
+
+// ---------------------------------------------------------------------------
+// Task primitives
+// ---------------------------------------------------------------------------
+
+// Fixed ring of length items allocated at creation, like a FreeRTOS queue:
+// sending and receiving never touch the heap
+struct HalQueueImpl {
+  std::mutex                  m;
+  std::condition_variable     cv;
+  VirtualScheduler::WaitList  waiters;
+  std::vector<uint8_t>        ring;
+  uint32_t                    head = 0;   // next item to receive
+  uint32_t                    count = 0;
+  uint32_t                    length;
+  uint32_t                    itemSize;
+
+  void push(const void* item) {
+    memcpy(&ring[((head + count) % length) * itemSize], item, itemSize);
+    count++;
+  }
+  void pop(void* item) {
+    memcpy(item, &ring[head * itemSize], itemSize);
+    head = (head + 1) % length;
+    count--;
+  }
+};
+
+struct HalSemImpl {
+  std::mutex                  m;
+  std::condition_variable     cv;
+  VirtualScheduler::WaitList  waiters;
+  bool                        given = false;
+};
+
+// Deterministic counterpart of waitFor(): re-checks pred after every wake-up
+// until it holds or the deadline passes.
+template <class Pred>
+static bool virtualWaitFor(VirtualScheduler::WaitList& w, uint32_t timeoutMs, Pred pred) {
+  uint64_t deadline = (timeoutMs == HAL_WAIT_FOREVER)
+                        ? VirtualScheduler::FOREVER
+                        : s_sched->nowUs() + (uint64_t)timeoutMs * 1000;
+  while (!pred()) {
+    uint64_t now = s_sched->nowUs();
+    if (deadline != VirtualScheduler::FOREVER && now >= deadline) return false;
+    uint64_t remaining = (deadline == VirtualScheduler::FOREVER)
+                           ? VirtualScheduler::FOREVER : deadline - now;
+    s_sched->waitOn(w, remaining);
+  }
+  return true;
+}
+
+template <class Pred>
+static bool waitFor(std::condition_variable& cv, std::unique_lock<std::mutex>& lock,
+                    uint32_t timeoutMs, Pred pred) {
+  if (timeoutMs == HAL_WAIT_FOREVER) {
+    cv.wait(lock, pred);
+    return true;
+  }
+  return cv.wait_for(lock, realWait((uint64_t)timeoutMs * 1000), pred);
+}
+
+bool halTaskCreate(HalTaskFn fn, const char* name, uint32_t stackBytes, void* arg,
+                   int priority, int core) {
+  if (s_sched) {
+    s_sched->spawn(fn, arg, name, priority, core, stackBytes);
+    return true;
+  }
+  std::thread([fn, arg, core]() {
+    t_core = core;
+    fn(arg);
+  }).detach();
+  return true;
+}
+
+void halTaskDelayMs(uint32_t ms) { halDelayMs(ms); }
+void halTaskExit()               {}   // the task function returns right after
+int  halCoreId()                 { return s_sched ? s_sched->currentCore() : t_core; }
+void halDisableCore1Wdt()        {}
+
+HalQueue halQueueCreate(uint32_t length, uint32_t itemSize) {
+  HalQueueImpl* q = new HalQueueImpl();
+  q->length = length;
+  q->itemSize = itemSize;
+  q->ring.resize((size_t)length * itemSize);
+  return q;
+}
+
+bool halQueueSend(HalQueue q, const void* item, uint32_t timeoutMs) {
+  auto hasRoom = [q] { return q->count < q->length; };
+  if (s_sched) {
+    if (!virtualWaitFor(q->waiters, timeoutMs, hasRoom)) return false;
+    q->push(item);
+    s_sched->notifyAll(q->waiters);
+    return true;
+  }
+  std::unique_lock<std::mutex> lock(q->m);
+  if (!waitFor(q->cv, lock, timeoutMs, hasRoom)) return false;
+  q->push(item);
+  q->cv.notify_all();
+  return true;
+}
+
+bool halQueueReceive(HalQueue q, void* item, uint32_t timeoutMs) {
+  auto hasItem = [q] { return q->count > 0; };
+  if (s_sched) {
+    if (!virtualWaitFor(q->waiters, timeoutMs, hasItem)) return false;
+    q->pop(item);
+    s_sched->notifyAll(q->waiters);
+    return true;
+  }
+  std::unique_lock<std::mutex> lock(q->m);
+  if (!waitFor(q->cv, lock, timeoutMs, hasItem)) return false;
+  q->pop(item);
+  q->cv.notify_all();
+  return true;
+}
+
+HalSemaphore halSemCreateBinary() {
+  return new HalSemImpl();
+}
+
+bool halSemGive(HalSemaphore s) {
+  if (s_sched) {
+    if (s->given) return false;
+    s->given = true;
+    s_sched->notifyAll(s->waiters);
+    return true;
+  }
+  std::lock_guard<std::mutex> lock(s->m);
+  if (s->given) return false;
+  s->given = true;
+  s->cv.notify_one();
+  return true;
+}
+
+bool halSemTake(HalSemaphore s, uint32_t timeoutMs) {
+  auto isGiven = [s] { return s->given; };
+  if (s_sched) {
+    if (!virtualWaitFor(s->waiters, timeoutMs, isGiven)) return false;
+    s->given = false;
+    return true;
+  }
+  std::unique_lock<std::mutex> lock(s->m);
+  if (!waitFor(s->cv, lock, timeoutMs, isGiven)) return false;
+  s->given = false;
+  return true;
+}
+
+// Fibers never switch inside a critical section, so one mutex serves both
+// runtimes
+static std::mutex s_criticalMutex;
+
+void halCriticalEnter() { s_criticalMutex.lock(); }
+void halCriticalExit()  { s_criticalMutex.unlock(); }
@@ -0,0 +1,36 @@
+#ifndef HAL_HOST_H
+#define HAL_HOST_H
+
+#include "Hal.h"
+
+class RigSim;
+class VirtualScheduler;
+
+// ---------------------------------------------------------------------------
+// Host-only hooks into the Linux HAL implementation
+// ---------------------------------------------------------------------------
+
+// Peripherals behind the HAL. Must be set before the sketch's setup().
+void hostSetRig(RigSim* rig);
+
+// Marks the calling thread as running on the given simulated core
+// (the Arduino loop task runs on core 1 on the ESP32).
+void hostSetCurrentCore(int core);
+
+// Runs virtual time this many times faster than the wall clock (default 1).
+// Call before setup().
+void hostSetTimeScale(double scale);
+
+// Switches to the deterministic runtime: tasks become fibers of sched and
+// time is virtual. Call before setup(), from outside any task.
+void hostUseScheduler(VirtualScheduler* sched);
+
+// Occupies the shared OLED/NFC I2C bus for this many bytes (9 clocks each)
+// in this many transactions, at clockHz (0 = the current bus clock). The
+// caller waits without holding its core, like the ESP32 I2C driver.
+void hostI2cTransfer(uint32_t bytes, uint32_t transactions, uint32_t clockHz = 0);
+
+// Seeds persistent storage as if a previous boot had saved it.
+void hostPrefsSeedFloat(const char* ns, const char* key, float value);
+
+#endif // HAL_HOST_H
@@ -0,0 +1,73 @@
+#include "HeapStats.h"
+#include <atomic>
+#include <malloc.h>
+#include <new>
+
+extern "C" void* __libc_malloc(size_t);
+extern "C" void* __libc_calloc(size_t, size_t);
+extern "C" void* __libc_realloc(void*, size_t);
+extern "C" void  __libc_free(void*);
+
+static std::atomic<uint64_t> s_allocs(0);
+static std::atomic<uint64_t> s_frees(0);
+static std::atomic<int64_t>  s_live(0);
+static std::atomic<int64_t>  s_peak(0);
+
+static void track(void* p) {
+  if (!p) return;
+  s_allocs++;
+  int64_t live = s_live += (int64_t)malloc_usable_size(p);
+  int64_t peak = s_peak.load();
+  while (live > peak && !s_peak.compare_exchange_weak(peak, live)) {}
+}
+
+static void untrack(void* p) {
+  if (!p) return;
+  s_frees++;
+  s_live -= (int64_t)malloc_usable_size(p);
+}
+
+extern "C" void* malloc(size_t n) {
+  void* p = __libc_malloc(n);
+  track(p);
+  return p;
+}
+extern "C" void* calloc(size_t n, size_t sz) {
+  void* p = __libc_calloc(n, sz);
+  track(p);
+  return p;
+}
+extern "C" void* realloc(void* p, size_t n) {
+  int64_t old = p ? (int64_t)malloc_usable_size(p) : 0;
+  void* q = __libc_realloc(p, n);
+  if (q || !n) {
+    if (p) s_frees++;
+    s_live -= old;
+    track(q);
+  }
+  return q;
+}
+extern "C" void free(void* p) {
+  untrack(p);
+  __libc_free(p);
+}
+
+void* operator new(size_t n) {
+  void* p = malloc(n ? n : 1);
+  if (!p) throw std::bad_alloc();
+  return p;
+}
+void* operator new[](size_t n) { return operator new(n); }
+void  operator delete(void* p) noexcept { free(p); }
+void  operator delete[](void* p) noexcept { free(p); }
+void  operator delete(void* p, size_t) noexcept { free(p); }
+void  operator delete[](void* p, size_t) noexcept { free(p); }
+
+HeapSnapshot heapSnapshot() {
+  HeapSnapshot s;
+  s.allocs    = s_allocs;
+  s.frees     = s_frees;
+  s.liveBytes = s_live;
+  s.peakBytes = s_peak;
+  return s;
+}
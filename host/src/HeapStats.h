@@ -0,0 +1,24 @@
+#ifndef HEAP_STATS_H
+#define HEAP_STATS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// ---------------------------------------------------------------------------
+// Process-wide heap accounting (host only)
+// ---------------------------------------------------------------------------
+// malloc/calloc/realloc/free are interposed for the whole simulator and
+// operator new/delete are routed through them, so every allocation is
+// counted: the sketch's, the simulated rig's and the runtime's. Used by
+// --heap-soak to show that a long run does not touch the heap once warm.
+
+struct HeapSnapshot {
+  uint64_t allocs;      // malloc/calloc/realloc calls so far
+  uint64_t frees;
+  int64_t  liveBytes;   // usable bytes currently allocated
+  int64_t  peakBytes;
+};
+
+HeapSnapshot heapSnapshot();
+
+#endif // HEAP_STATS_H
@@ -0,0 +1,158 @@
+#include "IoLog.h"
+#include <algorithm>
+#include <stdio.h>
+#include <string.h>
+
+static const char START_MARKER[] = "---IOREC_START---";
+
+bool IoLog::load(const char* path) {
+  FILE* f = fopen(path, "rb");
+  if (!f) {
+    error_ = "cannot open file";
+    return false;
+  }
+  std::vector<uint8_t> data;
+  uint8_t chunk[65536];
+  size_t n;
+  while ((n = fread(chunk, 1, sizeof(chunk), f)) > 0) data.insert(data.end(), chunk, chunk + n);
+  fclose(f);
+  return parseCapture(data.data(), data.size());
+}
+
+bool IoLog::parseCapture(const uint8_t* data, size_t n) {
+  // Last frame in the capture; the header follows the marker's line ending
+  const uint8_t* m   = (const uint8_t*)START_MARKER;
+  const uint8_t* end = data + n;
+  const uint8_t* it  = std::find_end(data, end, m, m + strlen(START_MARKER));
+  if (it == end) {
+    error_ = "no ---IOREC_START--- marker";
+    return false;
+  }
+  it += strlen(START_MARKER);
+  if (it < end && *it == '\r') it++;
+  if (it < end && *it == '\n') it++;
+  return parse(it, end - it);
+}
+
+static bool getVarint(const uint8_t*& p, const uint8_t* end, uint32_t& v) {
+  v = 0;
+  for (int shift = 0; shift < 35; shift += 7) {
+    if (p == end) return false;
+    uint8_t b = *p++;
+    v |= (uint32_t)(b & 0x7F) << shift;
+    if (!(b & 0x80)) return true;
+  }
+  return false;
+}
+
+static int32_t unzigzag(uint32_t v) {
+  return (int32_t)(v >> 1) ^ -(int32_t)(v & 1);
+}
+
+bool IoLog::parse(const uint8_t* data, size_t n) {
+  events_.clear();
+  readings_.clear();
+  for (auto& e : edges_) e.clear();
+
+  if (n < sizeof(IoRecordHeader)) {
+    error_ = "truncated header";
+    return false;
+  }
+  memcpy(&header_, data, sizeof(header_));
+  if (header_.magic != IO_RECORD_MAGIC || header_.version != IO_RECORD_VERSION) {
+    error_ = "bad magic or version";
+    return false;
+  }
+  if (n - sizeof(header_) < header_.bytes) {
+    error_ = "truncated records";
+    return false;
+  }
+
+  const uint8_t* p   = data + sizeof(header_);
+  const uint8_t* end = p + header_.bytes;
+  uint32_t ts  = 0;
+  long     raw = 0;
+  while (p < end) {
+    uint8_t tag = *p++;
+    uint32_t v;
+    if (!getVarint(p, end, v)) break;
+    ts += (uint32_t)unzigzag(v);
+
+    IoEvent e = {};
+    e.tUs   = ts;
+    e.type  = tag & 0x0F;
+    e.level = (tag >> 4) & 1;
+    if (e.type == IO_STEPS) {
+      if (!getVarint(p, end, e.count) || !getVarint(p, end, e.spanUs)) break;
+    } else if (e.type == IO_ADC) {
+      if (!getVarint(p, end, v)) break;
+      raw += unzigzag(v);
+      e.raw = raw;
+    } else if (e.type < IO_STEPS || e.type > IO_END) {
+      error_ = "unknown record type";
+      return false;
+    }
+    events_.push_back(e);
+  }
+  if (p != end) {
+    error_ = "truncated record";
+    return false;
+  }
+
+  std::stable_sort(events_.begin(), events_.end(),
+                   [](const IoEvent& a, const IoEvent& b) { return a.tUs < b.tUs; });
+  for (const IoEvent& e : events_) {
+    if (e.type == IO_ADC) readings_.push_back(e);
+    else if (e.type >= IO_DIR && e.type <= IO_BUTTON) edges_[e.type].push_back(e);
+  }
+  return true;
+}
+
+int IoLog::levelAt(IoEventType type, uint32_t tUs, int fallback) const {
+  const std::vector<IoEvent>& v = edges_[type];
+  auto it = std::upper_bound(v.begin(), v.end(), tUs,
+                             [](uint32_t t, const IoEvent& e) { return t < e.tUs; });
+  if (v.empty()) return fallback;
+  // Before the first read of the session, that read is the best estimate
+  return (it == v.begin()) ? v.front().level : (it - 1)->level;
+}
+
+IoSummary IoLog::summarize() const {
+  IoSummary s = {};
+  IoMotionSegment seg = {};
+  uint8_t dir = 0, enable = 0;
+  auto closeSegment = [&] {
+    if (seg.steps) s.segments.push_back(seg);
+    seg = {};
+    seg.dir = dir;
+    seg.enable = enable;
+  };
+
+  for (const IoEvent& e : events_) {
+    switch (e.type) {
+      case IO_STEPS:
+        if (!seg.steps) seg.firstStepUs = e.tUs;
+        seg.lastStepUs = e.tUs + e.spanUs;
+        seg.steps += e.count;
+        s.steps += e.count;
+        s.stepRuns++;
+        break;
+      case IO_DIR:
+        s.dirEdges++;
+        dir = e.level;
+        closeSegment();
+        break;
+      case IO_ENABLE:
+        s.enableEdges++;
+        enable = e.level;
+        closeSegment();
+        break;
+      case IO_LIMIT:  s.limitEdges++; break;
+      case IO_BUTTON: s.buttonEdges++; break;
+      case IO_ADC:    s.readings++; break;
+      default: break;
+    }
+  }
+  closeSegment();
+  return s;
+}
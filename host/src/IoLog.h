@@ -0,0 +1,72 @@
+#ifndef IO_LOG_H
+#define IO_LOG_H
+
+#include "IoRecorder.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// ---------------------------------------------------------------------------
+// Decoded I/O session recording (IoRecorder dump)
+// ---------------------------------------------------------------------------
+// Accepts a raw serial capture or a --dump-io file; the last
+// ---IOREC_START--- frame wins. Records are expanded to session-relative
+// absolute times and sorted (step runs are written when they close, so the
+// stream itself is not in time order).
+
+struct IoEvent {
+  uint32_t tUs;
+  uint8_t  type;     // IoEventType
+  uint8_t  level;    // edge records
+  uint32_t count;    // IO_STEPS: pulses in the run
+  uint32_t spanUs;   // IO_STEPS: first to last pulse
+  long     raw;      // IO_ADC
+};
+
+// Steps between two DIR/EN changes
+struct IoMotionSegment {
+  uint8_t  dir;
+  uint8_t  enable;
+  uint32_t firstStepUs;
+  uint32_t lastStepUs;
+  uint64_t steps;
+};
+
+struct IoSummary {
+  uint64_t steps;
+  uint32_t stepRuns;
+  uint32_t dirEdges;
+  uint32_t enableEdges;
+  uint32_t limitEdges;
+  uint32_t buttonEdges;
+  uint32_t readings;
+  std::vector<IoMotionSegment> segments;
+};
+
+class IoLog {
+ public:
+  bool load(const char* path);
+  bool parseCapture(const uint8_t* data, size_t n);  // serial capture or dump
+  bool parse(const uint8_t* data, size_t n);         // data starts at the header
+
+  const IoRecordHeader&       header() const { return header_; }
+  const std::vector<IoEvent>& events() const { return events_; }
+  const std::string&          error() const { return error_; }
+
+  // Input state for replay. levelAt() returns fallback only when the
+  // session never recorded that input.
+  int levelAt(IoEventType type, uint32_t tUs, int fallback) const;
+  const std::vector<IoEvent>& readings() const { return readings_; }
+
+  IoSummary summarize() const;
+
+ private:
+  IoRecordHeader       header_ = {};
+  std::vector<IoEvent> events_;
+  std::vector<IoEvent> readings_;
+  std::vector<IoEvent> edges_[IO_END];
+  std::string          error_;
+};
+
+#endif // IO_LOG_H
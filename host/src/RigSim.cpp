@@ -0,0 +1,314 @@
+#include "RigSim.h"
+#include <string.h>
+
+// NAU7802 output data rate (320 SPS)
+static const uint32_t SAMPLE_PERIOD_US = 1000000 / 320;
+
+// A carriage that hasn't stepped for this long is considered stopped
+static const uint32_t MOTION_HOLD_US = 2000;
+
+// Mechanical stop just past the limit switch
+static const long HARD_STOP_STEPS = -50;
+
+RigSim::RigSim(const RigSimOptions& opts)
+  : opts_(opts), cfg_(),
+    pos_(opts.startPosSteps), dirForward_(true), enabled_(false),
+    stepHigh_(false), lastStepUs_(0), steps_(0), dirChanges_(0),
+    limitCloses_(0), limitWasClosed_(opts.startPosSteps <= 0),
+    friction_(opts.friction, opts.seed), adcRng_(opts.seed ^ 0x9E3779B9u),
+    adcGauss_(0.0f, 1.0f), lastReadConv_(0), conversions_(0), reads_(0),
+    overruns_(0), replayAnchored_(false), replayOriginUs_(0),
+    replayNextReading_(0), replayLastRaw_(opts.zeroCounts), pressAtMs_(0), releaseAtMs_(0),
+    paddles_(0), tagNext_(0), tagInField_(-1), tagLiftAtMs_(0),
+    tagWaiting_(false), tagFirstPollMs_(0), sessionTag_(-1), tagWrites_(0) {
+  written_.reserve(256);  // tag writes of a long run land without regrowing (--heap-soak)
+  writtenPaddles_.reserve(256);
+  writtenAtMs_.reserve(256);
+  tagRecords_.reserve(256);
+  tagPresented_.reserve(256);
+}
+
+void RigSim::attach(const HalConfig& cfg) {
+  cfg_ = cfg;
+}
+
+RigSimStats RigSim::stats() {
+  RigSimStats s;
+  s.steps       = steps_;
+  s.dirChanges  = dirChanges_;
+  s.limitCloses = limitCloses_;
+  std::lock_guard<std::mutex> lock(adcMutex_);
+  s.conversions = conversions_;
+  s.reads       = reads_;
+  s.overruns    = overruns_;
+  return s;
+}
+
+// ---------------------------------------------------------------------------
+// Stepper / GPIO
+// ---------------------------------------------------------------------------
+
+void RigSim::pinWrite(uint8_t pin, uint8_t level, uint32_t nowUs) {
+  if (pin == cfg_.pinDir) {
+    bool fwd = (level == HIGH);
+    if (fwd != dirForward_) dirChanges_++;
+    dirForward_ = fwd;
+  } else if (pin == cfg_.pinEnable) {
+    enabled_ = (level == LOW);            // DRV8825 enable is active-LOW
+  } else if (pin == cfg_.pinStep) {
+    bool rising = (level == HIGH) && !stepHigh_;
+    stepHigh_ = (level == HIGH);
+    if (rising && enabled_) {
+      // Forward moves away from the limit switch
+      long p = pos_ + (dirForward_ ? 1 : -1);
+      pos_ = (p < HARD_STOP_STEPS) ? HARD_STOP_STEPS : p;
+      lastStepUs_ = nowUs;
+      steps_++;
+
+      bool closed = pos_ <= 0;
+      if (closed && !limitWasClosed_) limitCloses_++;
+      limitWasClosed_ = closed;
+    }
+  }
+}
+
+int RigSim::pinRead(uint8_t pin, uint32_t nowUs) {
+  int level = HIGH;
+  if (pin == cfg_.pinLimit) {
+    level = (pos_ <= 0) ? LOW : HIGH;     // active-LOW at home
+  } else if (pin == cfg_.pinButton) {
+    std::lock_guard<std::mutex> lock(opMutex_);
+    uint32_t nowMs = nowUs / 1000;
+    bool down = pressAtMs_ != releaseAtMs_ &&
+                nowMs >= pressAtMs_ && nowMs < releaseAtMs_;
+    level = down ? LOW : HIGH;            // active-LOW
+  } else {
+    return HIGH;
+  }
+
+  uint32_t rel;
+  if (replayTime(nowUs, rel)) {
+    level = opts_.ioReplay->levelAt(pin == cfg_.pinLimit ? IO_LIMIT : IO_BUTTON, rel, level);
+  }
+  return level;
+}
+
+// ---------------------------------------------------------------------------
+// I/O replay
+// ---------------------------------------------------------------------------
+
+// Session-relative time, once the sketch has begun its first recorded
+// session; false while the rig is still simulating inputs.
+bool RigSim::replayTime(uint32_t nowUs, uint32_t& relUs) {
+  if (!opts_.ioReplay) return false;
+  if (!replayAnchored_) {
+    if (!ioRecordActive()) return false;
+    replayAnchored_ = true;
+    replayOriginUs_ = ioRecordStartUs();
+  }
+  relUs = nowUs - replayOriginUs_;
+  return true;
+}
+
+// ---------------------------------------------------------------------------
+// NAU7802
+// ---------------------------------------------------------------------------
+
+float RigSim::forceLbAt(uint32_t convUs) {
+  uint32_t sinceStep = convUs - lastStepUs_;
+  bool moving  = enabled_ && (sinceStep < MOTION_HOLD_US || (int32_t)sinceStep < 0);
+  bool forward = dirForward_;
+  float posIn  = (float)pos_ / opts_.stepsPerInch;
+
+  float replay = 0.0f;
+  const float* replayLb = nullptr;
+  if (opts_.trace && !opts_.trace->empty()) {
+    // Map position within the measurement segment to a fraction of the pass
+    float frac = (posIn - opts_.lowerIn) / opts_.measureIn;
+    if (!forward) frac = 1.0f - frac;
+    replay = opts_.trace->force(forward, frac);
+    replayLb = &replay;
+  }
+  return friction_.evaluate(convUs / 1e6, posIn, moving, forward, replayLb);
+}
+
+bool RigSim::loadCellAvailable(uint32_t nowUs) {
+  std::lock_guard<std::mutex> lock(adcMutex_);
+  uint32_t rel;
+  if (replayTime(nowUs, rel)) {
+    const std::vector<IoEvent>& r = opts_.ioReplay->readings();
+    return replayNextReading_ < r.size() && r[replayNextReading_].tUs <= rel;
+  }
+  return (nowUs / SAMPLE_PERIOD_US) > lastReadConv_;
+}
+
+long RigSim::loadCellRead(uint32_t nowUs) {
+  std::lock_guard<std::mutex> lock(adcMutex_);
+  uint32_t rel;
+  if (replayTime(nowUs, rel)) {
+    // Latest recorded reading due by now; earlier unread ones are skipped
+    const std::vector<IoEvent>& r = opts_.ioReplay->readings();
+    while (replayNextReading_ < r.size() && r[replayNextReading_].tUs <= rel) {
+      replayLastRaw_ = r[replayNextReading_++].raw;
+    }
+    reads_++;
+    return replayLastRaw_;
+  }
+  uint64_t conv = nowUs / SAMPLE_PERIOD_US;   // latest completed conversion
+  if (conv > lastReadConv_) {
+    conversions_ += conv - lastReadConv_;
+    if (reads_ > 0) overruns_ += conv - lastReadConv_ - 1;
+    lastReadConv_ = conv;
+  }
+  reads_++;
+
+  uint32_t convUs = (uint32_t)(conv * SAMPLE_PERIOD_US);
+  float lb = forceLbAt(convUs);
+  float dT = tempCAt(convUs) - opts_.tempC;
+  float counts = opts_.zeroCounts + opts_.offsetPerC * dT +
+                 lb * opts_.countsPerLb * (1.0f + opts_.gainPerC * dT) +
+                 opts_.adcNoiseCounts * adcGauss_(adcRng_);
+  return lroundf(counts);
+}
+
+float RigSim::tempCAt(uint32_t us) const {
+  return opts_.tempC + opts_.tempDriftCPerHour * (float)(us / 3.6e9);
+}
+
+float RigSim::loadCellTempC(uint32_t nowUs) {
+  std::lock_guard<std::mutex> lock(adcMutex_);
+  uint64_t conv = nowUs / SAMPLE_PERIOD_US;   // spent on the sensor, not overruns
+  if (conv > lastReadConv_) {
+    conversions_ += conv - lastReadConv_;
+    lastReadConv_ = conv;
+  }
+  return tempCAt(nowUs);
+}
+
+// ---------------------------------------------------------------------------
+// PaddleDNA
+// ---------------------------------------------------------------------------
+
+void RigSim::paddleUuid(int paddle, uint8_t uuid[16]) {
+  static const uint8_t prefix[12] = { 'P', 'A', 'D', 'D', 'L', 'E', '-', 'S', 'I', 'M', 0, 0 };
+  memcpy(uuid, prefix, sizeof(prefix));
+  uuid[12] = (uint8_t)(paddle >> 24);
+  uuid[13] = (uint8_t)(paddle >> 16);
+  uuid[14] = (uint8_t)(paddle >> 8);
+  uuid[15] = (uint8_t)paddle;
+}
+
+// The tag in the field at nowMs, or -1. opMutex_ held.
+int RigSim::tagInFieldLocked(uint32_t nowMs, bool looking) {
+  if (tagInField_ >= 0 && tagLiftAtMs_ && (int32_t)(nowMs - tagLiftAtMs_) >= 0) {
+    tagInField_ = -1;   // the operator took the written tag away
+    tagLiftAtMs_ = 0;
+  }
+  if (tagInField_ < 0 && looking && tagNext_ < paddles_) {
+    if (!tagWaiting_) {
+      tagWaiting_ = true;
+      tagFirstPollMs_ = nowMs;
+    }
+    if (nowMs - tagFirstPollMs_ >= opts_.tagDelayMs) {
+      int step = opts_.tagsReversed ? -1 : 1;
+      int tag = opts_.tagsReversed ? paddles_ - 1 : 0;
+      while (tagPresented_[tag]) tag += step;
+      tagPresented_[tag] = 1;
+      tagWaiting_ = false;
+      tagInField_ = tag;
+      tagNext_++;
+    }
+  }
+  return tagInField_;
+}
+
+// Appends what still fits on the paddle's tag, in one write
+HalNfcResult RigSim::recordWriteLocked(const float* cofs, uint8_t count, int paddle,
+                                       uint32_t nowMs, uint8_t* written) {
+  uint8_t& onTag = tagRecords_[paddle];
+  uint8_t fit = 0;
+  while (fit < count && onTag < opts_.tagCapacity) {
+    written_.push_back(cofs[fit]);
+    writtenPaddles_.push_back(paddle);
+    writtenAtMs_.push_back(nowMs);
+    onTag++;
+    fit++;
+  }
+  *written = fit;
+  tagWrites_ += fit ? 1 : 0;
+  if (!tagLiftAtMs_) tagLiftAtMs_ = nowMs + opts_.tagLiftMs;
+  return (fit < count) ? HAL_NFC_TAG_FULL : HAL_NFC_SUCCESS;
+}
+
+bool RigSim::nfcDetect(uint8_t uuid[16], uint32_t nowMs) {
+  std::lock_guard<std::mutex> lock(opMutex_);
+  int tag = tagInFieldLocked(nowMs, true);
+  if (tag < 0) return false;
+  paddleUuid(tag, uuid);
+  return true;
+}
+
+bool RigSim::nfcFieldSense(uint32_t nowMs) {
+  std::lock_guard<std::mutex> lock(opMutex_);
+  return tagInFieldLocked(nowMs, true) >= 0;
+}
+
+HalNfcResult RigSim::nfcAccumulate(const uint8_t* expected, const float* cofs, uint8_t count,
+                                   uint32_t nowMs, uint8_t* written) {
+  std::lock_guard<std::mutex> lock(opMutex_);
+  int tag = tagInFieldLocked(nowMs, true);
+  if (tag < 0) return HAL_NFC_NO_TAG;
+  if (expected) {
+    uint8_t uuid[16];
+    paddleUuid(tag, uuid);
+    if (memcmp(uuid, expected, 16) != 0) return HAL_NFC_WRONG_TAG;
+  }
+  return recordWriteLocked(cofs, count, tag, nowMs, written);
+}
+
+bool RigSim::nfcSessionOpen(uint8_t uuid[16], uint32_t nowMs) {
+  std::lock_guard<std::mutex> lock(opMutex_);
+  sessionTag_ = tagInFieldLocked(nowMs, true);
+  if (sessionTag_ < 0) return false;
+  paddleUuid(sessionTag_, uuid);
+  return true;
+}
+
+HalNfcResult RigSim::nfcSessionCommit(const float* cofs, uint8_t count, uint32_t nowMs,
+                                      uint8_t* written) {
+  std::lock_guard<std::mutex> lock(opMutex_);
+  int session = sessionTag_;
+  sessionTag_ = -1;
+  if (session < 0) return HAL_NFC_READ_ERROR;
+  // The cached records belong to the session's tag: no writing elsewhere
+  if (tagInFieldLocked(nowMs, false) != session) return HAL_NFC_WRITE_ERROR;
+  return recordWriteLocked(cofs, count, session, nowMs, written);
+}
+
+void RigSim::nfcSessionClose() {
+  std::lock_guard<std::mutex> lock(opMutex_);
+  sessionTag_ = -1;
+}
+
+// ---------------------------------------------------------------------------
+// Operator script
+// ---------------------------------------------------------------------------
+
+void RigSim::pressButton(uint32_t atMs, uint32_t holdMs) {
+  std::lock_guard<std::mutex> lock(opMutex_);
+  pressAtMs_   = atMs;
+  releaseAtMs_ = atMs + holdMs;
+}
+
+int RigSim::paddleTagReady() {
+  std::lock_guard<std::mutex> lock(opMutex_);
+  tagRecords_.push_back(0);
+  tagPresented_.push_back(0);
+  return paddles_++;
+}
+
+void RigSim::setFriction(const FrictionParams& p, uint32_t seed) {
+  std::lock_guard<std::mutex> lock(adcMutex_);
+  opts_.friction = p;
+  friction_ = FrictionModel(p, seed);
+}
@@ -0,0 +1,176 @@
+#ifndef RIG_SIM_H
+#define RIG_SIM_H
+
+#include "Hal.h"
+#include "FrictionModel.h"
+#include "TraceReplay.h"
+#include "IoLog.h"
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+// ---------------------------------------------------------------------------
+// Simulated test rig
+// ---------------------------------------------------------------------------
+// Stands in for the peripherals behind Hal.h on the host:
+//   - stepper: carriage position integrated from STEP rising edges (DIR,
+//     active-LOW EN), hard stop just past the limit switch
+//   - limit switch: closed while the carriage is at or above home
+//   - NAU7802: conversions every 1/320 s; the data-ready flag is set when a
+//     conversion completes and cleared by a read; unread conversions are
+//     overwritten (counted as overruns). Its temperature starts at tempC
+//     and drifts linearly; offset and gain follow it by offsetPerC and
+//     gainPerC. A temperature read drops the conversions it spans
+//   - load: FrictionModel, or a recorded trace replayed by position
+//   - operator: scripted button presses and NFC tag presentation. Once
+//     the operator has a paddle's tag at hand (after its test, or before it
+//     in the tag-first workflow), it is presented, in order (or newest
+//     first with tagsReversed), tagDelayMs after the reader first looks
+//     for it, and lifted tagLiftMs after it is written
+//   - I/O replay: once the sketch starts recording a session, the limit
+//     switch, button and load-cell readings come from a recorded session
+//     (IoLog) at the same session-relative times instead
+//
+// Position is in microsteps away from the limit switch (home = 0).
+
+struct RigSimOptions {
+  // Geometry, mirrors USER CONFIG in the sketch
+  float    stepsPerInch   = 200.0f * 16.0f * 19.0f / 6.0f;
+  float    lowerIn        = 2.5f;
+  float    measureIn      = 3.0f;
+
+  long     startPosSteps  = 4000;    // carriage position at power-up
+  float    countsPerLb    = 1000.0f; // load cell scale (raw counts per lb)
+  long     zeroCounts     = 8000;    // raw reading with no load
+  float    adcNoiseCounts = 2.0f;    // 1σ converter noise
+  float    tempC          = 25.0f;   // load cell and converter at power-up
+  float    tempDriftCPerHour = 0.0f;
+  float    offsetPerC     = 0.0f;    // zero drift, raw counts per °C
+  float    gainPerC       = 0.0f;    // gain drift, fraction per °C
+  uint32_t seed           = 1;
+  uint32_t tagDelayMs     = 2000;    // operator presents tag this long after first poll
+  uint32_t tagLiftMs      = 400;     // written tag stays on the reader this long
+  bool     tagsReversed   = false;   // present the last tag at hand first
+  bool     nfcIrq         = true;    // reader IRQ line wired (card detect)
+  uint8_t  tagCapacity    = 9;       // measurements a tag holds (the sketch's accumulator)
+  uint32_t oledMaxI2cHz   = 1000000; // fastest clock each shared-bus device keeps up with
+  uint32_t nfcMaxI2cHz    = 400000;
+
+  FrictionParams     friction;
+  const TraceReplay* trace = nullptr; // replaces the friction model's kinetic force
+  const IoLog*       ioReplay = nullptr; // recorded session inputs (see above)
+};
+
+struct RigSimStats {
+  uint64_t steps;
+  uint32_t dirChanges;
+  uint32_t limitCloses;
+  uint64_t conversions;
+  uint64_t reads;
+  uint64_t overruns;          // conversions overwritten before being read
+};
+
+class RigSim {
+ public:
+  explicit RigSim(const RigSimOptions& opts);
+
+  void attach(const HalConfig& cfg);
+
+  // GPIO
+  void pinWrite(uint8_t pin, uint8_t level, uint32_t nowUs);
+  int  pinRead(uint8_t pin, uint32_t nowUs);
+
+  // NAU7802
+  bool loadCellAvailable(uint32_t nowUs);
+  long loadCellRead(uint32_t nowUs);
+  float loadCellTempC(uint32_t nowUs);
+
+  // Shared I2C bus: both the OLED and the NFC reader respond at this clock
+  bool i2cClockOk(uint32_t hz) const { return hz <= opts_.oledMaxI2cHz && hz <= opts_.nfcMaxI2cHz; }
+
+  // PaddleDNA
+  bool         nfcDetect(uint8_t paddleUuid[16], uint32_t nowMs);
+  bool         nfcFieldSense(uint32_t nowMs);   // card detect: no bus traffic
+  // expected: refuse (HAL_NFC_WRONG_TAG) any other paddle's tag; NULL: any
+  HalNfcResult nfcAccumulate(const uint8_t* expected, const float* cofs, uint8_t count,
+                             uint32_t nowMs, uint8_t* written);
+  bool         nfcSessionOpen(uint8_t paddleUuid[16], uint32_t nowMs);
+  HalNfcResult nfcSessionCommit(const float* cofs, uint8_t count, uint32_t nowMs,
+                                uint8_t* written);
+  void         nfcSessionClose();
+
+  // Operator script
+  void pressButton(uint32_t atMs, uint32_t holdMs);
+  int  paddleTagReady();   // next paddle's tag is at hand; returns its index
+  static void paddleUuid(int paddle, uint8_t uuid[16]);
+
+  // Swaps the load model between test cycles (Monte Carlo runs)
+  void setFriction(const FrictionParams& p, uint32_t seed);
+
+  long positionSteps() const { return pos_.load(); }
+  RigSimStats stats();
+  const std::vector<float>& writtenCofs() const { return written_; }
+  const std::vector<int>&   writtenPaddles() const { return writtenPaddles_; }
+  const std::vector<uint32_t>& writtenAtMs() const { return writtenAtMs_; }
+  uint32_t tagWrites() const { return tagWrites_; }
+  const RigSimOptions& options() const { return opts_; }
+  const HalConfig&     config() const { return cfg_; }
+
+ private:
+  float forceLbAt(uint32_t convUs);
+  float tempCAt(uint32_t us) const;
+  int   tagInFieldLocked(uint32_t nowMs, bool looking);
+  HalNfcResult recordWriteLocked(const float* cofs, uint8_t count, int paddle,
+                                 uint32_t nowMs, uint8_t* written);
+  bool  replayTime(uint32_t nowUs, uint32_t& relUs);
+
+  RigSimOptions opts_;
+  HalConfig     cfg_;
+
+  // Stepper (written from the motion task)
+  std::atomic<long>     pos_;
+  std::atomic<bool>     dirForward_;
+  std::atomic<bool>     enabled_;
+  std::atomic<bool>     stepHigh_;
+  std::atomic<uint32_t> lastStepUs_;
+  std::atomic<uint64_t> steps_;
+  std::atomic<uint32_t> dirChanges_;
+  std::atomic<uint32_t> limitCloses_;
+  bool                  limitWasClosed_;
+
+  // Load cell (read from the sampling task and the main loop)
+  std::mutex            adcMutex_;
+  FrictionModel         friction_;
+  std::mt19937          adcRng_;
+  std::normal_distribution<float> adcGauss_;
+  uint64_t              lastReadConv_;
+  uint64_t              conversions_;
+  uint64_t              reads_;
+  uint64_t              overruns_;
+
+  // I/O replay, anchored at the first recorded session's start
+  bool                  replayAnchored_;
+  uint32_t              replayOriginUs_;
+  size_t                replayNextReading_;
+  long                  replayLastRaw_;
+
+  // Operator
+  std::mutex            opMutex_;
+  uint32_t              pressAtMs_;
+  uint32_t              releaseAtMs_;
+  int                   paddles_;         // tags at hand so far
+  int                   tagNext_;         // tags presented so far
+  int                   tagInField_;      // -1: none
+  uint32_t              tagLiftAtMs_;     // 0: not written yet
+  bool                  tagWaiting_;
+  uint32_t              tagFirstPollMs_;
+  std::vector<float>    written_;
+  int                   sessionTag_;      // -1: no session open
+  std::vector<int>      writtenPaddles_;
+  std::vector<uint32_t> writtenAtMs_;
+  std::vector<uint8_t>  tagRecords_;      // measurements on each paddle's tag
+  std::vector<uint8_t>  tagPresented_;    // each paddle's tag has been presented
+  uint32_t              tagWrites_;       // tag payload writes
+};
+
+#endif // RIG_SIM_H
@@ -0,0 +1,234 @@
+#include "SimDisplay.h"
+#include "HalHost.h"
+#include <stdlib.h>
+
+// ---------------------------------------------------------------------------
+// Classic 5x7 GLCD font (printable ASCII 0x20-0x7E), column-major, LSB = top
+// ---------------------------------------------------------------------------
+static const uint8_t FONT_5X7[] = {
+  0x00, 0x00, 0x00, 0x00, 0x00, // ' '
+  0x00, 0x00, 0x5F, 0x00, 0x00, // !
+  0x00, 0x07, 0x00, 0x07, 0x00, // "
+  0x14, 0x7F, 0x14, 0x7F, 0x14, // #
+  0x24, 0x2A, 0x7F, 0x2A, 0x12, // $
+  0x23, 0x13, 0x08, 0x64, 0x62, // %
+  0x36, 0x49, 0x56, 0x20, 0x50, // &
+  0x00, 0x08, 0x07, 0x03, 0x00, // '
+  0x00, 0x1C, 0x22, 0x41, 0x00, // (
+  0x00, 0x41, 0x22, 0x1C, 0x00, // )
+  0x2A, 0x1C, 0x7F, 0x1C, 0x2A, // *
+  0x08, 0x08, 0x3E, 0x08, 0x08, // +
+  0x00, 0x80, 0x70, 0x30, 0x00, // ,
+  0x08, 0x08, 0x08, 0x08, 0x08, // -
+  0x00, 0x00, 0x60, 0x60, 0x00, // .
+  0x20, 0x10, 0x08, 0x04, 0x02, // /
+  0x3E, 0x51, 0x49, 0x45, 0x3E, // 0
+  0x00, 0x42, 0x7F, 0x40, 0x00, // 1
+  0x72, 0x49, 0x49, 0x49, 0x46, // 2
+  0x21, 0x41, 0x49, 0x4D, 0x33, // 3
+  0x18, 0x14, 0x12, 0x7F, 0x10, // 4
+  0x27, 0x45, 0x45, 0x45, 0x39, // 5
+  0x3C, 0x4A, 0x49, 0x49, 0x31, // 6
+  0x41, 0x21, 0x11, 0x09, 0x07, // 7
+  0x36, 0x49, 0x49, 0x49, 0x36, // 8
+  0x46, 0x49, 0x49, 0x29, 0x1E, // 9
+  0x00, 0x00, 0x14, 0x00, 0x00, // :
+  0x00, 0x40, 0x34, 0x00, 0x00, // ;
+  0x00, 0x08, 0x14, 0x22, 0x41, // <
+  0x14, 0x14, 0x14, 0x14, 0x14, // =
+  0x00, 0x41, 0x22, 0x14, 0x08, // >
+  0x02, 0x01, 0x59, 0x09, 0x06, // ?
+  0x3E, 0x41, 0x5D, 0x59, 0x4E, // @
+  0x7C, 0x12, 0x11, 0x12, 0x7C, // A
+  0x7F, 0x49, 0x49, 0x49, 0x36, // B
+  0x3E, 0x41, 0x41, 0x41, 0x22, // C
+  0x7F, 0x41, 0x41, 0x41, 0x3E, // D
+  0x7F, 0x49, 0x49, 0x49, 0x41, // E
+  0x7F, 0x09, 0x09, 0x09, 0x01, // F
+  0x3E, 0x41, 0x41, 0x51, 0x73, // G
+  0x7F, 0x08, 0x08, 0x08, 0x7F, // H
+  0x00, 0x41, 0x7F, 0x41, 0x00, // I
+  0x20, 0x40, 0x41, 0x3F, 0x01, // J
+  0x7F, 0x08, 0x14, 0x22, 0x41, // K
+  0x7F, 0x40, 0x40, 0x40, 0x40, // L
+  0x7F, 0x02, 0x1C, 0x02, 0x7F, // M
+  0x7F, 0x04, 0x08, 0x10, 0x7F, // N
+  0x3E, 0x41, 0x41, 0x41, 0x3E, // O
+  0x7F, 0x09, 0x09, 0x09, 0x06, // P
+  0x3E, 0x41, 0x51, 0x21, 0x5E, // Q
+  0x7F, 0x09, 0x19, 0x29, 0x46, // R
+  0x26, 0x49, 0x49, 0x49, 0x32, // S
+  0x03, 0x01, 0x7F, 0x01, 0x03, // T
+  0x3F, 0x40, 0x40, 0x40, 0x3F, // U
+  0x1F, 0x20, 0x40, 0x20, 0x1F, // V
+  0x3F, 0x40, 0x38, 0x40, 0x3F, // W
+  0x63, 0x14, 0x08, 0x14, 0x63, // X
+  0x03, 0x04, 0x78, 0x04, 0x03, // Y
+  0x61, 0x59, 0x49, 0x4D, 0x43, // Z
+  0x00, 0x7F, 0x41, 0x41, 0x41, // [
+  0x02, 0x04, 0x08, 0x10, 0x20, // backslash
+  0x00, 0x41, 0x41, 0x41, 0x7F, // ]
+  0x04, 0x02, 0x01, 0x02, 0x04, // ^
+  0x40, 0x40, 0x40, 0x40, 0x40, // _
+  0x00, 0x03, 0x07, 0x08, 0x00, // `
+  0x20, 0x54, 0x54, 0x78, 0x40, // a
+  0x7F, 0x28, 0x44, 0x44, 0x38, // b
+  0x38, 0x44, 0x44, 0x44, 0x28, // c
+  0x38, 0x44, 0x44, 0x28, 0x7F, // d
+  0x38, 0x54, 0x54, 0x54, 0x18, // e
+  0x00, 0x08, 0x7E, 0x09, 0x02, // f
+  0x18, 0xA4, 0xA4, 0x9C, 0x78, // g
+  0x7F, 0x08, 0x04, 0x04, 0x78, // h
+  0x00, 0x44, 0x7D, 0x40, 0x00, // i
+  0x20, 0x40, 0x40, 0x3D, 0x00, // j
+  0x7F, 0x10, 0x28, 0x44, 0x00, // k
+  0x00, 0x41, 0x7F, 0x40, 0x00, // l
+  0x7C, 0x04, 0x78, 0x04, 0x78, // m
+  0x7C, 0x08, 0x04, 0x04, 0x78, // n
+  0x38, 0x44, 0x44, 0x44, 0x38, // o
+  0xFC, 0x18, 0x24, 0x24, 0x18, // p
+  0x18, 0x24, 0x24, 0x18, 0xFC, // q
+  0x7C, 0x08, 0x04, 0x04, 0x08, // r
+  0x48, 0x54, 0x54, 0x54, 0x24, // s
+  0x04, 0x04, 0x3F, 0x44, 0x24, // t
+  0x3C, 0x40, 0x40, 0x20, 0x7C, // u
+  0x1C, 0x20, 0x40, 0x20, 0x1C, // v
+  0x3C, 0x40, 0x30, 0x40, 0x3C, // w
+  0x44, 0x28, 0x10, 0x28, 0x44, // x
+  0x4C, 0x90, 0x90, 0x90, 0x7C, // y
+  0x44, 0x64, 0x54, 0x4C, 0x44, // z
+  0x00, 0x08, 0x36, 0x41, 0x00, // {
+  0x00, 0x00, 0x77, 0x00, 0x00, // |
+  0x00, 0x41, 0x36, 0x08, 0x00, // }
+  0x02, 0x01, 0x02, 0x04, 0x02, // ~
+};
+
+static const unsigned char FONT_FIRST = 0x20;
+static const unsigned char FONT_LAST  = 0x7E;
+
+// ---------------------------------------------------------------------------
+// SimDisplay
+// ---------------------------------------------------------------------------
+
+SimDisplay::SimDisplay()
+  : cursorX_(0), cursorY_(0), textSize_(1),
+    textColor_(SSD1306_WHITE), textBg_(SSD1306_WHITE),
+    wrap_(true), flushCount_(0) {
+  memset(buffer_, 0, sizeof(buffer_));
+  memset(gddram_, 0, sizeof(gddram_));
+}
+
+bool SimDisplay::begin(uint8_t, uint8_t) {
+  clearDisplay();
+  return true;
+}
+
+// Bus traffic of Adafruit_SSD1306::display(): two command transactions, then
+// 1024 data bytes in 127-byte chunks, at the 400 kHz the library switches
+// Wire to for its own transfers
+static const uint32_t FULL_FRAME_BUS_BYTES = 10 + 1024 + 2 * 9;
+static const uint32_t FULL_FRAME_TXNS      = 2 + 9;
+static const uint32_t ADAFRUIT_CLOCK_HZ    = 400000;
+
+void SimDisplay::display() {
+  flushCount_++;
+  memcpy(gddram_, buffer_, sizeof(gddram_));
+  hostI2cTransfer(FULL_FRAME_BUS_BYTES, FULL_FRAME_TXNS, ADAFRUIT_CLOCK_HZ);
+}
+
+void SimDisplay::writeGddram(uint8_t page, uint8_t col0, uint8_t col1, const uint8_t* data) {
+  if (page >= HEIGHT / 8 || col0 > col1 || col1 >= WIDTH) return;
+  memcpy(gddram_ + page * WIDTH + col0, data, col1 - col0 + 1);
+}
+
+void SimDisplay::clearDisplay() {
+  memset(buffer_, 0, sizeof(buffer_));
+}
+
+void SimDisplay::drawPixel(int16_t x, int16_t y, uint16_t color) {
+  if (x < 0 || y < 0 || x >= WIDTH || y >= HEIGHT) return;
+  uint8_t* b = &buffer_[x + (y / 8) * WIDTH];
+  uint8_t bit = (uint8_t)(1 << (y & 7));
+  if (color == SSD1306_INVERSE) *b ^= bit;
+  else if (color)               *b |= bit;
+  else                          *b &= (uint8_t)~bit;
+}
+
+void SimDisplay::drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1,
+                          uint16_t color) {
+  // Bresenham
+  int dx =  abs(x1 - x0), sx = (x0 < x1) ? 1 : -1;
+  int dy = -abs(y1 - y0), sy = (y0 < y1) ? 1 : -1;
+  int err = dx + dy;
+  while (true) {
+    drawPixel(x0, y0, color);
+    if (x0 == x1 && y0 == y1) break;
+    int e2 = 2 * err;
+    if (e2 >= dy) { err += dy; x0 += sx; }
+    if (e2 <= dx) { err += dx; y0 += sy; }
+  }
+}
+
+void SimDisplay::drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) {
+  for (int16_t i = 0; i < w; i++) drawPixel(x + i, y, color);
+}
+
+void SimDisplay::drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) {
+  for (int16_t i = 0; i < h; i++) drawPixel(x, y + i, color);
+}
+
+void SimDisplay::fillRect(int16_t x, int16_t y, int16_t w, int16_t h,
+                          uint16_t color) {
+  for (int16_t i = 0; i < h; i++) drawFastHLine(x, y + i, w, color);
+}
+
+void SimDisplay::drawChar(int16_t x, int16_t y, unsigned char c,
+                          uint16_t color, uint16_t bg, uint8_t size) {
+  if (x >= WIDTH || y >= HEIGHT || (x + 6 * size - 1) < 0 ||
+      (y + 8 * size - 1) < 0) return;
+
+  const uint8_t* glyph = nullptr;
+  if (c >= FONT_FIRST && c <= FONT_LAST) glyph = &FONT_5X7[(c - FONT_FIRST) * 5];
+
+  for (int8_t i = 0; i < 5; i++) {
+    uint8_t line = glyph ? glyph[i] : 0;
+    for (int8_t j = 0; j < 8; j++, line >>= 1) {
+      if (line & 1) {
+        if (size == 1) drawPixel(x + i, y + j, color);
+        else           fillRect(x + i * size, y + j * size, size, size, color);
+      } else if (bg != color) {
+        if (size == 1) drawPixel(x + i, y + j, bg);
+        else           fillRect(x + i * size, y + j * size, size, size, bg);
+      }
+    }
+  }
+  if (bg != color) {
+    if (size == 1) drawFastVLine(x + 5, y, 8, bg);
+    else           fillRect(x + 5 * size, y, size, 8 * size, bg);
+  }
+}
+
+size_t SimDisplay::write(uint8_t c) {
+  if (c == '\n') {
+    cursorX_ = 0;
+    cursorY_ += textSize_ * 8;
+  } else if (c != '\r') {
+    if (wrap_ && (cursorX_ + textSize_ * 6) > WIDTH) {
+      cursorX_ = 0;
+      cursorY_ += textSize_ * 8;
+    }
+    drawChar(cursorX_, cursorY_, c, textColor_, textBg_, textSize_);
+    cursorX_ += textSize_ * 6;
+  }
+  return 1;
+}
+
+void SimDisplay::dumpAscii(FILE* out) const {
+  for (int16_t y = 0; y < HEIGHT; y++) {
+    for (int16_t x = 0; x < WIDTH; x++) {
+      bool on = gddram_[x + (y / 8) * WIDTH] & (1 << (y & 7));
+      fputc(on ? '#' : '.', out);
+    }
+    fputc('\n', out);
+  }
+}
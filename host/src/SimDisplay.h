@@ -0,0 +1,74 @@
+#ifndef SIM_DISPLAY_H
+#define SIM_DISPLAY_H
+
+#include <Arduino.h>
+#include <stdio.h>
+
+#define SSD1306_BLACK        0
+#define SSD1306_WHITE        1
+#define SSD1306_INVERSE      2
+#define SSD1306_SWITCHCAPVCC 0x02
+
+// ---------------------------------------------------------------------------
+// Simulated SSD1306
+// ---------------------------------------------------------------------------
+// Implements the Adafruit_GFX/Adafruit_SSD1306 subset the sketch uses on a
+// 1 KB page-major framebuffer (same layout as the panel's GDDRAM), with the
+// classic 5x7 GLCD font so text lands on the same pixels as on the device.
+// A second buffer mirrors the panel's GDDRAM: display() copies the whole
+// framebuffer into it (and occupies the I2C bus as long as the real
+// full-frame push), writeGddram() updates a page segment
+// (halDisplayWriteRect). dumpAscii() shows the panel, i.e. what the
+// operator sees.
+class SimDisplay : public Print {
+ public:
+  static const int16_t WIDTH  = 128;
+  static const int16_t HEIGHT = 64;
+
+  SimDisplay();
+
+  bool begin(uint8_t vccState = SSD1306_SWITCHCAPVCC, uint8_t addr = 0x3C);
+  void display();
+  void clearDisplay();
+
+  void drawPixel(int16_t x, int16_t y, uint16_t color);
+  void drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color);
+  void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color);
+  void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color);
+  void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+
+  void setTextSize(uint8_t s)                 { textSize_ = s ? s : 1; }
+  void setTextColor(uint16_t c)               { textColor_ = c; textBg_ = c; }
+  void setTextColor(uint16_t c, uint16_t bg)  { textColor_ = c; textBg_ = bg; }
+  void setCursor(int16_t x, int16_t y)        { cursorX_ = x; cursorY_ = y; }
+  void setTextWrap(bool w)                    { wrap_ = w; }
+
+  int16_t  width() const  { return WIDTH; }
+  int16_t  height() const { return HEIGHT; }
+  uint8_t* getBuffer()    { return buffer_; }
+
+  size_t write(uint8_t c) override;
+  using Print::write;
+
+  // Panel side
+  void writeGddram(uint8_t page, uint8_t col0, uint8_t col1, const uint8_t* data);
+
+  // Host-only diagnostics
+  uint32_t flushCount() const { return flushCount_; }
+  void     dumpAscii(FILE* out) const;
+  const uint8_t* gddram() const { return gddram_; }
+
+ private:
+  void drawChar(int16_t x, int16_t y, unsigned char c, uint16_t color,
+                uint16_t bg, uint8_t size);
+
+  uint8_t  buffer_[WIDTH * HEIGHT / 8];
+  uint8_t  gddram_[WIDTH * HEIGHT / 8];
+  int16_t  cursorX_, cursorY_;
+  uint8_t  textSize_;
+  uint16_t textColor_, textBg_;
+  bool     wrap_;
+  uint32_t flushCount_;
+};
+
+#endif // SIM_DISPLAY_H
@@ -0,0 +1,3 @@
+// Compiles the Arduino sketch unchanged as a host translation unit.
+// The .ino already carries its own prototypes, so no preprocessing is needed.
+#include "Friction-Tester.ino"
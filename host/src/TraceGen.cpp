@@ -0,0 +1,141 @@
+#include "TraceGen.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <random>
+
+uint64_t traceGenSeed(uint64_t baseSeed, uint64_t runIndex) {
+  uint64_t z = baseSeed + 0x9E3779B97F4A7C15ULL * (runIndex + 1);
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+  return z ^ (z >> 31);
+}
+
+// ---------------------------------------------------------------------------
+// Colored noise, unit variance for unit-variance white input
+// ---------------------------------------------------------------------------
+class ColoredNoise {
+ public:
+  explicit ColoredNoise(NoiseColor c) : color_(c), b0_(0), b1_(0), b2_(0) {}
+
+  float next(float white) {
+    switch (color_) {
+      case NOISE_PINK:
+        // Paul Kellet's economy 1/f filter; gain ≈ 3.6 for white input
+        b0_ = 0.99765f * b0_ + white * 0.0990460f;
+        b1_ = 0.96300f * b1_ + white * 0.2965164f;
+        b2_ = 0.57000f * b2_ + white * 1.0526913f;
+        return (b0_ + b1_ + b2_ + white * 0.1848f) / 3.6f;
+      case NOISE_BROWN:
+        // Leaky integrator, stationary σ = 0.1 / sqrt(1 - 0.995²) ≈ 1
+        b0_ = 0.995f * b0_ + white * 0.1f;
+        return b0_;
+      default:
+        return white;
+    }
+  }
+
+ private:
+  NoiseColor color_;
+  float b0_, b1_, b2_;
+};
+
+// ---------------------------------------------------------------------------
+// Run synthesis
+// ---------------------------------------------------------------------------
+
+// One measurement pass: conversions every 1/sampleHz (with jitter) while the
+// carriage moves at constant speed across the measurement segment.
+static void generatePass(const TraceGenOptions& o, FrictionModel& model,
+                         ColoredNoise& colored, std::mt19937& rng,
+                         double t0, bool forward, std::vector<float>& out) {
+  std::normal_distribution<float>       gauss(0.0f, 1.0f);
+  std::uniform_real_distribution<float> u01(0.0f, 1.0f);
+
+  double period = 1.0 / o.sampleHz;
+  long   conversions = (long)(o.passSec * o.sampleHz);
+  out.clear();
+  out.reserve(conversions);
+
+  for (long i = 0; i < conversions && (long)out.size() < o.maxSamples; i++) {
+    double jitter = (o.jitterFrac > 0.0f) ? (u01(rng) - 0.5f) * o.jitterFrac * period : 0.0;
+    double t = i * period + jitter;
+    if (t < 0.0) t = 0.0;
+    float frac  = (float)(t / o.passSec);
+    float posIn = o.lowerIn + (forward ? frac : 1.0f - frac) * o.measureIn;
+
+    // Always advance the model so drops don't change the underlying signal
+    float lb = model.evaluate(t0 + t, posIn, true, forward);
+    float c  = colored.next(gauss(rng));
+    bool dropped = (o.dropProb > 0.0f) && u01(rng) < o.dropProb;
+    bool outlier = (o.outlierProb > 0.0f) && u01(rng) < o.outlierProb;
+    float spike  = outlier ? (2.0f * u01(rng) - 1.0f) * o.outlierLb : 0.0f;
+    if (dropped) continue;
+
+    out.push_back(lb + o.colorLb * c + spike);
+  }
+}
+
+void generateRun(const TraceGenOptions& opts, uint64_t seed, GeneratedRun& out) {
+  std::mt19937 rng;
+  seedRng(rng, seed);
+  std::uniform_real_distribution<float> cofDist(opts.cofLo, opts.cofHi);
+
+  FrictionParams fp = opts.friction;
+  fp.cof = (opts.cofHi > opts.cofLo) ? cofDist(rng) : opts.cofLo;
+
+  FrictionModel model(fp, seed ^ 0xA5A5A5A5u);
+  ColoredNoise  colored(opts.color);
+
+  out.seed    = seed;
+  out.trueCof = fp.cof;
+  generatePass(opts, model, colored, rng, 0.0, true, out.fwd);
+  generatePass(opts, model, colored, rng, opts.passSec + opts.pauseSec, false, out.rev);
+}
+
+// ---------------------------------------------------------------------------
+// CSV output
+// ---------------------------------------------------------------------------
+
+// Formatting without the printf machinery (it dominates output time otherwise)
+static char* putUint(char* p, unsigned long v) {
+  char tmp[20];
+  int n = 0;
+  do { tmp[n++] = (char)('0' + v % 10); v /= 10; } while (v);
+  while (n) *p++ = tmp[--n];
+  return p;
+}
+
+// "<tag><index>,<value %.4f>\n"
+static void appendPass(std::string& s, const char* tag, const std::vector<float>& v) {
+  char line[48];
+  size_t tagLen = strlen(tag);
+  for (size_t i = 0; i < v.size(); i++) {
+    char* p = line;
+    memcpy(p, tag, tagLen);
+    p += tagLen;
+    p = putUint(p, i);
+    *p++ = ',';
+
+    float x = v[i];
+    if (x < 0.0f) { *p++ = '-'; x = -x; }
+    unsigned long scaled = (unsigned long)lroundf(x * 10000.0f);
+    p = putUint(p, scaled / 10000);
+    *p++ = '.';
+    unsigned long frac = scaled % 10000;
+    for (unsigned long d = 1000; d > 0; d /= 10) { *p++ = (char)('0' + frac / d); frac %= d; }
+    *p++ = '\n';
+    s.append(line, p - line);
+  }
+}
+
+void appendRunCsv(const GeneratedRun& run, uint64_t runIndex, std::string& out) {
+  char head[96];
+  snprintf(head, sizeof(head), "# run=%llu seed=%llu true_cof=%.6f\n",
+           (unsigned long long)runIndex, (unsigned long long)run.seed, run.trueCof);
+  out.append(head);
+  out.append("---CSV_START---\npass,index,force_lb\n");
+  appendPass(out, "FWD,", run.fwd);
+  appendPass(out, "REV,", run.rev);
+  out.append("---CSV_END---\n");
+}
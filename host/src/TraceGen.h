@@ -0,0 +1,66 @@
+#ifndef TRACE_GEN_H
+#define TRACE_GEN_H
+
+#include "FrictionModel.h"
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// ---------------------------------------------------------------------------
+// Synthetic force-trace generator
+// ---------------------------------------------------------------------------
+// Produces the forward/reverse sample buffers a test run would leave in
+// g_fwdSamples / g_revSamples, with a known true COF. The load comes from
+// FrictionModel (kinetic, surface, stick-slip, settle lag, offset, drift,
+// white noise) plus effects the rig model does not have:
+//
+//   colored noise   pink (1/f) or brown (1/f²) component on top of the
+//                   model's white noise
+//   outliers        isolated spikes (EMI, loose connector)
+//   dropped samples conversions the sampling task missed
+//   jitter          uneven sample spacing around the 320 SPS period
+//
+// Every run is a pure function of (options, seed): the same seed gives the
+// same trace on any thread.
+
+enum NoiseColor { NOISE_WHITE, NOISE_PINK, NOISE_BROWN };
+
+struct TraceGenOptions {
+  FrictionParams friction;
+  float cofLo = 0.25f;          // true COF drawn uniformly from [cofLo, cofHi]
+  float cofHi = 0.25f;
+
+  // Pass geometry and timing (sketch defaults)
+  float lowerIn    = 2.5f;
+  float measureIn  = 3.0f;
+  float passSec    = 9.12f;     // 3.0" at STEP_PULSE_US = 150
+  float pauseSec   = 0.6f;
+  float sampleHz   = 320.0f;
+  long  maxSamples = 3200;      // MAX_SAMPLES_PER_PASS
+
+  NoiseColor color   = NOISE_WHITE;
+  float colorLb      = 0.0f;    // 1σ of the colored component
+  float outlierProb  = 0.0f;    // per sample
+  float outlierLb    = 0.5f;    // spike amplitude (uniform ± this)
+  float dropProb     = 0.0f;    // per conversion
+  float jitterFrac   = 0.0f;    // sample-time jitter, fraction of the period
+};
+
+struct GeneratedRun {
+  uint64_t seed;
+  float    trueCof;
+  std::vector<float> fwd;
+  std::vector<float> rev;
+};
+
+// Per-run seed derived from a base seed and run index (splitmix64). All 64
+// bits are kept: sweeps of millions of runs would collide in 32.
+uint64_t traceGenSeed(uint64_t baseSeed, uint64_t runIndex);
+
+void generateRun(const TraceGenOptions& opts, uint64_t seed, GeneratedRun& out);
+
+// Appends the run in the sketch's CSV dump format (readable by TraceReplay),
+// preceded by a "# run=..." comment line.
+void appendRunCsv(const GeneratedRun& run, uint64_t runIndex, std::string& out);
+
+#endif // TRACE_GEN_H
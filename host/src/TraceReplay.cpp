@@ -0,0 +1,42 @@
+#include "TraceReplay.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+bool TraceReplay::load(const char* path) {
+  FILE* f = fopen(path, "r");
+  if (!f) return false;
+
+  fwd_.clear();
+  rev_.clear();
+
+  char line[256];
+  while (fgets(line, sizeof(line), f)) {
+    if (!strncmp(line, "---CSV_END---", 13)) break;
+
+    bool isFwd = !strncmp(line, "FWD,", 4);
+    bool isRev = !strncmp(line, "REV,", 4);
+    if (!isFwd && !isRev) continue;
+
+    const char* comma = strchr(line + 4, ',');
+    if (!comma) continue;
+    float v = strtof(comma + 1, nullptr);
+    (isFwd ? fwd_ : rev_).push_back(v);
+  }
+  fclose(f);
+  return !empty();
+}
+
+static float interpolate(const std::vector<float>& v, float fraction) {
+  if (v.empty()) return 0.0f;
+  if (fraction <= 0.0f) return v.front();
+  if (fraction >= 1.0f) return v.back();
+  float x = fraction * (float)(v.size() - 1);
+  size_t i = (size_t)x;
+  float t = x - (float)i;
+  return (i + 1 < v.size()) ? v[i] + (v[i + 1] - v[i]) * t : v[i];
+}
+
+float TraceReplay::force(bool forwardPass, float fraction) const {
+  return interpolate(forwardPass ? fwd_ : rev_, fraction);
+}
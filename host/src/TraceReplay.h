@@ -0,0 +1,31 @@
+#ifndef TRACE_REPLAY_H
+#define TRACE_REPLAY_H
+
+#include <vector>
+
+// ---------------------------------------------------------------------------
+// Recorded force trace (dataDumps/*.csv, the sketch's CSV dump format)
+// ---------------------------------------------------------------------------
+// Rows are "pass,index,force_lb" with pass = FWD or REV; header lines and
+// ---CSV_START--- / ---CSV_END--- markers are skipped, as is anything after
+// the first ---CSV_END--- (the paired section of a serial capture).
+class TraceReplay {
+ public:
+  bool load(const char* path);
+
+  bool empty() const { return fwd_.empty() || rev_.empty(); }
+
+  // Force at a fraction [0,1] of the measurement pass, in time order of the
+  // pass (REV fraction 0 is where the reverse pass starts). Linear
+  // interpolation between recorded samples.
+  float force(bool forwardPass, float fraction) const;
+
+  const std::vector<float>& fwd() const { return fwd_; }
+  const std::vector<float>& rev() const { return rev_; }
+
+ private:
+  std::vector<float> fwd_;
+  std::vector<float> rev_;
+};
+
+#endif // TRACE_REPLAY_H
@@ -0,0 +1,178 @@
+#include "VirtualScheduler.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+// Host code (printf, iostreams) needs far more stack than the ESP32 task sizes
+static const uint32_t MIN_STACK_BYTES = 256 * 1024;
+
+VirtualScheduler::VirtualScheduler()
+  : current_(-1), now_(0), switches_(0), stopped_(false) {
+  for (int c = 0; c < 2; c++) {
+    cores_[c].busyTask  = -1;
+    cores_[c].busyUntil = 0;
+  }
+}
+
+VirtualScheduler::~VirtualScheduler() {
+  for (Task* t : tasks_) {
+    free(t->stack);
+    delete t;
+  }
+}
+
+int VirtualScheduler::spawn(TaskFn fn, void* arg, const char* name,
+                            int priority, int core, uint32_t stackBytes) {
+  Task* t = new Task();
+  uint32_t size = (stackBytes < MIN_STACK_BYTES) ? MIN_STACK_BYTES : stackBytes;
+  t->stack    = (char*)malloc(size);
+  t->fn       = fn;
+  t->arg      = arg;
+  t->name     = name;
+  t->priority = priority;
+  t->core     = (core == 0) ? 0 : 1;
+  t->state    = READY;
+  t->wakeAt   = now_;
+  t->notified = false;
+
+  int id = (int)tasks_.size();
+  tasks_.push_back(t);
+
+  getcontext(&t->ctx);
+  t->ctx.uc_stack.ss_sp   = t->stack;
+  t->ctx.uc_stack.ss_size = size;
+  t->ctx.uc_link          = &schedCtx_;
+  uintptr_t self = (uintptr_t)this;
+  makecontext(&t->ctx, (void (*)())trampoline, 3,
+              (unsigned int)(self >> 32), (unsigned int)(self & 0xFFFFFFFFu), id);
+  return id;
+}
+
+void VirtualScheduler::trampoline(unsigned int hi, unsigned int lo, int id) {
+  VirtualScheduler* s = (VirtualScheduler*)(((uintptr_t)hi << 32) | (uintptr_t)lo);
+  Task* t = s->tasks_[id];
+  t->fn(t->arg);
+  t->state = DONE;
+  // returning resumes schedCtx_ via uc_link
+}
+
+int VirtualScheduler::currentCore() const {
+  return (current_ >= 0) ? tasks_[current_]->core : 1;
+}
+
+// ---------------------------------------------------------------------------
+// Scheduling
+// ---------------------------------------------------------------------------
+
+// Earliest time the task could run, accounting for a higher-priority task
+// busy-waiting on its core.
+uint64_t VirtualScheduler::effectiveWake(int id) const {
+  const Task* t = tasks_[id];
+  uint64_t wake = t->wakeAt;
+  const Core& c = cores_[t->core];
+  if (c.busyTask >= 0 && c.busyTask != id &&
+      tasks_[c.busyTask]->priority > t->priority && c.busyUntil > wake) {
+    wake = c.busyUntil;
+  }
+  return wake;
+}
+
+int VirtualScheduler::pickNext() const {
+  int best = -1;
+  uint64_t bestWake = FOREVER;
+  for (int i = 0; i < (int)tasks_.size(); i++) {
+    const Task* t = tasks_[i];
+    if (t->state == DONE || t->wakeAt == FOREVER) continue;
+    uint64_t w = effectiveWake(i);
+    if (best < 0 || w < bestWake ||
+        (w == bestWake && t->priority > tasks_[best]->priority)) {
+      best = i;
+      bestWake = w;
+    }
+  }
+  return best;
+}
+
+bool VirtualScheduler::run() {
+  while (!stopped_) {
+    int next = pickNext();
+    if (next < 0) {
+      fprintf(stderr, "VirtualScheduler: deadlock at t=%llu us\n",
+              (unsigned long long)now_);
+      return false;
+    }
+    Task* t = tasks_[next];
+    uint64_t w = effectiveWake(next);
+    if (w > now_) now_ = w;
+    t->state  = READY;
+    current_  = next;
+    switches_++;
+    swapcontext(&schedCtx_, &t->ctx);
+    current_ = -1;
+  }
+  return true;
+}
+
+void VirtualScheduler::stop() {
+  stopped_ = true;
+  yield();
+}
+
+// Suspends the current task until the scheduler picks it again. If it is
+// already the next task to run, just advance the clock (no context switch).
+void VirtualScheduler::yield() {
+  int self = current_;
+  if (!stopped_ && pickNext() == self) {
+    uint64_t w = effectiveWake(self);
+    if (w > now_) now_ = w;
+    tasks_[self]->state = READY;
+    return;
+  }
+  swapcontext(&tasks_[self]->ctx, &schedCtx_);
+}
+
+void VirtualScheduler::sleepUs(uint64_t us) {
+  Task* t = tasks_[current_];
+  Core& c = cores_[t->core];
+  if (c.busyTask == current_) c.busyTask = -1;
+  t->state  = WAITING;
+  t->wakeAt = now_ + us;
+  yield();
+}
+
+void VirtualScheduler::busyWaitUs(uint64_t us) {
+  Task* t = tasks_[current_];
+  Core& c = cores_[t->core];
+  c.busyTask  = current_;
+  c.busyUntil = now_ + us;
+  t->state  = WAITING;
+  t->wakeAt = now_ + us;
+  yield();
+  if (c.busyTask == current_ && c.busyUntil <= now_) c.busyTask = -1;
+}
+
+bool VirtualScheduler::waitOn(WaitList& w, uint64_t timeoutUs) {
+  Task* t = tasks_[current_];
+  Core& c = cores_[t->core];
+  if (c.busyTask == current_) c.busyTask = -1;
+  t->state    = WAITING;
+  t->notified = false;
+  t->wakeAt   = (timeoutUs == FOREVER) ? FOREVER : now_ + timeoutUs;
+  w.tasks.push_back(current_);
+  yield();
+
+  // Drop from the wait list if we timed out
+  for (size_t i = 0; i < w.tasks.size(); i++) {
+    if (w.tasks[i] == current_) { w.tasks.erase(w.tasks.begin() + i); break; }
+  }
+  return t->notified;
+}
+
+void VirtualScheduler::notifyAll(WaitList& w) {
+  for (int id : w.tasks) {
+    Task* t = tasks_[id];
+    t->notified = true;
+    t->wakeAt   = now_;
+  }
+  w.tasks.clear();
+}
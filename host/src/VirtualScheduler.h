@@ -0,0 +1,89 @@
+#ifndef VIRTUAL_SCHEDULER_H
+#define VIRTUAL_SCHEDULER_H
+
+#include <stdint.h>
+#include <ucontext.h>
+#include <vector>
+
+// ---------------------------------------------------------------------------
+// Deterministic virtual-time scheduler
+// ---------------------------------------------------------------------------
+// Runs every sketch task as a fiber on a single host thread. Code between
+// two HAL waits executes in zero virtual time; the clock only moves when
+// every task is waiting, and then jumps straight to the next wake-up. The
+// run is therefore a pure function of the inputs (seed, options) and a
+// 40-second test simulates in well under a second.
+//
+// Two simulated cores with FreeRTOS-style fixed priorities:
+//   sleepUs()     vTaskDelay/delay(): releases the core
+//   busyWaitUs()  delayMicroseconds(): keeps the core, so lower-priority
+//                 tasks pinned to it are starved until it finishes
+// Ties at the same instant go to the higher priority, then the older task.
+
+class VirtualScheduler {
+ public:
+  static const uint64_t FOREVER = ~0ull;
+
+  // Tasks blocked on a queue/semaphore
+  struct WaitList { std::vector<int> tasks; };
+
+  typedef void (*TaskFn)(void* arg);
+
+  VirtualScheduler();
+  ~VirtualScheduler();
+
+  int  spawn(TaskFn fn, void* arg, const char* name, int priority, int core,
+             uint32_t stackBytes);
+
+  // Runs tasks until stop() or until every task is blocked forever.
+  // Returns false on deadlock.
+  bool run();
+  void stop();
+
+  uint64_t nowUs() const { return now_; }
+  int      currentCore() const;
+  uint64_t switches() const { return switches_; }
+
+  // Called from inside tasks
+  void sleepUs(uint64_t us);
+  void busyWaitUs(uint64_t us);
+  bool waitOn(WaitList& w, uint64_t timeoutUs);   // false on timeout
+  void notifyAll(WaitList& w);
+
+ private:
+  enum State { READY, WAITING, DONE };
+
+  struct Task {
+    ucontext_t  ctx;
+    char*       stack;
+    TaskFn      fn;
+    void*       arg;
+    const char* name;
+    int         priority;
+    int         core;
+    State       state;
+    uint64_t    wakeAt;      // FOREVER while blocked without timeout
+    bool        notified;
+  };
+
+  struct Core {
+    int      busyTask;       // task holding the core in a busy-wait, or -1
+    uint64_t busyUntil;
+  };
+
+  static void trampoline(unsigned int hi, unsigned int lo, int id);
+
+  int      pickNext() const;
+  uint64_t effectiveWake(int id) const;
+  void     yield();
+
+  std::vector<Task*> tasks_;   // stable addresses: ucontext_t is self-referential
+  Core              cores_[2];
+  ucontext_t        schedCtx_;
+  int               current_;
+  uint64_t          now_;
+  uint64_t          switches_;
+  bool              stopped_;
+};
+
+#endif // VIRTUAL_SCHEDULER_H
@@ -0,0 +1,523 @@
+#include "HalHost.h"
+#include "RigSim.h"
+#include "Profiler.h"
+#include "Trace.h"
+#include "CycleStats.h"
+#include "IoRecorder.h"
+#include "IoLog.h"
+#include "DisplayTask.h"
+#include "I2cBus.h"
+#include "NfcWriter.h"
+#include "TempComp.h"
+#include "VirtualScheduler.h"
+#include "HeapStats.h"
+#include "StaticScreens.h"
+#include <algorithm>
+#include <random>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Sketch entry points and sample counters (Friction-Tester.ino)
+void setup();
+void loop();
+extern volatile long g_fwdSampleCount;
+extern volatile long g_revSampleCount;
+extern float g_calibration;
+extern long  g_tareRaw;
+extern float g_calCurve;
+extern TempModel g_tempModel;
+extern uint32_t g_testsRun;
+extern float g_lastCOF;
+extern bool  g_tagFirst;
+extern uint8_t g_testsPerPaddle;
+void endPaddle();
+
+// Print sink for binary dumps (the host Serial is line-oriented text)
+class FilePrint : public Print {
+ public:
+  explicit FilePrint(FILE* f) : f_(f) {}
+  size_t write(uint8_t c) override { return fputc(c, f_) == EOF ? 0 : 1; }
+  size_t write(const uint8_t* buf, size_t n) override { return fwrite(buf, 1, n, f_); }
+
+ private:
+  FILE* f_;
+};
+
+class BufferPrint : public Print {
+ public:
+  size_t write(uint8_t c) override { buf.push_back(c); return 1; }
+  size_t write(const uint8_t* b, size_t n) override { buf.insert(buf.end(), b, b + n); return n; }
+
+  std::vector<uint8_t> buf;
+};
+
+struct Session {
+  RigSim*  rig;
+  int      runs;
+  bool     showOled;
+  bool     monteCarlo;
+  bool     profile;
+  bool     cycleStats;
+  bool     displayStats;
+  bool     i2cStats;
+  const char* traceOut;
+  const char* ioOut;
+  const IoLog* ioReplay;
+  float    cofLo, cofHi;
+  uint32_t seed;
+  VirtualScheduler* sched;
+  std::vector<HeapSnapshot>* heap;   // --heap-soak: one snapshot per run
+  bool     tagFirst;
+  bool     tempComp;                 // start with the rig's temperature model learned
+  int      testsPerPaddle;
+  std::vector<uint32_t>* startMs;    // START press per paddle
+  bool     checkOled;
+  int      resultsPanels;            // --check-oled: cycles whose panel showed the results
+  std::vector<float>* testCofs;      // --check-tags: each test's result
+};
+
+// Every pixel of the pre-rendered results screen is lit on the panel (the
+// value, plots and test count only add pixels)
+static bool panelShowsResults() {
+  const uint8_t* panel = halDisplay().gddram();
+  const StaticScreen& s = SCREEN_RESULTS;
+  for (int i = 0; i < s.pages * SimDisplay::WIDTH; i++) {
+    uint8_t want = s.data[i];
+    if ((panel[s.page0 * SimDisplay::WIDTH + i] & want) != want) return false;
+  }
+  return true;
+}
+
+// --heap-soak: runs before this are warm-up (lazy buffers, first-use
+// allocations); after it the heap must not be touched at all
+static const int HEAP_WARMUP_RUNS = 2;
+
+// Boot, then one loop() pass per test cycle. In Monte Carlo mode each
+// cycle draws a fresh true COF and noise seed and prints one CSV row.
+static void runSession(void* arg) {
+  Session* s = (Session*)arg;
+  std::mt19937 rng(s->seed);
+  std::uniform_real_distribution<float> cofDist(s->cofLo, s->cofHi);
+
+  setup();
+  g_tagFirst = s->tagFirst;
+  if (s->tempComp) {
+    // As if check points had been taken across the drift
+    const RigSimOptions& o = s->rig->options();
+    g_tempModel = TempModel{ o.tempC, o.offsetPerC, o.gainPerC, 1 };
+  }
+  g_testsPerPaddle = (uint8_t)s->testsPerPaddle;
+  if (s->ioReplay) {
+    // Convert readings with the device's calibration context, not the
+    // simulated boot tare
+    g_calibration = s->ioReplay->header().calibration;
+    g_tareRaw     = s->ioReplay->header().tareRaw;
+    g_calCurve    = s->ioReplay->header().calCurve;
+    g_tempModel   = TempModel{ 25.0f, 0.0f, 0.0f, 0 };   // the header has it applied
+  }
+  if (s->monteCarlo) {
+    Serial.mute(true);
+    printf("run,seed,true_cof,measured_cof,fwd_samples,rev_samples\n");
+  }
+
+  struct McRow { int paddle; uint32_t seed; float trueCof; long fwd, rev; };
+  std::vector<McRow> rows;
+  for (int run = 0; run < s->runs; run++) {
+    FrictionParams fp = s->rig->options().friction;
+    uint32_t runSeed = s->seed + (uint32_t)run;
+    if (s->monteCarlo) {
+      fp.cof = cofDist(rng);
+      s->rig->setFriction(fp, runSeed);
+    }
+
+    // Tag first: the operator has the paddle's tag at hand before its
+    // first START; otherwise it is picked up once its last test is done
+    int  paddle = run / s->testsPerPaddle;
+    bool firstOfPaddle = run % s->testsPerPaddle == 0;
+    bool lastOfPaddle = run % s->testsPerPaddle == s->testsPerPaddle - 1 || run == s->runs - 1;
+    if (s->tagFirst && firstOfPaddle) s->rig->paddleTagReady();
+
+    // Earlier results' tags are written while this paddle is tested; loop()
+    // also returns to show those outcomes, so press until a test has run
+    uint32_t testsBefore = g_testsRun;
+    uint32_t pressAt = 0;
+    while (g_testsRun == testsBefore) {
+      pressAt = halMillis() + 500;
+      s->rig->pressButton(pressAt, 150);
+      loop();
+    }
+    if (firstOfPaddle) s->startMs->push_back(pressAt);
+    if (lastOfPaddle) {
+      endPaddle();   // runs ran out mid-paddle
+      if (!s->tagFirst) s->rig->paddleTagReady();
+    }
+    if (s->showOled || s->checkOled) {
+      // The results frame is still on its way to the panel
+      while (!displayIdle()) halDelayMs(1);
+    }
+    if (s->showOled) halDisplay().dumpAscii(stdout);
+    if (s->checkOled && panelShowsResults()) s->resultsPanels++;
+    if (s->testCofs) s->testCofs->push_back(g_lastCOF);
+    if (s->heap) s->heap->push_back(heapSnapshot());
+    if (s->monteCarlo) {
+      rows.push_back({ paddle, runSeed, fp.cof, (long)g_fwdSampleCount, (long)g_revSampleCount });
+    }
+  }
+
+  // The operator presents the remaining tags
+  while (nfcWriterPending()) loop();
+
+  for (size_t run = 0; run < rows.size(); run++) {
+    const McRow& r = rows[run];
+    float measured = NAN;
+    const std::vector<int>& paddles = s->rig->writtenPaddles();
+    int nth = (int)run % s->testsPerPaddle;   // the paddle's results are written in test order
+    for (size_t i = 0; i < paddles.size(); i++) {
+      if (paddles[i] == r.paddle && nth-- == 0) measured = s->rig->writtenCofs()[i];
+    }
+    printf("%zu,%u,%.5f,%.5f,%ld,%ld\n", run, r.seed, r.trueCof, measured, r.fwd, r.rev);
+  }
+
+  if (s->profile || s->cycleStats || s->displayStats || s->i2cStats) Serial.mute(false);
+  if (s->profile) profilerPrint();
+  if (s->cycleStats) cycleStatsPrint();
+  if (s->displayStats) displayStatsPrint();
+  if (s->i2cStats) i2cBusStatsPrint();
+
+  if (s->traceOut) {
+    FILE* f = fopen(s->traceOut, "wb");
+    if (f) {
+      FilePrint out(f);
+      traceDump(out);
+      fclose(f);
+    } else {
+      fprintf(stderr, "cannot write %s\n", s->traceOut);
+    }
+  }
+
+  if (s->ioOut) {
+    FILE* f = fopen(s->ioOut, "wb");
+    if (f) {
+      FilePrint out(f);
+      ioRecordDump(out);
+      fclose(f);
+    } else {
+      fprintf(stderr, "cannot write %s\n", s->ioOut);
+    }
+  }
+
+  if (s->sched) s->sched->stop();
+}
+
+// Heap allocations and live bytes per run. Returns false if any run after
+// the warm-up allocated or changed the live heap.
+static bool printHeapSoakReport(const std::vector<HeapSnapshot>& runs) {
+  printf("\n===== HEAP SOAK =====\n");
+  printf("run,allocs,frees,live_bytes,peak_bytes\n");
+  bool flat = true;
+  for (size_t i = 0; i < runs.size(); i++) {
+    const HeapSnapshot& h = runs[i];
+    uint64_t allocs = h.allocs - (i ? runs[i - 1].allocs : 0);
+    uint64_t frees  = h.frees  - (i ? runs[i - 1].frees  : 0);
+    printf("%zu,%llu,%llu,%lld,%lld\n", i + 1, (unsigned long long)allocs,
+           (unsigned long long)frees, (long long)h.liveBytes, (long long)h.peakBytes);
+    if ((int)i >= HEAP_WARMUP_RUNS && (allocs || h.liveBytes != runs[i - 1].liveBytes)) flat = false;
+  }
+  if ((int)runs.size() <= HEAP_WARMUP_RUNS) {
+    printf("Heap:            need more than %d runs\n", HEAP_WARMUP_RUNS);
+    return false;
+  }
+  printf("Heap:            %s after %d warm-up runs\n", flat ? "flat" : "NOT FLAT", HEAP_WARMUP_RUNS);
+  return flat;
+}
+
+// --check-tags: results that went onto their own paddle's tag, in test order
+static int resultsOnOwnTag(const RigSim& rig, const std::vector<float>& cofs, int testsPerPaddle) {
+  int ok = 0;
+  for (size_t run = 0; run < cofs.size(); run++) {
+    int paddle = (int)run / testsPerPaddle;
+    int nth = (int)run % testsPerPaddle;
+    for (size_t i = 0; i < rig.writtenPaddles().size(); i++) {
+      if (rig.writtenPaddles()[i] != paddle || nth-- != 0) continue;
+      if (rig.writtenCofs()[i] == cofs[run]) ok++;
+      break;
+    }
+  }
+  return ok;
+}
+
+// Recorded session vs. the session the replay just produced: the inputs are
+// the same by construction, so differences in the outputs (steps, DIR/EN)
+// or in the readings consumed point at firmware behaviour.
+static void printReplayReport(const IoLog& recorded) {
+  BufferPrint dump;
+  ioRecordDump(dump);
+  IoLog replayed;
+  if (!replayed.parseCapture(dump.buf.data(), dump.buf.size())) {
+    printf("Replay:          no session recorded (%s)\n", replayed.error().c_str());
+    return;
+  }
+
+  const IoRecordHeader& h = recorded.header();
+  IoSummary a = recorded.summarize();
+  IoSummary b = replayed.summarize();
+  printf("\n===== I/O REPLAY =====\n");
+  if (h.flags & IO_FLAG_OVERFLOW) printf("WARNING: recording overflowed; replay covers a prefix\n");
+  printf("                 %12s %12s\n", "recorded", "replayed");
+  printf("Duration ms      %12.1f %12.1f\n", h.durationUs / 1000.0,
+         replayed.header().durationUs / 1000.0);
+  printf("Steps            %12llu %12llu\n", (unsigned long long)a.steps, (unsigned long long)b.steps);
+  printf("Step runs        %12u %12u\n", a.stepRuns, b.stepRuns);
+  printf("DIR / EN edges   %5u / %-4u %5u / %-4u\n", a.dirEdges, a.enableEdges, b.dirEdges, b.enableEdges);
+  printf("Limit edges      %12u %12u\n", a.limitEdges, b.limitEdges);
+  printf("Button edges     %12u %12u\n", a.buttonEdges, b.buttonEdges);
+  printf("Readings         %12u %12u\n", a.readings, b.readings);
+  printf("Motion segments  %12zu %12zu\n", a.segments.size(), b.segments.size());
+
+  // First diverging motion segment; start skew up to a poll period is
+  // expected (tasks resume on the simulated tick, not the device's)
+  const int32_t SKEW_US = 20000;
+  int32_t maxSkew = 0;
+  size_t n = std::min(a.segments.size(), b.segments.size());
+  for (size_t i = 0; i < n; i++) {
+    const IoMotionSegment& x = a.segments[i];
+    const IoMotionSegment& y = b.segments[i];
+    int32_t skew = (int32_t)(y.firstStepUs - x.firstStepUs);
+    if (abs(skew) > abs(maxSkew)) maxSkew = skew;
+    if (x.steps != y.steps || x.dir != y.dir || abs(skew) > SKEW_US) {
+      printf("Divergence:      segment %zu: recorded %llu steps dir %u at %.1f ms, "
+             "replayed %llu steps dir %u at %.1f ms\n", i,
+             (unsigned long long)x.steps, x.dir, x.firstStepUs / 1000.0,
+             (unsigned long long)y.steps, y.dir, y.firstStepUs / 1000.0);
+      return;
+    }
+  }
+  if (a.segments.size() != b.segments.size()) {
+    printf("Divergence:      segment count differs after segment %zu\n", n);
+    return;
+  }
+  printf("Outputs match    (max segment start skew %.2f ms)\n", maxSkew / 1000.0);
+}
+
+static void usage(const char* argv0) {
+  fprintf(stderr,
+          "usage: %s [options]\n"
+          "  Boots the sketch on the simulated rig and runs N test cycles:\n"
+          "  press START, run the test, present the NFC tag.\n"
+          "\n"
+          "  --runs N            test cycles (default 1)\n"
+          "  --speed X           virtual time runs X times faster than real time\n"
+          "  --deterministic     single-threaded discrete-event time (reproducible,\n"
+          "                      much faster than --speed)\n"
+          "  --cof-range LO HI   Monte Carlo: draw the true COF per run, print CSV\n"
+          "  --seed N            RNG seed for noise\n"
+          "  --tag-delay-ms MS   operator presents the tag MS after the first poll\n"
+          "  --tag-lift-ms MS    a written tag stays on the reader MS (default 400)\n"
+          "  --tags-reversed     operator presents the last tag at hand first\n"
+          "  --check-tags        exit 1 unless every result reaches its own paddle's tag\n"
+          "  --tag-first         operator presents each tag before pressing START\n"
+          "                      (default: after the test; NFC_TAG_FIRST_ENABLED builds)\n"
+          "  --tests-per-paddle N  test each paddle N times (1-5), one tag write each\n"
+          "  --tag-capacity N    measurements a tag holds (default 9)\n"
+          "  --nfc-no-irq        reader IRQ not wired: poll for tags every 250 ms\n"
+          "  --nfc-max-i2c HZ    fastest I2C clock the NFC reader answers at\n"
+          "                      (default 400000; the OLED keeps up with 1 MHz,\n"
+          "                      probed only with -DI2C_MAX_CLOCK_HZ=1000000)\n"
+          "  --show-oled         print the panel after each cycle, once the display\n"
+          "                      task has flushed the results screen\n"
+          "  --check-oled        exit 1 unless the panel shows the results screen\n"
+          "                      after every cycle\n"
+          "  --profile           print the profiler table after the last cycle\n"
+          "  --dump-trace FILE   write the event trace ring (trace_to_chrome input)\n"
+          "  --cycle-stats       print the per-stage cycle-time table at the end\n"
+          "  --display-stats     print display task bus statistics at the end\n"
+          "  --i2c-stats         print shared I2C bus arbitration statistics at the end\n"
+          "  --dump-io FILE      write the last cycle's I/O session recording\n"
+          "  --heap-soak         count heap use per run; exit 1 unless it stays flat\n"
+          "                      after %d warm-up runs\n"
+          "  --replay-io FILE    replay a recorded session's inputs (serial capture\n"
+          "                      or --dump-io file) and compare the outputs;\n"
+          "                      implies --deterministic --runs 1\n"
+          "\n"
+          "  friction model:\n"
+          "  --cof X  --normal-lb X  --noise-lb X  --offset-lb X  --drift-lb-min X\n"
+          "  --stick-slip-lb X  --stick-slip-in X  --surface-lb X  --settle-ms X\n"
+          "  --trace FILE        replay FWD/REV force from a CSV dump instead\n"
+          "\n"
+          "  load cell temperature:\n"
+          "  --temp-drift C_PER_HOUR  --gain-tempco FRACTION_PER_C  --offset-tempco COUNTS_PER_C\n"
+          "  --temp-comp         the sketch starts with that model learned\n",
+          argv0, HEAP_WARMUP_RUNS);
+}
+
+int main(int argc, char** argv) {
+  RigSimOptions opts;
+  FrictionParams& fp = opts.friction;
+  TraceReplay trace;
+  int    runs = 1;
+  double speed = 1.0;
+  bool   showOled = false;
+  bool   checkOled = false;
+  bool   checkTags = false;
+  bool   deterministic = false;
+  bool   monteCarlo = false;
+  bool   profile = false;
+  bool   cycleStats = false;
+  bool   displayStats = false;
+  bool   i2cStats = false;
+  bool   heapSoak = false;
+  bool   tagFirst = false;
+  bool   tempComp = false;
+  int    testsPerPaddle = 1;
+  const char* traceOut = nullptr;
+  const char* ioOut = nullptr;
+  IoLog  ioReplay;
+  bool   replay = false;
+  float  cofLo = 0.0f, cofHi = 0.0f;
+
+  for (int i = 1; i < argc; i++) {
+    const char* a = argv[i];
+    bool hasArg = (i + 1 < argc);
+    if      (!strcmp(a, "--runs") && hasArg)          runs = atoi(argv[++i]);
+    else if (!strcmp(a, "--speed") && hasArg)         speed = atof(argv[++i]);
+    else if (!strcmp(a, "--seed") && hasArg)          opts.seed = (uint32_t)strtoul(argv[++i], nullptr, 10);
+    else if (!strcmp(a, "--tag-delay-ms") && hasArg)  opts.tagDelayMs = (uint32_t)atol(argv[++i]);
+    else if (!strcmp(a, "--tag-lift-ms") && hasArg)   opts.tagLiftMs = (uint32_t)atol(argv[++i]);
+    else if (!strcmp(a, "--tags-reversed"))           opts.tagsReversed = true;
+    else if (!strcmp(a, "--check-tags"))              checkTags = true;
+    else if (!strcmp(a, "--nfc-max-i2c") && hasArg)   opts.nfcMaxI2cHz = (uint32_t)strtoul(argv[++i], nullptr, 10);
+    else if (!strcmp(a, "--show-oled"))               showOled = true;
+    else if (!strcmp(a, "--check-oled"))              checkOled = true;
+    else if (!strcmp(a, "--deterministic"))           deterministic = true;
+    else if (!strcmp(a, "--profile"))                 profile = true;
+    else if (!strcmp(a, "--cycle-stats"))             cycleStats = true;
+    else if (!strcmp(a, "--display-stats"))           displayStats = true;
+    else if (!strcmp(a, "--i2c-stats"))               i2cStats = true;
+    else if (!strcmp(a, "--heap-soak"))               heapSoak = true;
+    else if (!strcmp(a, "--tag-first"))               tagFirst = true;
+    else if (!strcmp(a, "--nfc-no-irq"))              opts.nfcIrq = false;
+    else if (!strcmp(a, "--temp-drift") && hasArg)    opts.tempDriftCPerHour = (float)atof(argv[++i]);
+    else if (!strcmp(a, "--gain-tempco") && hasArg)   opts.gainPerC = (float)atof(argv[++i]);
+    else if (!strcmp(a, "--offset-tempco") && hasArg) opts.offsetPerC = (float)atof(argv[++i]);
+    else if (!strcmp(a, "--temp-comp"))               tempComp = true;
+    else if (!strcmp(a, "--tests-per-paddle") && hasArg) testsPerPaddle = atoi(argv[++i]);
+    else if (!strcmp(a, "--tag-capacity") && hasArg)  opts.tagCapacity = (uint8_t)atoi(argv[++i]);
+    else if (!strcmp(a, "--dump-trace") && hasArg)    traceOut = argv[++i];
+    else if (!strcmp(a, "--dump-io") && hasArg)       ioOut = argv[++i];
+    else if (!strcmp(a, "--replay-io") && hasArg) {
+      const char* path = argv[++i];
+      if (!ioReplay.load(path)) {
+        fprintf(stderr, "cannot load I/O recording %s: %s\n", path, ioReplay.error().c_str());
+        return 2;
+      }
+      replay = true;
+    }
+    else if (!strcmp(a, "--cof-range") && i + 2 < argc) {
+      cofLo = (float)atof(argv[++i]);
+      cofHi = (float)atof(argv[++i]);
+      monteCarlo = true;
+    }
+    else if (!strcmp(a, "--cof") && hasArg)           fp.cof = (float)atof(argv[++i]);
+    else if (!strcmp(a, "--normal-lb") && hasArg)     fp.normalForceLb = (float)atof(argv[++i]);
+    else if (!strcmp(a, "--noise-lb") && hasArg)      fp.noiseLb = (float)atof(argv[++i]);
+    else if (!strcmp(a, "--offset-lb") && hasArg)     fp.offsetLb = (float)atof(argv[++i]);
+    else if (!strcmp(a, "--drift-lb-min") && hasArg)  fp.driftLbPerMin = (float)atof(argv[++i]);
+    else if (!strcmp(a, "--stick-slip-lb") && hasArg) fp.stickSlipLb = (float)atof(argv[++i]);
+    else if (!strcmp(a, "--stick-slip-in") && hasArg) fp.stickSlipPeriodIn = (float)atof(argv[++i]);
+    else if (!strcmp(a, "--surface-lb") && hasArg)    fp.surfaceLb = (float)atof(argv[++i]);
+    else if (!strcmp(a, "--settle-ms") && hasArg)     fp.settleMs = (float)atof(argv[++i]);
+    else if (!strcmp(a, "--trace") && hasArg) {
+      const char* path = argv[++i];
+      if (!trace.load(path)) {
+        fprintf(stderr, "cannot load trace %s\n", path);
+        return 2;
+      }
+      opts.trace = &trace;
+    }
+    else { usage(argv[0]); return 2; }
+  }
+  if (testsPerPaddle < 1 || testsPerPaddle > 5) { usage(argv[0]); return 2; }
+  if (tagFirst && !NFC_TAG_FIRST_ENABLED) {
+    fprintf(stderr, "--tag-first needs a build with -DNFC_TAG_FIRST_ENABLED=1 -DHAL_NFC_TAG_UUID=1"
+                    " -DHAL_NFC_STAGED_COMMIT=1\n");
+    return 2;
+  }
+  if (replay) {
+    if (monteCarlo) { usage(argv[0]); return 2; }
+    opts.ioReplay = &ioReplay;
+    deterministic = true;
+    runs = 1;
+  }
+
+  std::vector<HeapSnapshot> heapRuns;
+  heapRuns.reserve(runs);  // no growth while measuring
+  std::vector<uint32_t> startMs;
+  startMs.reserve(runs);
+  std::vector<float> testCofs;
+  testCofs.reserve(runs);
+
+  RigSim rig(opts);
+  hostSetRig(&rig);
+  hostPrefsSeedFloat("cof", "calib", opts.countsPerLb);
+
+  VirtualScheduler sched;
+  Session session = { &rig, runs, showOled, monteCarlo, profile, cycleStats, displayStats, i2cStats, traceOut, ioOut,
+                      replay ? &ioReplay : nullptr, cofLo, cofHi, opts.seed,
+                      deterministic ? &sched : nullptr, heapSoak ? &heapRuns : nullptr,
+                      tagFirst, tempComp, testsPerPaddle, &startMs, checkOled, 0,
+                      checkTags ? &testCofs : nullptr };
+
+  if (deterministic) {
+    // Arduino loop task: core 1, priority 1
+    hostUseScheduler(&sched);
+    sched.spawn(runSession, &session, "loopTask", 1, 1, 8192);
+    if (!sched.run()) return 1;
+  } else {
+    hostSetTimeScale(speed);
+    hostSetCurrentCore(1);  // Arduino loop task runs on core 1
+    runSession(&session);
+  }
+  if (monteCarlo) {
+    fflush(stdout);
+    quick_exit(0);
+  }
+
+  RigSimStats st = rig.stats();
+  printf("\n===== SIM SUMMARY =====\n");
+  if (opts.trace) printf("Load:            trace replay (%zu FWD / %zu REV)\n",
+                         trace.fwd().size(), trace.rev().size());
+  else            printf("True COF:        %.4f\n", fp.cof);
+  printf("Virtual time:    %.1f s\n", halMillis() / 1000.0);
+  printf("Steps:           %llu (%u direction changes, %u limit closes)\n",
+         (unsigned long long)st.steps, st.dirChanges, st.limitCloses);
+  printf("ADC conversions: %llu, reads %llu, overruns %llu\n",
+         (unsigned long long)st.conversions, (unsigned long long)st.reads,
+         (unsigned long long)st.overruns);
+  if (deterministic) printf("Task switches:   %llu\n", (unsigned long long)sched.switches());
+  // End to end: from the paddle's START press to its tag written
+  uint64_t totalMs = 0;
+  for (size_t i = 0; i < rig.writtenCofs().size(); i++) {
+    int paddle = rig.writtenPaddles()[i];
+    uint32_t ms = rig.writtenAtMs()[i] - startMs[paddle];
+    totalMs += ms;
+    printf("Tag write %zu:     %.4f (paddle %d, %.2f s after START)\n", i + 1,
+           rig.writtenCofs()[i], paddle + 1, ms / 1000.0);
+  }
+  if (!rig.writtenCofs().empty()) {
+    printf("START to tag:    %.2f s mean (%s workflow)\n",
+           totalMs / 1000.0 / rig.writtenCofs().size(), tagFirst ? "tag-first" : "tag-after");
+    printf("Tag writes:      %u for %zu results\n", rig.tagWrites(), rig.writtenCofs().size());
+  }
+  if (replay) printReplayReport(ioReplay);
+  bool heapOk = !heapSoak || printHeapSoakReport(heapRuns);
+  bool oledOk = !checkOled || session.resultsPanels == runs;
+  if (checkOled) printf("Results panel:   %d of %d cycles\n", session.resultsPanels, runs);
+  int ownTag = resultsOnOwnTag(rig, testCofs, testsPerPaddle);
+  bool tagsOk = !checkTags || ownTag == runs;
+  if (checkTags) printf("Own tag:         %d of %d results\n", ownTag, runs);
+  fflush(stdout);
+
+  // Sketch tasks never return; skip static destructors they may still touch
+  quick_exit(heapOk && oledOk && tagsOk ? 0 : 1);
+}
@@ -0,0 +1,90 @@
+// ---------------------------------------------------------------------------
+// Shared I2C bus arbitration under load
+// ---------------------------------------------------------------------------
+// A display task rewriting the whole screen back to back and an NFC poller,
+// as fibers on the deterministic scheduler (core 0 and core 1, as on the
+// device). The polls land at a different point of the flush each time.
+// Fails unless the polls had to wait, each wait was at most one display
+// slice, and the display yielded the bus for them.
+//
+//   i2c_bus_test [clockHz]   default 400000
+
+#include "HalHost.h"
+#include "I2cBus.h"
+#include "VirtualScheduler.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+static const int      POLLS          = 100;
+static const uint32_t POLL_PERIOD_MS = 250;
+
+// Transaction overheads on top of the slice's clocked bytes
+static const uint32_t WAIT_SLACK_US = 500;
+
+static VirtualScheduler s_sched;
+static uint8_t          s_frame[128 * 8];
+static volatile bool    s_stop = false;
+static uint32_t         s_frames = 0;
+
+static void displayLoop(void*) {
+  while (!s_stop) {
+    halDisplayWriteRect(0, 7, 0, 127, s_frame);
+    s_frames++;
+  }
+}
+
+static void nfcLoop(void*) {
+  static const uint8_t uuid[16] = {};
+  static const uint32_t timestamp = 0;
+  static const float cof = 0.25f;
+  char msg[32];
+  uint8_t written;
+  for (int i = 0; i < POLLS; i++) {
+    halTaskDelayMs(POLL_PERIOD_MS + (uint32_t)(i % 10) * 3);
+    halNfcAccumulate(uuid, NULL, &timestamp, &cof, 1, &written, msg, sizeof(msg));
+  }
+  s_stop = true;
+  halTaskDelayMs(POLL_PERIOD_MS);  // lets the display finish its frame
+  s_sched.stop();
+}
+
+int main(int argc, char** argv) {
+  uint32_t hz = (argc > 1) ? (uint32_t)strtoul(argv[1], nullptr, 10) : 400000;
+
+  hostUseScheduler(&s_sched);
+  halI2cBegin();
+  halI2cProbeClock(hz);
+  i2cBusStatsReset();
+
+  s_sched.spawn(displayLoop, nullptr, "Display", 1, 0, 16384);
+  s_sched.spawn(nfcLoop, nullptr, "loopTask", 1, 1, 16384);
+  if (!s_sched.run()) {
+    printf("FAIL deadlock\n");
+    return 1;
+  }
+
+  Serial.mute(false);
+  i2cBusStatsPrint();
+  I2cClientStats nfc  = i2cBusStats(I2C_CLIENT_NFC);
+  I2cClientStats disp = i2cBusStats(I2C_CLIENT_DISPLAY);
+  double frameMs = s_frames ? disp.holdUs / 1000.0 / s_frames : 0.0;
+  printf("%u full frames, %.2f ms each on the bus\n", s_frames, frameMs);
+
+  int failures = 0;
+  if (nfc.acquires != (uint32_t)POLLS) {
+    printf("FAIL nfc acquires %u (want %d)\n", nfc.acquires, POLLS);
+    failures++;
+  }
+  if (nfc.contended == 0 || disp.yields == 0) {
+    printf("FAIL no contention: nfc contended %u, display yields %u\n",
+           nfc.contended, disp.yields);
+    failures++;
+  }
+  if (nfc.waitMaxUs > I2C_DISPLAY_SLICE_US + WAIT_SLACK_US) {
+    printf("FAIL nfc waited %u us (limit %u)\n", nfc.waitMaxUs,
+           I2C_DISPLAY_SLICE_US + WAIT_SLACK_US);
+    failures++;
+  }
+  printf("%d failure(s)\n", failures);
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,338 @@
+// ---------------------------------------------------------------------------
+// Performance-budget regression gate
+// ---------------------------------------------------------------------------
+// Replays the golden runs listed in golden/expected.csv through the analysis
+// pipeline (calculateCOF with both averaging strategies, the strategies on
+// their own, dumpPairedDataCSV, the results plots, the raw-to-lb conversion
+// of both passes) and fails if
+//   - a result drifts from the recorded value beyond tolerance,
+//   - any stage touches the heap (malloc/calloc/realloc/new), or
+//   - a stage's median time exceeds its budget (µs per 1000 pairs).
+//
+//   perf_gate GOLDEN_DIR            check (ctest runs this)
+//   perf_gate GOLDEN_DIR --update   rewrite expected.csv after an
+//                                   intentional numeric change
+//
+// PERF_BUDGET_SCALE=N multiplies every time budget (slow or loaded hosts).
+
+#include "CofCalculation.h"
+#include "LoadCellCal.h"
+#include "TraceReplay.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <new>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+// ---------------------------------------------------------------------------
+// Heap accounting
+// ---------------------------------------------------------------------------
+// malloc and friends are interposed for the whole process (glibc routes its
+// own internal allocations, e.g. qsort's merge buffer, through them too);
+// operator new/delete are replaced on top. Only counted while armed.
+
+extern "C" void* __libc_malloc(size_t);
+extern "C" void* __libc_calloc(size_t, size_t);
+extern "C" void* __libc_realloc(void*, size_t);
+extern "C" void  __libc_free(void*);
+
+static std::atomic<bool> s_armed(false);
+static std::atomic<long> s_allocs(0);
+
+extern "C" void* malloc(size_t n) {
+  if (s_armed) s_allocs++;
+  return __libc_malloc(n);
+}
+extern "C" void* calloc(size_t n, size_t sz) {
+  if (s_armed) s_allocs++;
+  return __libc_calloc(n, sz);
+}
+extern "C" void* realloc(void* p, size_t n) {
+  if (s_armed) s_allocs++;
+  return __libc_realloc(p, n);
+}
+extern "C" void free(void* p) { __libc_free(p); }
+
+void* operator new(size_t n) {
+  void* p = malloc(n ? n : 1);
+  if (!p) throw std::bad_alloc();
+  return p;
+}
+void* operator new[](size_t n) { return operator new(n); }
+void  operator delete(void* p) noexcept { free(p); }
+void  operator delete[](void* p) noexcept { free(p); }
+void  operator delete(void* p, size_t) noexcept { free(p); }
+void  operator delete[](void* p, size_t) noexcept { free(p); }
+
+// ---------------------------------------------------------------------------
+// Pipeline parameters (mirror USER CONFIG in Friction-Tester.ino)
+// ---------------------------------------------------------------------------
+static const float NORMAL_FORCE_LB = 2.59f;
+static const float TRIM_FRACTION   = 0.25f / 3.0f;   // SEG_TRIM_IN / SEG_MEASURE_IN
+
+// Relative tolerance on recorded results (operation reordering, not algorithm
+// changes)
+static const double REL_TOL = 1e-4;
+static const double ABS_TOL = 1e-6;
+
+// ---------------------------------------------------------------------------
+// Stages and budgets
+// ---------------------------------------------------------------------------
+enum Stage {
+  STAGE_COF_PERCENTILE,
+  STAGE_COF_STDDEV,
+  STAGE_AVG_PERCENTILE,
+  STAGE_AVG_STDDEV,
+  STAGE_CSV_DUMP,
+  STAGE_RESULT_PLOT,
+  STAGE_COUNTS_TO_POUNDS,
+  STAGE_COUNT
+};
+
+struct Budget {
+  const char* name;
+  double      usPer1000Pairs;
+};
+
+// About 2-3x the medians measured when the gate was added; raise deliberately.
+static const Budget BUDGETS[STAGE_COUNT] = {
+  { "calculateCOF/percentile", 300.0 },
+  { "calculateCOF/stddev",      60.0 },
+  { "avgPercentileBand",       300.0 },
+  { "avgWithinOneStdDev",       30.0 },
+  { "dumpPairedDataCSV",      3000.0 },
+  { "decimate+histogram",       50.0 },
+  { "countsToPounds",            5.0 },
+};
+
+struct Golden {
+  std::string file;
+  std::string strategy;
+  double      cof;
+  double      avgForceLb;
+  double      avgBias;
+  long        pairedCount;
+};
+
+static bool loadExpected(const std::string& path, std::vector<Golden>& out) {
+  FILE* f = fopen(path.c_str(), "r");
+  if (!f) return false;
+  char line[512];
+  while (fgets(line, sizeof(line), f)) {
+    if (line[0] == '#' || !strncmp(line, "file,", 5)) continue;
+    char file[256], strategy[64];
+    Golden g;
+    if (sscanf(line, "%255[^,],%63[^,],%lf,%lf,%lf,%ld", file, strategy,
+               &g.cof, &g.avgForceLb, &g.avgBias, &g.pairedCount) == 6) {
+      g.file = file;
+      g.strategy = strategy;
+      out.push_back(g);
+    }
+  }
+  fclose(f);
+  return true;
+}
+
+static AveragingFn strategyFn(const std::string& name) {
+  if (name == "percentile") return avgPercentileBand;
+  if (name == "stddev")     return avgWithinOneStdDev;
+  return nullptr;
+}
+
+static bool withinTol(double got, double want) {
+  return fabs(got - want) <= ABS_TOL + REL_TOL * fabs(want);
+}
+
+// Median wall time of fn over enough repetitions to fill ~20 ms
+template <class Fn>
+static double medianUs(Fn fn) {
+  using Clock = std::chrono::steady_clock;
+  std::vector<double> t;
+  t.reserve(2000);
+  auto deadline = Clock::now() + std::chrono::milliseconds(20);
+  do {
+    auto t0 = Clock::now();
+    fn();
+    t.push_back(std::chrono::duration<double, std::micro>(Clock::now() - t0).count());
+  } while ((Clock::now() < deadline || t.size() < 5) && t.size() < 2000);
+  std::nth_element(t.begin(), t.begin() + t.size() / 2, t.end());
+  return t[t.size() / 2];
+}
+
+// Counts heap calls made by one invocation of fn
+template <class Fn>
+static long allocsDuring(Fn fn) {
+  s_allocs = 0;
+  s_armed = true;
+  fn();
+  s_armed = false;
+  return s_allocs;
+}
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    fprintf(stderr, "usage: %s GOLDEN_DIR [--update]\n", argv[0]);
+    return 2;
+  }
+  std::string dir = argv[1];
+  bool update = (argc > 2 && !strcmp(argv[2], "--update"));
+
+  double scale = 1.0;
+  if (const char* s = getenv("PERF_BUDGET_SCALE")) scale = atof(s) > 0 ? atof(s) : 1.0;
+
+  std::vector<Golden> golden;
+  if (!loadExpected(dir + "/expected.csv", golden) || golden.empty()) {
+    fprintf(stderr, "cannot read %s/expected.csv\n", dir.c_str());
+    return 2;
+  }
+
+  Serial.mute(true);  // dumpPairedDataCSV: measure formatting, not the terminal
+  int failures = 0;
+  std::vector<float> paired;
+  paired.reserve(COF_MAX_SAMPLES);
+
+  for (Golden& g : golden) {
+    TraceReplay trace;
+    std::string path = dir + "/" + g.file;
+    if (!trace.load(path.c_str())) {
+      printf("FAIL %s: cannot load\n", g.file.c_str());
+      failures++;
+      continue;
+    }
+    AveragingFn avgFn = strategyFn(g.strategy);
+    if (!avgFn) {
+      printf("FAIL %s: unknown strategy %s\n", g.file.c_str(), g.strategy.c_str());
+      failures++;
+      continue;
+    }
+
+    const float* fwd = trace.fwd().data();
+    const float* rev = trace.rev().data();
+    long nf = (long)trace.fwd().size();
+    long nr = (long)trace.rev().size();
+
+    // --- Numeric equivalence ---------------------------------------------
+    CofResult r;
+    long allocs = allocsDuring([&] {
+      r = calculateCOF(fwd, nf, rev, nr, NORMAL_FORCE_LB, TRIM_FRACTION, avgFn);
+    });
+
+    if (update) {
+      g.cof = r.cof;
+      g.avgForceLb = r.avgForceLb;
+      g.avgBias = r.avgBias;
+      g.pairedCount = r.pairedCount;
+    } else if (!withinTol(r.cof, g.cof) || !withinTol(r.avgForceLb, g.avgForceLb) ||
+               !withinTol(r.avgBias, g.avgBias) || r.pairedCount != g.pairedCount) {
+      printf("FAIL %s/%s: cof %.6f (want %.6f) force %.6f (want %.6f) "
+             "bias %.6f (want %.6f) pairs %ld (want %ld)\n",
+             g.file.c_str(), g.strategy.c_str(), r.cof, g.cof,
+             r.avgForceLb, g.avgForceLb, r.avgBias, g.avgBias,
+             r.pairedCount, g.pairedCount);
+      failures++;
+    }
+
+    // --- Trim & pairing ----------------------------------------------------
+    // The firmware's own trim and the paired values calculateCOF just built,
+    // copied out before the timing loops below overwrite them
+    long fwdStart = 0, revStart = 0, pairs = 0;
+    bool trimmed = computeTrimParams(nf, nr, TRIM_FRACTION, &fwdStart, &revStart, &pairs);
+    long lastCount = 0;
+    const float* last = cofLastPaired(&lastCount);
+    paired.assign(last, last + lastCount);
+    if (!update && (!trimmed || pairs != g.pairedCount || lastCount != g.pairedCount)) {
+      printf("FAIL %s/%s: computeTrimParams %ld pairs, cofLastPaired %ld (want %ld)\n",
+             g.file.c_str(), g.strategy.c_str(), trimmed ? pairs : 0L, lastCount,
+             g.pairedCount);
+      failures++;
+    }
+    pairs = lastCount;
+
+    // --- Stage timings and allocations -----------------------------------
+    Stage cofStage = (avgFn == avgPercentileBand) ? STAGE_COF_PERCENTILE : STAGE_COF_STDDEV;
+    Stage avgStage = (avgFn == avgPercentileBand) ? STAGE_AVG_PERCENTILE : STAGE_AVG_STDDEV;
+
+    struct { Stage stage; double us; long allocs; } rows[5];
+    int nrows = 0;
+    rows[nrows++] = { cofStage, medianUs([&] {
+        calculateCOF(fwd, nf, rev, nr, NORMAL_FORCE_LB, TRIM_FRACTION, avgFn);
+      }), allocs };
+    rows[nrows++] = { avgStage, medianUs([&] { avgFn(paired.data(), pairs); }),
+                      allocsDuring([&] { avgFn(paired.data(), pairs); }) };
+    if (avgFn == avgPercentileBand) {
+      auto dump = [&] { dumpPairedDataCSV(fwd, nf, rev, nr, TRIM_FRACTION); };
+      rows[nrows++] = { STAGE_CSV_DUMP, medianUs(dump), allocsDuring(dump) };
+
+      // Results screen plots: 128-column sparkline and 32-bin histogram
+      auto plot = [&] {
+        static float colMin[128], colMax[128];
+        static uint16_t bins[32];
+        decimateMinMax(paired.data(), pairs, 128, colMin, colMax);
+        float lo = colMin[0], hi = colMax[0];
+        for (int c = 1; c < 128; c++) {
+          lo = std::min(lo, colMin[c]);
+          hi = std::max(hi, colMax[c]);
+        }
+        histogramBins(paired.data(), pairs, lo, hi, bins, 32);
+      };
+      rows[nrows++] = { STAGE_RESULT_PLOT, medianUs(plot), allocsDuring(plot) };
+
+      // Both passes as raw readings (the simulated rig's scale), converted
+      // back as runTest() does; the round trip must reproduce the trace
+      static const float COUNTS_PER_LB = 1000.0f;
+      static const long  TARE_RAW = 8000;
+      static std::vector<float> rawFwd, rawRev, work;
+      rawFwd.resize(nf);
+      rawRev.resize(nr);
+      work.resize(std::max(nf, nr));
+      for (long i = 0; i < nf; i++) rawFwd[i] = lroundf(TARE_RAW + fwd[i] * COUNTS_PER_LB);
+      for (long i = 0; i < nr; i++) rawRev[i] = lroundf(TARE_RAW + rev[i] * COUNTS_PER_LB);
+      auto convert = [&] {
+        std::copy(rawFwd.begin(), rawFwd.end(), work.begin());
+        countsToPounds(work.data(), nf, TARE_RAW, 1.0f / COUNTS_PER_LB, 0.0f);
+        std::copy(rawRev.begin(), rawRev.end(), work.begin());
+        countsToPounds(work.data(), nr, TARE_RAW, 1.0f / COUNTS_PER_LB, 0.0f);
+      };
+      rows[nrows++] = { STAGE_COUNTS_TO_POUNDS, medianUs(convert), allocsDuring(convert) };
+      float worst = 0.0f;
+      for (long i = 0; i < nr; i++) worst = std::max(worst, fabsf(work[i] - rev[i]));
+      if (worst > 0.5f / COUNTS_PER_LB + 1e-5f) {
+        printf("FAIL %s: countsToPounds off by %.6f lb\n", g.file.c_str(), worst);
+        failures++;
+      }
+    }
+
+    for (int i = 0; i < nrows; i++) {
+      const Budget& b = BUDGETS[rows[i].stage];
+      double per1000 = rows[i].us * 1000.0 / (double)(pairs > 0 ? pairs : 1);
+      double limit = b.usPer1000Pairs * scale;
+      bool slow = per1000 > limit;
+      bool heap = rows[i].allocs != 0;
+      printf("%-4s %-26s %-24s %6ld pairs %9.2f us  %8.2f us/1k (budget %.0f)  allocs %ld\n",
+             (slow || heap) ? "FAIL" : "ok", g.file.c_str(), b.name, pairs,
+             rows[i].us, per1000, limit, rows[i].allocs);
+      if (slow || heap) failures++;
+    }
+  }
+
+  if (update) {
+    FILE* f = fopen((dir + "/expected.csv").c_str(), "w");
+    if (!f) {
+      fprintf(stderr, "cannot write %s/expected.csv\n", dir.c_str());
+      return 2;
+    }
+    fprintf(f, "# Regenerate with: perf_gate <this dir> --update\n");
+    fprintf(f, "file,strategy,cof,avg_force_lb,avg_bias,paired_count\n");
+    for (const Golden& g : golden) {
+      fprintf(f, "%s,%s,%.7g,%.7g,%.7g,%ld\n", g.file.c_str(), g.strategy.c_str(),
+              g.cof, g.avgForceLb, g.avgBias, g.pairedCount);
+    }
+    fclose(f);
+    printf("expected.csv updated (%zu entries)\n", golden.size());
+  }
+
+  printf("%d failure(s)\n", failures);
+  return failures ? 1 : 0;
+}
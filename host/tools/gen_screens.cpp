@@ -0,0 +1,223 @@
+// ---------------------------------------------------------------------------
+// Static screen pre-renderer
+// ---------------------------------------------------------------------------
+// Draws the sketch's fixed screens (idle, phase headers, NFC outcomes,
+// aborts) once with the simulated SSD1306, which renders the same GLCD
+// font onto the same page-major layout as Adafruit_GFX, and writes them as
+// PROGMEM bitmaps to StaticScreens.h. The sketch then shows a screen with
+// one memcpy_P plus its dynamic fields.
+//
+// The screen table below is the source of truth: edit it, then
+//
+//   gen_screens ../StaticScreens.h          regenerate
+//   gen_screens --check ../StaticScreens.h  exit 1 if the file is stale
+//
+// --check runs as a ctest so a table edit without regenerating fails.
+
+#include "SimDisplay.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+
+// SimDisplay::display() charges the simulated bus; nothing to charge here
+void hostI2cTransfer(uint32_t, uint32_t, uint32_t) {}
+
+static const int COLS  = SimDisplay::WIDTH;
+static const int PAGES = SimDisplay::HEIGHT / 8;
+
+// Same layout as oledHeader() in the sketch
+static void header(SimDisplay& d, const char* line1) {
+  d.setTextSize(1);
+  d.setTextColor(SSD1306_WHITE);
+  d.setCursor(0, 0);
+  d.println(line1);
+  d.drawLine(0, 10, COLS, 10, SSD1306_WHITE);
+  d.setCursor(0, 14);
+}
+
+struct ScreenDef {
+  const char* name;
+  const char* note;
+  void (*draw)(SimDisplay& d);
+};
+
+static const ScreenDef SCREENS[] = {
+  { "IDLE", "idle; 'Last test' line drawn on top", [](SimDisplay& d) {
+      // "Paddle COF" = 10 chars * 12px = 120px @ size 2; center in 128px
+      d.setTextColor(SSD1306_WHITE);
+      d.setTextSize(2);
+      d.setCursor(4, 12);
+      d.print(F("Paddle COF"));
+      d.setTextSize(1);
+      d.setCursor(1, 36);
+      d.print(F("press button to test paddle"));
+  } },
+  { "HOMING",        "test start", [](SimDisplay& d) { header(d, "Homing..."); } },
+  { "LOWERING",      "lower phase", [](SimDisplay& d) {
+      header(d, "Running (forward)...");
+      d.println(F("Lowering..."));
+  } },
+  { "MEASURING_FWD", "forward pass", [](SimDisplay& d) { header(d, "Measuring (FWD)..."); } },
+  { "MEASURING_REV", "reverse pass", [](SimDisplay& d) { header(d, "Measuring (REV)..."); } },
+  { "RETURNING",     "return phase", [](SimDisplay& d) { header(d, "Returning..."); } },
+  { "ABORT_HOMING",  "abort, forced home", [](SimDisplay& d) {
+      header(d, "ABORTED");
+      d.println(F("Homing..."));
+  } },
+  { "ABORT_DONE",    "abort, back home", [](SimDisplay& d) {
+      header(d, "ABORTED");
+      d.println(F("Test cancelled"));
+  } },
+  { "RESULTS", "result + NFC prompt; COF value drawn at (0,28) size 2", [](SimDisplay& d) {
+      d.setTextSize(1);
+      d.setTextColor(SSD1306_WHITE);
+      d.setCursor(0, 8);
+      d.println("COF");
+      d.setCursor(0, 18);
+      d.println("----------");
+      d.setCursor(75, 20);
+      d.println("Present");
+      d.setCursor(80, 30);
+      d.println("NFC");
+      d.setCursor(0, 56);
+      d.println("hold button to skip");
+  } },
+  { "NFC_SUCCESS", "tag written", [](SimDisplay& d) {
+      d.setTextSize(2);
+      d.setTextColor(SSD1306_WHITE);
+      d.setCursor(20, 24);
+      d.println("Success!");
+  } },
+  { "NFC_RETRY", "retry; attempts line drawn at (15,35)", [](SimDisplay& d) {
+      d.setTextSize(1);
+      d.setTextColor(SSD1306_WHITE);
+      d.setCursor(30, 20);
+      d.println("Try again");
+  } },
+  { "NFC_FAILED", "tag wait timed out", [](SimDisplay& d) {
+      d.setTextSize(1);
+      d.setTextColor(SSD1306_WHITE);
+      d.setCursor(15, 20);
+      d.println("Write failed");
+      d.setCursor(10, 35);
+      d.println("Continuing...");
+  } },
+  { "NFC_SKIPPED", "operator skipped the tag", [](SimDisplay& d) {
+      d.setTextSize(1);
+      d.setTextColor(SSD1306_WHITE);
+      d.setCursor(36, 24);
+      d.println("Skipped");
+  } },
+  { "NFC_TAG_FULL", "tag has no room", [](SimDisplay& d) {
+      d.setTextSize(1);
+      d.setTextColor(SSD1306_WHITE);
+      d.setCursor(15, 16);
+      d.println("Tag is full!");
+      d.setCursor(10, 32);
+      d.println("Use a new tag");
+  } },
+};
+
+static void appendf(std::string& out, const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+static void appendf(std::string& out, const char* fmt, ...) {
+  char buf[256];
+  va_list ap;
+  va_start(ap, fmt);
+  vsnprintf(buf, sizeof(buf), fmt, ap);
+  va_end(ap);
+  out += buf;
+}
+
+// Only the pages between the first and last lit ones are stored
+static std::string render() {
+  std::string out;
+  out += "// Generated by host/tools/gen_screens.cpp - do not edit.\n";
+  out += "// Pre-rendered static screens: page-major SSD1306 bitmaps, blank pages\n";
+  out += "// outside page0..page0+pages-1 not stored. Shown by oledScreen().\n\n";
+  out += "#ifndef STATIC_SCREENS_H\n#define STATIC_SCREENS_H\n\n#include <Arduino.h>\n\n";
+  out += "struct StaticScreen {\n";
+  out += "  uint8_t        page0;  // first stored page\n";
+  out += "  uint8_t        pages;  // stored pages\n";
+  out += "  const uint8_t* data;   // pages * 128 bytes, PROGMEM\n";
+  out += "};\n";
+
+  size_t total = 0;
+  for (const ScreenDef& s : SCREENS) {
+    SimDisplay d;
+    d.clearDisplay();
+    s.draw(d);
+    const uint8_t* buf = d.getBuffer();
+
+    int first = PAGES, last = -1;
+    for (int p = 0; p < PAGES; p++) {
+      for (int c = 0; c < COLS; c++) {
+        if (buf[p * COLS + c]) {
+          if (p < first) first = p;
+          last = p;
+          break;
+        }
+      }
+    }
+    if (last < 0) first = last = 0;
+    int pages = last - first + 1;
+    total += pages * COLS;
+
+    appendf(out, "\n// %s\n", s.note);
+    appendf(out, "static const uint8_t SCREEN_%s_DATA[] PROGMEM = {", s.name);
+    for (int i = 0; i < pages * COLS; i++) {
+      if (i % 16 == 0) out += "\n ";
+      appendf(out, " 0x%02X,", buf[first * COLS + i]);
+    }
+    out += "\n};\n";
+    appendf(out, "static const StaticScreen SCREEN_%s = { %d, %d, SCREEN_%s_DATA };\n",
+            s.name, first, pages, s.name);
+  }
+  appendf(out, "\n// %zu screens, %zu bytes\n", sizeof(SCREENS) / sizeof(SCREENS[0]), total);
+  out += "\n#endif // STATIC_SCREENS_H\n";
+  return out;
+}
+
+static bool readFile(const char* path, std::string& out) {
+  FILE* f = fopen(path, "rb");
+  if (!f) return false;
+  char chunk[4096];
+  size_t n;
+  while ((n = fread(chunk, 1, sizeof(chunk), f)) > 0) out.append(chunk, n);
+  fclose(f);
+  return true;
+}
+
+int main(int argc, char** argv) {
+  bool check = (argc == 3 && !strcmp(argv[1], "--check"));
+  if (argc != 2 && !check) {
+    fprintf(stderr, "usage: %s [--check] StaticScreens.h\n", argv[0]);
+    return 2;
+  }
+  const char* path = argv[argc - 1];
+  std::string text = render();
+
+  if (check) {
+    std::string have;
+    if (!readFile(path, have)) {
+      fprintf(stderr, "cannot read %s\n", path);
+      return 1;
+    }
+    if (have != text) {
+      fprintf(stderr, "%s is stale; rerun gen_screens %s\n", path, path);
+      return 1;
+    }
+    printf("%s is up to date\n", path);
+    return 0;
+  }
+
+  FILE* f = fopen(path, "wb");
+  if (!f) {
+    fprintf(stderr, "cannot write %s\n", path);
+    return 1;
+  }
+  fwrite(text.data(), 1, text.size(), f);
+  fclose(f);
+  printf("wrote %s\n", path);
+  return 0;
+}
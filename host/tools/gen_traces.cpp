@@ -0,0 +1,159 @@
+// ---------------------------------------------------------------------------
+// Synthetic force-trace generator
+// ---------------------------------------------------------------------------
+// Writes N runs in the sketch's CSV dump format, sharded into files of
+// --runs-per-file runs, plus manifest.csv with each run's seed and true COF.
+// Run i always gets seed traceGenSeed(--seed, i), so output is identical
+// for any --threads value.
+//
+//   gen_traces --runs 100000 --out traces/ --cof-range 0.1 0.6
+//              --noise-lb 0.01 --color pink --color-lb 0.02 --outlier-prob 0.001
+
+#include "TraceGen.h"
+#include <atomic>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <sys/stat.h>
+#include <thread>
+#include <vector>
+
+static void usage(const char* argv0) {
+  fprintf(stderr,
+          "usage: %s --out DIR [options]\n"
+          "  --runs N             runs to generate (default 1000)\n"
+          "  --runs-per-file N    runs per shard file (default 1000)\n"
+          "  --threads N          worker threads (default: all cores)\n"
+          "  --seed N             base seed (default 1)\n"
+          "  --out DIR            output directory (created if missing)\n"
+          "\n"
+          "  load:\n"
+          "  --cof X | --cof-range LO HI\n"
+          "  --normal-lb X  --noise-lb X  --offset-lb X  --drift-lb-min X\n"
+          "  --stick-slip-lb X  --stick-slip-in X  --surface-lb X  --settle-ms X\n"
+          "\n"
+          "  sampling artefacts:\n"
+          "  --color white|pink|brown  --color-lb X   colored noise (1 sigma)\n"
+          "  --outlier-prob P  --outlier-lb X          spikes per sample\n"
+          "  --drop-prob P                             missed conversions\n"
+          "  --jitter F                                sample-time jitter, fraction of period\n"
+          "  --pass-sec S  --sample-hz HZ  --max-samples N\n",
+          argv0);
+}
+
+struct Shard {
+  std::string manifest;   // manifest rows for this shard
+};
+
+int main(int argc, char** argv) {
+  TraceGenOptions o;
+  FrictionParams& fp = o.friction;
+  uint64_t runs = 1000;
+  uint64_t perFile = 1000;
+  unsigned threads = std::thread::hardware_concurrency();
+  uint64_t seed = 1;
+  const char* outDir = nullptr;
+
+  for (int i = 1; i < argc; i++) {
+    const char* a = argv[i];
+    bool hasArg = (i + 1 < argc);
+    if      (!strcmp(a, "--runs") && hasArg)          runs = strtoull(argv[++i], nullptr, 10);
+    else if (!strcmp(a, "--runs-per-file") && hasArg) perFile = strtoull(argv[++i], nullptr, 10);
+    else if (!strcmp(a, "--threads") && hasArg)       threads = (unsigned)atoi(argv[++i]);
+    else if (!strcmp(a, "--seed") && hasArg)          seed = strtoull(argv[++i], nullptr, 10);
+    else if (!strcmp(a, "--out") && hasArg)           outDir = argv[++i];
+    else if (!strcmp(a, "--cof") && hasArg)           o.cofLo = o.cofHi = (float)atof(argv[++i]);
+    else if (!strcmp(a, "--cof-range") && i + 2 < argc) {
+      o.cofLo = (float)atof(argv[++i]);
+      o.cofHi = (float)atof(argv[++i]);
+    }
+    else if (!strcmp(a, "--normal-lb") && hasArg)     fp.normalForceLb = (float)atof(argv[++i]);
+    else if (!strcmp(a, "--noise-lb") && hasArg)      fp.noiseLb = (float)atof(argv[++i]);
+    else if (!strcmp(a, "--offset-lb") && hasArg)     fp.offsetLb = (float)atof(argv[++i]);
+    else if (!strcmp(a, "--drift-lb-min") && hasArg)  fp.driftLbPerMin = (float)atof(argv[++i]);
+    else if (!strcmp(a, "--stick-slip-lb") && hasArg) fp.stickSlipLb = (float)atof(argv[++i]);
+    else if (!strcmp(a, "--stick-slip-in") && hasArg) fp.stickSlipPeriodIn = (float)atof(argv[++i]);
+    else if (!strcmp(a, "--surface-lb") && hasArg)    fp.surfaceLb = (float)atof(argv[++i]);
+    else if (!strcmp(a, "--settle-ms") && hasArg)     fp.settleMs = (float)atof(argv[++i]);
+    else if (!strcmp(a, "--color") && hasArg) {
+      const char* c = argv[++i];
+      if      (!strcmp(c, "white")) o.color = NOISE_WHITE;
+      else if (!strcmp(c, "pink"))  o.color = NOISE_PINK;
+      else if (!strcmp(c, "brown")) o.color = NOISE_BROWN;
+      else { usage(argv[0]); return 2; }
+    }
+    else if (!strcmp(a, "--color-lb") && hasArg)      o.colorLb = (float)atof(argv[++i]);
+    else if (!strcmp(a, "--outlier-prob") && hasArg)  o.outlierProb = (float)atof(argv[++i]);
+    else if (!strcmp(a, "--outlier-lb") && hasArg)    o.outlierLb = (float)atof(argv[++i]);
+    else if (!strcmp(a, "--drop-prob") && hasArg)     o.dropProb = (float)atof(argv[++i]);
+    else if (!strcmp(a, "--jitter") && hasArg)        o.jitterFrac = (float)atof(argv[++i]);
+    else if (!strcmp(a, "--pass-sec") && hasArg)      o.passSec = (float)atof(argv[++i]);
+    else if (!strcmp(a, "--sample-hz") && hasArg)     o.sampleHz = (float)atof(argv[++i]);
+    else if (!strcmp(a, "--max-samples") && hasArg)   o.maxSamples = atol(argv[++i]);
+    else { usage(argv[0]); return 2; }
+  }
+  if (!outDir || perFile == 0) { usage(argv[0]); return 2; }
+  if (threads == 0) threads = 1;
+
+  mkdir(outDir, 0755);
+
+  uint64_t shardCount = (runs + perFile - 1) / perFile;
+  std::vector<Shard> shards(shardCount);
+  std::atomic<uint64_t> nextShard(0);
+  std::atomic<bool> failed(false);
+
+  auto worker = [&]() {
+    GeneratedRun run;
+    std::string text;
+    char path[4096];
+    char row[160];
+    for (uint64_t s; (s = nextShard.fetch_add(1)) < shardCount && !failed; ) {
+      uint64_t first = s * perFile;
+      uint64_t last  = (first + perFile < runs) ? first + perFile : runs;
+      snprintf(path, sizeof(path), "%s/traces_%06llu.csv", outDir, (unsigned long long)s);
+
+      FILE* f = fopen(path, "wb");
+      if (!f) {
+        fprintf(stderr, "cannot write %s\n", path);
+        failed = true;
+        break;
+      }
+      for (uint64_t r = first; r < last; r++) {
+        generateRun(o, traceGenSeed(seed, r), run);
+        text.clear();
+        appendRunCsv(run, r, text);
+        if (fwrite(text.data(), 1, text.size(), f) != text.size()) {
+          fprintf(stderr, "write error on %s\n", path);
+          failed = true;
+          break;
+        }
+        snprintf(row, sizeof(row), "%llu,%llu,%.6f,%zu,%zu,traces_%06llu.csv\n",
+                 (unsigned long long)r, (unsigned long long)run.seed, run.trueCof,
+                 run.fwd.size(), run.rev.size(), (unsigned long long)s);
+        shards[s].manifest.append(row);
+      }
+      fclose(f);
+    }
+  };
+
+  std::vector<std::thread> pool;
+  for (unsigned t = 0; t < threads; t++) pool.emplace_back(worker);
+  for (std::thread& t : pool) t.join();
+  if (failed) return 1;
+
+  char path[4096];
+  snprintf(path, sizeof(path), "%s/manifest.csv", outDir);
+  FILE* m = fopen(path, "w");
+  if (!m) {
+    fprintf(stderr, "cannot write %s\n", path);
+    return 1;
+  }
+  fprintf(m, "run,seed,true_cof,fwd_samples,rev_samples,file\n");
+  for (const Shard& s : shards) fwrite(s.manifest.data(), 1, s.manifest.size(), m);
+  fclose(m);
+
+  fprintf(stderr, "%llu runs in %llu files -> %s\n", (unsigned long long)runs,
+          (unsigned long long)shardCount, outDir);
+  return 0;
+}
@@ -0,0 +1,115 @@
+// ---------------------------------------------------------------------------
+// Trace dump -> Chrome / Perfetto trace JSON
+// ---------------------------------------------------------------------------
+// Input is a serial capture (or friction_sim --dump-trace file) containing a
+// ---TRACE_START--- ... ---TRACE_END--- block written by traceDump(). Output
+// loads in chrome://tracing or ui.perfetto.dev; each core is one thread.
+//
+//   trace_to_chrome capture.bin > trace.json
+
+#include "Trace.h"
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+// MotionPhase values from Friction-Tester.ino
+static const char* const PHASE_NAMES[] = {
+  "NONE", "LOWERING", "MEASURING_FWD", "MEASURING_REV", "RETURNING", "HOMING"
+};
+
+static bool readFile(const char* path, std::string& out) {
+  FILE* f = fopen(path, "rb");
+  if (!f) return false;
+  char buf[65536];
+  size_t n;
+  while ((n = fread(buf, 1, sizeof(buf), f)) > 0) out.append(buf, n);
+  fclose(f);
+  return true;
+}
+
+int main(int argc, char** argv) {
+  if (argc != 2) {
+    fprintf(stderr, "usage: %s CAPTURE > trace.json\n", argv[0]);
+    return 2;
+  }
+
+  std::string data;
+  if (!readFile(argv[1], data)) {
+    fprintf(stderr, "cannot read %s\n", argv[1]);
+    return 1;
+  }
+
+  // Last dump in the capture wins
+  const std::string marker = "---TRACE_START---";
+  size_t pos = data.rfind(marker);
+  if (pos == std::string::npos) {
+    fprintf(stderr, "no %s block found\n", marker.c_str());
+    return 1;
+  }
+  pos += marker.size();
+  if (pos < data.size() && data[pos] == '\r') pos++;
+  if (pos < data.size() && data[pos] == '\n') pos++;
+
+  TraceHeader h;
+  if (data.size() - pos < sizeof(h)) {
+    fprintf(stderr, "truncated trace header\n");
+    return 1;
+  }
+  memcpy(&h, data.data() + pos, sizeof(h));
+  pos += sizeof(h);
+  if (h.magic != TRACE_MAGIC || h.version != TRACE_VERSION ||
+      h.eventSize != sizeof(TraceEvent)) {
+    fprintf(stderr, "bad trace header (magic %08lX, version %u, event size %u)\n",
+            (unsigned long)h.magic, h.version, h.eventSize);
+    return 1;
+  }
+  if (data.size() - pos < (size_t)h.count * sizeof(TraceEvent)) {
+    fprintf(stderr, "truncated trace: header says %lu events\n", (unsigned long)h.count);
+    return 1;
+  }
+
+  std::vector<TraceEvent> events(h.count);
+  if (h.count > 0) memcpy(events.data(), data.data() + pos, h.count * sizeof(TraceEvent));
+
+  printf("{\"displayTimeUnit\":\"ms\",\"otherData\":{\"dropped\":%lu},\"traceEvents\":[\n",
+         (unsigned long)h.dropped);
+  printf("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":0,\"args\":{\"name\":\"Core 0\"}},\n");
+  printf("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":1,\"args\":{\"name\":\"Core 1\"}}");
+
+  // Unwrap the 32-bit µs clock (wraps every ~71 minutes)
+  uint64_t epoch = 0;
+  uint32_t last  = events.empty() ? 0 : events[0].tsUs;
+  uint64_t first = last;
+
+  for (const TraceEvent& e : events) {
+    if (e.tsUs < last && last - e.tsUs > 0x80000000UL) epoch += 0x100000000ULL;
+    last = e.tsUs;
+    uint64_t ts = epoch + e.tsUs - first;
+
+    const char* name = traceName(e.id);
+    printf(",\n{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%llu,\"pid\":0,\"tid\":%u",
+           name, (char)e.type, (unsigned long long)ts, (unsigned)e.core);
+
+    switch (e.type) {
+      case TRACE_COUNTER_EVT:
+        printf(",\"args\":{\"%s\":%ld}}", name, (long)e.arg);
+        break;
+      case TRACE_INSTANT_EVT:
+        if (e.id == TR_PHASE && e.arg >= 0 &&
+            e.arg < (int32_t)(sizeof(PHASE_NAMES) / sizeof(PHASE_NAMES[0]))) {
+          printf(",\"s\":\"g\",\"args\":{\"phase\":\"%s\"}}", PHASE_NAMES[e.arg]);
+        } else {
+          printf(",\"s\":\"t\",\"args\":{\"arg\":%ld}}", (long)e.arg);
+        }
+        break;
+      default:
+        printf(",\"args\":{\"arg\":%ld}}", (long)e.arg);
+        break;
+    }
+  }
+  printf("\n]}\n");
+
+  fprintf(stderr, "%lu events (%lu dropped)\n", (unsigned long)h.count,
+          (unsigned long)h.dropped);
+  return 0;
+}